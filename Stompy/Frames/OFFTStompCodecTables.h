@@ -0,0 +1,68 @@
+//
+//  OFFTStompCodecTables.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OFFTStompFrame.h"
+
+// Standard frame headers
+extern NSString * const OFFTStompHeaderAcceptVersion;
+extern NSString * const OFFTStompHeaderVersion;
+extern NSString * const OFFTStompHeaderHost;
+extern NSString * const OFFTStompHeaderHeartBeat;
+extern NSString * const OFFTStompHeaderReceipt;
+extern NSString * const OFFTStompHeaderReceiptID;
+extern NSString * const OFFTStompHeaderDestination;
+extern NSString * const OFFTStompHeaderContentLength;
+extern NSString * const OFFTStompHeaderContentType;
+extern NSString * const OFFTStompHeaderSubscription;
+extern NSString * const OFFTStompHeaderMessageID;
+extern NSString * const OFFTStompHeaderAck;
+extern NSString * const OFFTStompHeaderID;
+extern NSString * const OFFTStompHeaderTransaction;
+
+/**
+ *  Looks up the command named by the raw bytes of a command line.
+ *
+ *  @return The command, or OFFTStompFrameCommandUnknown.
+ */
+extern OFFTStompFrameCommand OFFTStompCommandFromBytes(const uint8_t *bytes, NSUInteger length);
+
+/**
+ *  The UTF-8 encoded name of a command.
+ *
+ *  @param length On return, the length of the name in bytes. May be NULL.
+ *
+ *  @return The name, or NULL for OFFTStompFrameCommandUnknown.
+ */
+extern const char *OFFTStompCommandName(OFFTStompFrameCommand command, NSUInteger *length);
+
+/**
+ *  Looks up the well-known header named by the raw bytes of a header name.
+ *
+ *  @return The header, or OFFTStompHeaderNameUnknown.
+ */
+extern OFFTStompHeaderName OFFTStompHeaderNameFromBytes(const uint8_t *bytes, NSUInteger length);
+
+/**
+ *  Looks up the well-known header with the given name.
+ *
+ *  @return The header, or OFFTStompHeaderNameUnknown.
+ */
+extern OFFTStompHeaderName OFFTStompHeaderNameFromString(NSString *header);
+
+/**
+ *  The interned string for a well-known header. The same instance is returned on every call.
+ */
+extern NSString *OFFTStompHeaderNameString(OFFTStompHeaderName name);
+
+/**
+ *  The UTF-8 encoded name of a well-known header.
+ *
+ *  @param length On return, the length of the name in bytes. May be NULL.
+ */
+extern const char *OFFTStompHeaderNameBytes(OFFTStompHeaderName name, NSUInteger *length);
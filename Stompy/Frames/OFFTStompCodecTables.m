@@ -0,0 +1,217 @@
+//
+//  OFFTStompCodecTables.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompCodecTables.h"
+
+// Standard frame headers
+// These are the same instances as the interned names in OFFTStompHeaderStrings
+NSString * const OFFTStompHeaderAcceptVersion = @"accept-version";
+NSString * const OFFTStompHeaderVersion       = @"version";
+NSString * const OFFTStompHeaderHost          = @"host";
+NSString * const OFFTStompHeaderHeartBeat     = @"heart-beat";
+NSString * const OFFTStompHeaderReceipt       = @"receipt";
+NSString * const OFFTStompHeaderReceiptID     = @"receipt-id";
+NSString * const OFFTStompHeaderDestination   = @"destination";
+NSString * const OFFTStompHeaderContentLength = @"content-length";
+NSString * const OFFTStompHeaderContentType   = @"content-type";
+NSString * const OFFTStompHeaderSubscription  = @"subscription";
+NSString * const OFFTStompHeaderMessageID     = @"message-id";
+NSString * const OFFTStompHeaderAck           = @"ack";
+NSString * const OFFTStompHeaderID            = @"id";
+NSString * const OFFTStompHeaderTransaction   = @"transaction";
+
+typedef struct {
+    const char *bytes;
+    NSUInteger length;
+    NSUInteger value;
+} OFFTStompTableEntry;
+
+#define OFFTSTOMP_ENTRY(literal, value) { literal, sizeof(literal) - 1, value }
+
+#pragma mark - Commands
+
+/**
+ *  Hashes a command name into a slot of OFFTStompCommandTable.
+ *  The function is collision free for every command defined by STOMP 1.2,
+ *  the unused slots are reserved for commands this client doesn't handle yet.
+ */
+static inline NSUInteger OFFTStompCommandHash(const uint8_t *bytes, NSUInteger length) {
+    return (length * 18 + bytes[0] + bytes[length - 1]) & 31;
+}
+
+static const OFFTStompTableEntry OFFTStompCommandTable[32] = {
+    [0]  = OFFTSTOMP_ENTRY("UNSUBSCRIBE", OFFTStompFrameCommandUnsubscribe),
+    [1]  = OFFTSTOMP_ENTRY("NACK",        OFFTStompFrameCommandNack),
+    [2]  = OFFTSTOMP_ENTRY("ACK",         OFFTStompFrameCommandAck),
+    [3]  = OFFTSTOMP_ENTRY("COMMIT",      OFFTStompFrameCommandCommit),
+    [4]  = OFFTSTOMP_ENTRY("RECEIPT",     OFFTStompFrameCommandReceipt),
+    [9]  = OFFTSTOMP_ENTRY("CONNECTED",   OFFTStompFrameCommandConnected),
+    [10] = OFFTSTOMP_ENTRY("BEGIN",       OFFTStompFrameCommandBegin),
+    [12] = OFFTSTOMP_ENTRY("DISCONNECT",  OFFTStompFrameCommandDisconnect),
+    [15] = OFFTSTOMP_ENTRY("ABORT",       OFFTStompFrameCommandAbort),
+    [16] = OFFTSTOMP_ENTRY("MESSAGE",     OFFTStompFrameCommandMessage),
+    [17] = OFFTSTOMP_ENTRY("ERROR",       OFFTStompFrameCommandError),
+    [21] = OFFTSTOMP_ENTRY("CONNECT",     OFFTStompFrameCommandConnect),
+    [26] = OFFTSTOMP_ENTRY("SUBSCRIBE",   OFFTStompFrameCommandSubscribe),
+    [31] = OFFTSTOMP_ENTRY("SEND",        OFFTStompFrameCommandSend),
+};
+
+static const OFFTStompTableEntry OFFTStompCommandNames[] = {
+    [OFFTStompFrameCommandConnect]     = OFFTSTOMP_ENTRY("CONNECT",     OFFTStompFrameCommandConnect),
+    [OFFTStompFrameCommandConnected]   = OFFTSTOMP_ENTRY("CONNECTED",   OFFTStompFrameCommandConnected),
+    [OFFTStompFrameCommandDisconnect]  = OFFTSTOMP_ENTRY("DISCONNECT",  OFFTStompFrameCommandDisconnect),
+    [OFFTStompFrameCommandSend]        = OFFTSTOMP_ENTRY("SEND",        OFFTStompFrameCommandSend),
+    [OFFTStompFrameCommandSubscribe]   = OFFTSTOMP_ENTRY("SUBSCRIBE",   OFFTStompFrameCommandSubscribe),
+    [OFFTStompFrameCommandUnsubscribe] = OFFTSTOMP_ENTRY("UNSUBSCRIBE", OFFTStompFrameCommandUnsubscribe),
+    [OFFTStompFrameCommandMessage]     = OFFTSTOMP_ENTRY("MESSAGE",     OFFTStompFrameCommandMessage),
+    [OFFTStompFrameCommandError]       = OFFTSTOMP_ENTRY("ERROR",       OFFTStompFrameCommandError),
+    [OFFTStompFrameCommandReceipt]     = OFFTSTOMP_ENTRY("RECEIPT",     OFFTStompFrameCommandReceipt),
+    [OFFTStompFrameCommandAck]         = OFFTSTOMP_ENTRY("ACK",         OFFTStompFrameCommandAck),
+    [OFFTStompFrameCommandNack]        = OFFTSTOMP_ENTRY("NACK",        OFFTStompFrameCommandNack),
+    [OFFTStompFrameCommandBegin]       = OFFTSTOMP_ENTRY("BEGIN",       OFFTStompFrameCommandBegin),
+    [OFFTStompFrameCommandCommit]      = OFFTSTOMP_ENTRY("COMMIT",      OFFTStompFrameCommandCommit),
+    [OFFTStompFrameCommandAbort]       = OFFTSTOMP_ENTRY("ABORT",       OFFTStompFrameCommandAbort),
+};
+
+OFFTStompFrameCommand OFFTStompCommandFromBytes(const uint8_t *bytes, NSUInteger length) {
+    if (length == 0) {
+        return OFFTStompFrameCommandUnknown;
+    }
+
+    const OFFTStompTableEntry *entry = &OFFTStompCommandTable[OFFTStompCommandHash(bytes, length)];
+    if (entry->length == length && memcmp(entry->bytes, bytes, length) == 0) {
+        return entry->value;
+    }
+    return OFFTStompFrameCommandUnknown;
+}
+
+const char *OFFTStompCommandName(OFFTStompFrameCommand command, NSUInteger *length) {
+    const NSUInteger count = sizeof(OFFTStompCommandNames) / sizeof(OFFTStompCommandNames[0]);
+    const OFFTStompTableEntry *entry = (command < count) ? &OFFTStompCommandNames[command] : NULL;
+
+    if (length) {
+        *length = entry ? entry->length : 0;
+    }
+    return entry ? entry->bytes : NULL;
+}
+
+#pragma mark - Headers
+
+/**
+ *  Hashes a header name into a slot of OFFTStompHeaderTable.
+ *  The function is collision free for the well-known headers.
+ */
+static inline NSUInteger OFFTStompHeaderHash(const uint8_t *bytes, NSUInteger length) {
+    return (length * 2 + bytes[0] + (bytes[length - 1] << 1)) & 31;
+}
+
+static const OFFTStompTableEntry OFFTStompHeaderTable[32] = {
+    [0]  = OFFTSTOMP_ENTRY("version",        OFFTStompHeaderNameVersion),
+    [4]  = OFFTSTOMP_ENTRY("heart-beat",     OFFTStompHeaderNameHeartBeat),
+    [5]  = OFFTSTOMP_ENTRY("content-type",   OFFTStompHeaderNameContentType),
+    [6]  = OFFTSTOMP_ENTRY("transaction",    OFFTStompHeaderNameTransaction),
+    [7]  = OFFTSTOMP_ENTRY("subscription",   OFFTStompHeaderNameSubscription),
+    [8]  = OFFTSTOMP_ENTRY("receipt",        OFFTStompHeaderNameReceipt),
+    [9]  = OFFTSTOMP_ENTRY("message-id",     OFFTStompHeaderNameMessageID),
+    [14] = OFFTSTOMP_ENTRY("receipt-id",     OFFTStompHeaderNameReceiptID),
+    [15] = OFFTSTOMP_ENTRY("content-length", OFFTStompHeaderNameContentLength),
+    [21] = OFFTSTOMP_ENTRY("id",             OFFTStompHeaderNameID),
+    [22] = OFFTSTOMP_ENTRY("destination",    OFFTStompHeaderNameDestination),
+    [24] = OFFTSTOMP_ENTRY("host",           OFFTStompHeaderNameHost),
+    [25] = OFFTSTOMP_ENTRY("accept-version", OFFTStompHeaderNameAcceptVersion),
+    [29] = OFFTSTOMP_ENTRY("ack",            OFFTStompHeaderNameAck),
+};
+
+static const OFFTStompTableEntry OFFTStompHeaderNames[OFFTStompHeaderNameCount] = {
+    [OFFTStompHeaderNameAcceptVersion] = OFFTSTOMP_ENTRY("accept-version", OFFTStompHeaderNameAcceptVersion),
+    [OFFTStompHeaderNameVersion]       = OFFTSTOMP_ENTRY("version",        OFFTStompHeaderNameVersion),
+    [OFFTStompHeaderNameHost]          = OFFTSTOMP_ENTRY("host",           OFFTStompHeaderNameHost),
+    [OFFTStompHeaderNameHeartBeat]     = OFFTSTOMP_ENTRY("heart-beat",     OFFTStompHeaderNameHeartBeat),
+    [OFFTStompHeaderNameReceipt]       = OFFTSTOMP_ENTRY("receipt",        OFFTStompHeaderNameReceipt),
+    [OFFTStompHeaderNameReceiptID]     = OFFTSTOMP_ENTRY("receipt-id",     OFFTStompHeaderNameReceiptID),
+    [OFFTStompHeaderNameDestination]   = OFFTSTOMP_ENTRY("destination",    OFFTStompHeaderNameDestination),
+    [OFFTStompHeaderNameContentLength] = OFFTSTOMP_ENTRY("content-length", OFFTStompHeaderNameContentLength),
+    [OFFTStompHeaderNameContentType]   = OFFTSTOMP_ENTRY("content-type",   OFFTStompHeaderNameContentType),
+    [OFFTStompHeaderNameSubscription]  = OFFTSTOMP_ENTRY("subscription",   OFFTStompHeaderNameSubscription),
+    [OFFTStompHeaderNameMessageID]     = OFFTSTOMP_ENTRY("message-id",     OFFTStompHeaderNameMessageID),
+    [OFFTStompHeaderNameAck]           = OFFTSTOMP_ENTRY("ack",            OFFTStompHeaderNameAck),
+    [OFFTStompHeaderNameID]            = OFFTSTOMP_ENTRY("id",             OFFTStompHeaderNameID),
+    [OFFTStompHeaderNameTransaction]   = OFFTSTOMP_ENTRY("transaction",    OFFTStompHeaderNameTransaction),
+};
+
+static NSString * const OFFTStompHeaderStrings[OFFTStompHeaderNameCount] = {
+    [OFFTStompHeaderNameAcceptVersion] = @"accept-version",
+    [OFFTStompHeaderNameVersion]       = @"version",
+    [OFFTStompHeaderNameHost]          = @"host",
+    [OFFTStompHeaderNameHeartBeat]     = @"heart-beat",
+    [OFFTStompHeaderNameReceipt]       = @"receipt",
+    [OFFTStompHeaderNameReceiptID]     = @"receipt-id",
+    [OFFTStompHeaderNameDestination]   = @"destination",
+    [OFFTStompHeaderNameContentLength] = @"content-length",
+    [OFFTStompHeaderNameContentType]   = @"content-type",
+    [OFFTStompHeaderNameSubscription]  = @"subscription",
+    [OFFTStompHeaderNameMessageID]     = @"message-id",
+    [OFFTStompHeaderNameAck]           = @"ack",
+    [OFFTStompHeaderNameID]            = @"id",
+    [OFFTStompHeaderNameTransaction]   = @"transaction",
+};
+
+/**
+ *  The length of the longest well-known header name.
+ */
+static const NSUInteger OFFTStompHeaderNameMaximumLength = 14;
+
+OFFTStompHeaderName OFFTStompHeaderNameFromBytes(const uint8_t *bytes, NSUInteger length) {
+    if (length == 0) {
+        return OFFTStompHeaderNameUnknown;
+    }
+
+    const OFFTStompTableEntry *entry = &OFFTStompHeaderTable[OFFTStompHeaderHash(bytes, length)];
+    if (entry->length == length && memcmp(entry->bytes, bytes, length) == 0) {
+        return entry->value;
+    }
+    return OFFTStompHeaderNameUnknown;
+}
+
+OFFTStompHeaderName OFFTStompHeaderNameFromString(NSString *header) {
+    const NSUInteger length = header.length;
+    if (length == 0 || length > OFFTStompHeaderNameMaximumLength) {
+        return OFFTStompHeaderNameUnknown;
+    }
+
+    // Encode onto the stack rather than creating an NSData
+    uint8_t bytes[OFFTStompHeaderNameMaximumLength];
+    NSUInteger used = 0;
+    NSRange remaining = NSMakeRange(0, 0);
+    BOOL encoded = [header getBytes:bytes
+                          maxLength:sizeof(bytes)
+                         usedLength:&used
+                           encoding:NSUTF8StringEncoding
+                            options:0
+                              range:NSMakeRange(0, length)
+                     remainingRange:&remaining];
+
+    // Names that don't fit can't be well-known
+    if (encoded == NO || remaining.length > 0) {
+        return OFFTStompHeaderNameUnknown;
+    }
+    return OFFTStompHeaderNameFromBytes(bytes, used);
+}
+
+NSString *OFFTStompHeaderNameString(OFFTStompHeaderName name) {
+    return (name < OFFTStompHeaderNameCount) ? OFFTStompHeaderStrings[name] : nil;
+}
+
+const char *OFFTStompHeaderNameBytes(OFFTStompHeaderName name, NSUInteger *length) {
+    const OFFTStompTableEntry *entry = (name != OFFTStompHeaderNameUnknown && name < OFFTStompHeaderNameCount) ? &OFFTStompHeaderNames[name] : NULL;
+
+    if (length) {
+        *length = entry ? entry->length : 0;
+    }
+    return entry ? entry->bytes : NULL;
+}
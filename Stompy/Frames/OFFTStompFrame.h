@@ -20,8 +20,53 @@ typedef NS_ENUM(NSUInteger, OFFTStompFrameCommand) {
     OFFTStompFrameCommandMessage,     // in
     OFFTStompFrameCommandError,       // in
     OFFTStompFrameCommandReceipt,     // in
+    OFFTStompFrameCommandAck,         // out
+    OFFTStompFrameCommandNack,        // out
+    OFFTStompFrameCommandBegin,       // out
+    OFFTStompFrameCommandCommit,      // out
+    OFFTStompFrameCommandAbort,       // out
 };
 
+// Supported/accepted versions
+typedef NS_ENUM(NSUInteger, OFFTStompVersion) {
+    OFFTStompVersionUnknown,
+    OFFTStompVersion1_1,
+    OFFTStompVersion1_2,
+};
+
+/**
+ *  The well-known headers, as recognised by the lookup tables.
+ */
+typedef NS_ENUM(NSUInteger, OFFTStompHeaderName) {
+    OFFTStompHeaderNameUnknown,
+    OFFTStompHeaderNameAcceptVersion,
+    OFFTStompHeaderNameVersion,
+    OFFTStompHeaderNameHost,
+    OFFTStompHeaderNameHeartBeat,
+    OFFTStompHeaderNameReceipt,
+    OFFTStompHeaderNameReceiptID,
+    OFFTStompHeaderNameDestination,
+    OFFTStompHeaderNameContentLength,
+    OFFTStompHeaderNameContentType,
+    OFFTStompHeaderNameSubscription,
+    OFFTStompHeaderNameMessageID,
+    OFFTStompHeaderNameAck,
+    OFFTStompHeaderNameID,
+    OFFTStompHeaderNameTransaction,
+    OFFTStompHeaderNameCount,
+};
+
+/**
+ *  The location of a header's name and value within the frame's header bytes.
+ */
+typedef struct {
+    OFFTStompHeaderName name;   // OFFTStompHeaderNameUnknown for other headers
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t valueOffset;
+    uint32_t valueLength;
+} OFFTStompFrameHeader;
+
 @interface OFFTStompFrame : NSObject
 
 /**
@@ -34,6 +79,12 @@ typedef NS_ENUM(NSUInteger, OFFTStompFrameCommand) {
  */
 - (instancetype)initWithCommand:(OFFTStompFrameCommand)command NS_DESIGNATED_INITIALIZER;
 
+/**
+ * Returns the frame to the state of a newly initialised frame for the specified command,
+ * keeping any storage it has allocated so it can be reused.
+ */
+- (void)resetWithCommand:(OFFTStompFrameCommand)command;
+
 /**
  * Retrieves the command.
  */
@@ -50,7 +101,20 @@ typedef NS_ENUM(NSUInteger, OFFTStompFrameCommand) {
 - (NSString *)valueForHeader:(NSString *)header;
 
 /**
- * Retrieves all headers
+ * Retrieves the value of a well-known header, or nil if the header does not exist.
+ */
+- (NSString *)valueForHeaderName:(OFFTStompHeaderName)name;
+
+/**
+ * Parses the value of a well-known header as an unsigned decimal integer,
+ * directly from the header bytes rather than decoding it into a string.
+ * Returns NO if the header does not exist or its value is not such a number.
+ */
+- (BOOL)getUnsignedIntegerValue:(uint64_t *)value forHeaderName:(OFFTStompHeaderName)name;
+
+/**
+ * Retrieves all headers.
+ * Where a header is repeated only its first value is included.
  */
 - (NSDictionary *)allHeaders;
 
@@ -64,4 +128,60 @@ typedef NS_ENUM(NSUInteger, OFFTStompFrameCommand) {
  */
 - (NSData *)body;
 
+#pragma mark - Raw Headers
+
+/**
+ * Sets the headers of a received frame.
+ * The frame references the received bytes rather than copying them.
+ *
+ * @param headers The headers, in the order they were received.
+ * @param count   The number of headers.
+ * @param bytes   The received bytes.
+ * @param offset  The position within bytes that header offsets are relative to.
+ * @param escaped Whether header names and values are escaped.
+ * @param version The protocol version used to escape them.
+ */
+- (void)setReceivedHeaders:(const OFFTStompFrameHeader *)headers
+                     count:(NSUInteger)count
+                     bytes:(NSData *)bytes
+                    offset:(NSUInteger)offset
+                   escaped:(BOOL)escaped
+                   version:(OFFTStompVersion)version;
+
+/**
+ * The number of headers, including repeated headers.
+ */
+- (NSUInteger)headerCount;
+
+/**
+ * The headers, in order.
+ */
+- (const OFFTStompFrameHeader *)rawHeaders;
+
+/**
+ * The bytes that header offsets are relative to.
+ */
+- (const uint8_t *)rawHeaderBytes;
+
+/**
+ * The object owning the raw header bytes, which must be kept alive while they are used.
+ * Immutable, so it may be retained without copying.
+ */
+- (NSData *)rawHeaderData;
+
+/**
+ * The position within the raw header data that header offsets are relative to.
+ */
+- (NSUInteger)rawHeaderOffset;
+
+/**
+ * Whether the raw header bytes are escaped.
+ */
+- (BOOL)rawHeadersEscaped;
+
+/**
+ * The protocol version used to escape the raw header bytes.
+ */
+- (OFFTStompVersion)rawHeadersVersion;
+
 @end
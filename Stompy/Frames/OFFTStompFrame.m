@@ -7,13 +7,48 @@
 //
 
 #import "OFFTStompFrame.h"
+#import "OFFTStompCodecTables.h"
+#import "OFFTStompHeaderEncoding.h"
+
+/**
+ *  Most frames have fewer headers than this,
+ *  which are then stored without a separate allocation.
+ */
+#define OFFTStompFrameInlineHeaderCapacity 12
+
+@interface OFFTStompFrame () {
+    OFFTStompFrameHeader _inlineHeaders[OFFTStompFrameInlineHeaderCapacity];
+
+    // Either _inlineHeaders or a heap allocation once there are too many headers
+    OFFTStompFrameHeader *_headers;
+    NSUInteger _headerCount;
+    NSUInteger _headerCapacity;
+}
 
-@interface OFFTStompFrame ()
 @property (nonatomic, assign) OFFTStompFrameCommand command;
-@property (nonatomic, strong) NSMutableDictionary *headers;
 
 @property (nonatomic, assign) BOOL mayHaveBody;
-@property (nonatomic, copy) NSData *body;
+@property (nonatomic, strong) NSData *body;
+
+/**
+ *  The bytes that header offsets refer to, either those
+ *  received from the transport or the frame's own header storage.
+ */
+@property (nonatomic, strong) NSData *headerBytes;
+@property (nonatomic, assign) NSUInteger headerBytesOffset;
+
+/**
+ *  The UTF-8 names and values of headers set on this frame.
+ */
+@property (nonatomic, strong) NSMutableData *headerStorage;
+
+@property (nonatomic, assign) BOOL headersEscaped;
+@property (nonatomic, assign) OFFTStompVersion headersVersion;
+
+/**
+ *  Built on demand by allHeaders.
+ */
+@property (nonatomic, copy) NSDictionary *headerDictionary;
 
 @end
 
@@ -22,54 +57,278 @@
 - (instancetype)initWithCommand:(OFFTStompFrameCommand)command {
     self = [super init];
     if (self) {
-        _command = command;
-        
-        // Only the SEND, MESSAGE, and ERROR frames can have a body. All other frames MUST NOT have a body.
-        // https://stomp.github.io/stomp-specification-1.2.html#Body
-        // https://stomp.github.io/stomp-specification-1.1.html#Value_Encoding
-        switch (_command) {
-            case OFFTStompFrameCommandSend:
-            case OFFTStompFrameCommandMessage:
-            case OFFTStompFrameCommandError:
-                _mayHaveBody = YES;
-                break;
-            default:
-                _mayHaveBody = NO;
-                break;
-        }
+        _headers = _inlineHeaders;
+        _headerCapacity = OFFTStompFrameInlineHeaderCapacity;
+        [self resetWithCommand:command];
     }
     return self;
 }
 
-#pragma mark - Lazy Instantiation
-
-- (NSMutableDictionary *)headers {
-    if (_headers == nil) {
-        _headers = [[NSMutableDictionary alloc] init];
+- (void)dealloc {
+    if (_headers != _inlineHeaders) {
+        free(_headers);
     }
-    return _headers;
 }
 
 #pragma mark - Public
 
+- (void)resetWithCommand:(OFFTStompFrameCommand)command {
+    _command = command;
+
+    // Only the SEND, MESSAGE, and ERROR frames can have a body. All other frames MUST NOT have a body.
+    // https://stomp.github.io/stomp-specification-1.2.html#Body
+    // https://stomp.github.io/stomp-specification-1.1.html#Value_Encoding
+    switch (_command) {
+        case OFFTStompFrameCommandSend:
+        case OFFTStompFrameCommandMessage:
+        case OFFTStompFrameCommandError:
+            _mayHaveBody = YES;
+            break;
+        default:
+            _mayHaveBody = NO;
+            break;
+    }
+
+    // Keep the header storage, and any header array that has grown, for reuse
+    _headerCount = 0;
+    self.headerStorage.length = 0;
+    self.headerBytes = self.headerStorage;
+    self.headerBytesOffset = 0;
+    self.headersEscaped = NO;
+    self.headersVersion = OFFTStompVersionUnknown;
+    self.headerDictionary = nil;
+    _body = nil;
+}
+
 - (void)setHeader:(NSString *)header value:(NSString *)value {
-    self.headers[header] = [value copy];
+
+    // Received headers are moved into the frame's own storage before being modified
+    if (self.headerStorage == nil || self.headerBytes != self.headerStorage) {
+        [self moveHeadersToStorage];
+    }
+
+    OFFTStompHeaderName name = OFFTStompHeaderNameFromString(header);
+    NSUInteger index = [self indexOfHeader:header name:name];
+
+    OFFTStompFrameHeader entry;
+    if (index != NSNotFound) {
+        // Replace the value, keeping the header's position
+        entry = _headers[index];
+    } else {
+        entry = (OFFTStompFrameHeader){ .name = name };
+
+        // The names of well-known headers are never stored
+        if (name == OFFTStompHeaderNameUnknown) {
+            entry.nameOffset = (uint32_t)self.headerStorage.length;
+            entry.nameLength = (uint32_t)[self appendStringToStorage:header];
+        }
+    }
+
+    entry.valueOffset = (uint32_t)self.headerStorage.length;
+    entry.valueLength = (uint32_t)[self appendStringToStorage:value];
+
+    if (index != NSNotFound) {
+        _headers[index] = entry;
+    } else {
+        [self reserveHeaderCapacity:_headerCount + 1];
+        _headers[_headerCount++] = entry;
+    }
+
+    self.headerDictionary = nil;
 }
 
 - (NSString *)valueForHeader:(NSString *)header {
-    return _headers[header];
+    NSUInteger index = [self indexOfHeader:header name:OFFTStompHeaderNameFromString(header)];
+    return (index != NSNotFound) ? [self valueOfHeaderAtIndex:index] : nil;
+}
+
+- (NSString *)valueForHeaderName:(OFFTStompHeaderName)name {
+    NSUInteger index = [self indexOfHeader:nil name:name];
+    return (index != NSNotFound) ? [self valueOfHeaderAtIndex:index] : nil;
+}
+
+- (BOOL)getUnsignedIntegerValue:(uint64_t *)value forHeaderName:(OFFTStompHeaderName)name {
+    NSUInteger index = [self indexOfHeader:nil name:name];
+    if (index == NSNotFound) {
+        return NO;
+    }
+
+    // Digits are never escaped, and any more than 19 could overflow
+    const OFFTStompFrameHeader *entry = &_headers[index];
+    if (entry->valueLength == 0 || entry->valueLength > 19) {
+        return NO;
+    }
+
+    const uint8_t *bytes = [self rawHeaderBytes] + entry->valueOffset;
+    uint64_t result = 0;
+    for (uint32_t i = 0; i < entry->valueLength; ++i) {
+        if (bytes[i] < '0' || bytes[i] > '9') {
+            return NO;
+        }
+        result = result * 10 + (bytes[i] - '0');
+    }
+
+    *value = result;
+    return YES;
 }
 
 - (NSDictionary *)allHeaders {
-    return [_headers copy];
+    if (self.headerDictionary == nil && _headerCount > 0) {
+        self.headerDictionary = OFFTStompCreateHeaderDictionary(_headers, _headerCount, [self rawHeaderBytes], self.headersEscaped, self.headersVersion);
+    }
+    return self.headerDictionary;
 }
 
 - (void)setBody:(NSData *)body {
     if (_mayHaveBody) {
-        _body = [body copy];
+        // Received bodies are immutable slices of the receive buffer,
+        // only mutable data needs copying to protect against later changes.
+        _body = [body isKindOfClass:[NSMutableData class]] ? [body copy] : body;
     } else {
         NSAssert(0, @"This type of frame cannot have a body");
     }
 }
 
+#pragma mark - Raw Headers
+
+- (void)setReceivedHeaders:(const OFFTStompFrameHeader *)headers
+                     count:(NSUInteger)count
+                     bytes:(NSData *)bytes
+                    offset:(NSUInteger)offset
+                   escaped:(BOOL)escaped
+                   version:(OFFTStompVersion)version {
+
+    [self reserveHeaderCapacity:count];
+    memcpy(_headers, headers, sizeof(OFFTStompFrameHeader) * count);
+    _headerCount = count;
+
+    self.headerBytes = bytes;
+    self.headerBytesOffset = offset;
+    self.headersEscaped = escaped;
+    self.headersVersion = version;
+    self.headerDictionary = nil;
+}
+
+- (NSUInteger)headerCount {
+    return _headerCount;
+}
+
+- (const OFFTStompFrameHeader *)rawHeaders {
+    return _headers;
+}
+
+- (const uint8_t *)rawHeaderBytes {
+    return (const uint8_t *)self.headerBytes.bytes + self.headerBytesOffset;
+}
+
+- (NSData *)rawHeaderData {
+    // Locally set headers are written into storage that is reused, received ones never change
+    if (self.headerBytes == self.headerStorage) {
+        return [self.headerStorage copy];
+    }
+    return self.headerBytes;
+}
+
+- (NSUInteger)rawHeaderOffset {
+    return self.headerBytesOffset;
+}
+
+- (BOOL)rawHeadersEscaped {
+    return self.headersEscaped;
+}
+
+- (OFFTStompVersion)rawHeadersVersion {
+    return self.headersVersion;
+}
+
+#pragma mark - Private
+
+- (void)reserveHeaderCapacity:(NSUInteger)capacity {
+    if (capacity <= _headerCapacity) {
+        return;
+    }
+
+    NSUInteger newCapacity = MAX(capacity, _headerCapacity * 2);
+    OFFTStompFrameHeader *headers = malloc(sizeof(OFFTStompFrameHeader) * newCapacity);
+    memcpy(headers, _headers, sizeof(OFFTStompFrameHeader) * _headerCount);
+
+    if (_headers != _inlineHeaders) {
+        free(_headers);
+    }
+    _headers = headers;
+    _headerCapacity = newCapacity;
+}
+
+- (NSUInteger)indexOfHeader:(NSString *)header name:(OFFTStompHeaderName)name {
+    return OFFTStompIndexOfHeader(_headers, _headerCount, [self rawHeaderBytes], name, header, self.headersEscaped, self.headersVersion);
+}
+
+- (NSString *)valueOfHeaderAtIndex:(NSUInteger)index {
+    const OFFTStompFrameHeader *entry = &_headers[index];
+    return OFFTStompCreateHeaderString([self rawHeaderBytes] + entry->valueOffset,
+                                       entry->valueLength,
+                                       self.headersEscaped,
+                                       self.headersVersion);
+}
+
+/**
+ *  Copies any received headers into the frame's own storage, unescaping them.
+ */
+- (void)moveHeadersToStorage {
+
+    // The existing storage is never referenced by received headers, so may be reused
+    NSMutableData *storage = self.headerStorage ?: [[NSMutableData alloc] init];
+    storage.length = 0;
+    self.headerStorage = storage;
+
+    const uint8_t *bytes = [self rawHeaderBytes];
+
+    for (NSUInteger i = 0; i < _headerCount; ++i) {
+        OFFTStompFrameHeader *entry = &_headers[i];
+
+        NSString *value = [self valueOfHeaderAtIndex:i];
+        NSString *name = nil;
+        if (entry->name == OFFTStompHeaderNameUnknown) {
+            name = OFFTStompCreateHeaderString(bytes + entry->nameOffset, entry->nameLength, self.headersEscaped, self.headersVersion);
+        }
+
+        if (name) {
+            entry->nameOffset = (uint32_t)storage.length;
+            entry->nameLength = (uint32_t)[self appendStringToStorage:name];
+        }
+        entry->valueOffset = (uint32_t)storage.length;
+        entry->valueLength = (uint32_t)[self appendStringToStorage:value];
+    }
+
+    self.headerBytes = storage;
+    self.headerBytesOffset = 0;
+    self.headersEscaped = NO;
+    self.headersVersion = OFFTStompVersionUnknown;
+}
+
+/**
+ *  Appends the UTF-8 representation of a string to the header storage.
+ *
+ *  @return The number of bytes appended.
+ */
+- (NSUInteger)appendStringToStorage:(NSString *)string {
+    NSMutableData *storage = self.headerStorage;
+    const NSUInteger start = storage.length;
+    const NSUInteger maximumLength = [string maximumLengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+
+    storage.length = start + maximumLength;
+
+    NSUInteger used = 0;
+    [string getBytes:(uint8_t *)storage.mutableBytes + start
+           maxLength:maximumLength
+          usedLength:&used
+            encoding:NSUTF8StringEncoding
+             options:0
+               range:NSMakeRange(0, string.length)
+      remainingRange:NULL];
+
+    storage.length = start + used;
+    return used;
+}
+
 @end
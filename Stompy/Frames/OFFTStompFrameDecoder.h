@@ -0,0 +1,67 @@
+//
+//  OFFTStompFrameDecoder.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OFFTStompFrame.h"
+#import "OFFTStompFramePool.h"
+
+@class OFFTStompFrameDecoder;
+
+@protocol OFFTStompFrameDecoderDelegate <NSObject>
+
+/**
+ *  A complete frame has been decoded.
+ *
+ *  @param decoder The frame decoder.
+ *  @param frame   The decoded frame.
+ */
+- (void)frameDecoder:(OFFTStompFrameDecoder *)decoder didDecodeFrame:(OFFTStompFrame *)frame;
+
+@end
+
+/**
+ *  An incremental STOMP frame decoder.
+ *
+ *  Raw bytes are fed in as they arrive from the transport, in chunks of any size.
+ *  A chunk may contain part of a frame, exactly one frame or several frames;
+ *  the decoder keeps its state between calls and notifies its delegate once for
+ *  every frame that has been completely received.
+ *
+ *  When a content-length header is present the body is read using it, otherwise
+ *  the body extends up to the first NULL byte.
+ *  http://stomp.github.io/stomp-specification-1.2.html#Augmented_BNF
+ */
+@interface OFFTStompFrameDecoder : NSObject
+
+@property (nonatomic, weak) id<OFFTStompFrameDecoderDelegate> delegate;
+
+/**
+ *  The negotiated protocol version, which determines how header values are unescaped.
+ *  Defaults to OFFTStompVersionUnknown.
+ */
+@property (nonatomic, assign) OFFTStompVersion version;
+
+/**
+ *  When set, decoded frames are taken from this pool and the
+ *  delegate may recycle them once they have been handled.
+ */
+@property (nonatomic, strong) OFFTStompFramePool *framePool;
+
+/**
+ *  Feeds the next chunk of received bytes into the decoder.
+ *
+ *  @param data The bytes received from the transport.
+ */
+- (void)appendData:(NSData *)data;
+
+/**
+ *  Discards any partially received frame, ready for a new connection.
+ */
+- (void)reset;
+
+@end
@@ -0,0 +1,360 @@
+//
+//  OFFTStompFrameDecoder.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompFrameDecoder.h"
+#import "OFFTStompFrame.h"
+#import "OFFTStompCodecTables.h"
+#import "OFFTStompHeaderEncoding.h"
+
+#ifndef OFFTSTOMPDEBUG
+#define OFFTSTOMPDEBUG 0
+#endif
+
+#if OFFTSTOMPDEBUG
+#define OFFTSTOMPLOG NSLog
+#else
+#define OFFTSTOMPLOG
+#endif
+
+typedef NS_ENUM(NSUInteger, OFFTStompDecoderState) {
+    OFFTStompDecoderStateIdle,      // Between frames, skipping heart-beat EOLs
+    OFFTStompDecoderStateCommand,
+    OFFTStompDecoderStateHeaders,
+    OFFTStompDecoderStateBody,
+};
+
+static const NSUInteger OFFTStompDecoderInitialHeaderCapacity = 16;
+
+@interface OFFTStompFrameDecoder () {
+    // Header locations, relative to the start of the frame
+    OFFTStompFrameHeader *_headers;
+    NSUInteger _headerCount;
+    NSUInteger _headerCapacity;
+}
+
+/**
+ *  The bytes currently being decoded.
+ *
+ *  This is either the chunk passed to appendData: or, when a frame straddles
+ *  several chunks, the pending buffer. Frame bodies are sliced out of it
+ *  without copying.
+ */
+@property (nonatomic, strong) NSData *segment;
+
+/**
+ *  Received bytes belonging to a partially received frame.
+ *
+ *  This buffer is only ever appended to while nothing else references it;
+ *  once a frame has been sliced out of it a fresh buffer replaces it.
+ */
+@property (nonatomic, strong) NSMutableData *pending;
+
+/**
+ *  Whether a frame has been emitted from the current segment.
+ */
+@property (nonatomic, assign) BOOL segmentReferenced;
+
+@property (nonatomic, assign) OFFTStompDecoderState state;
+
+/**
+ *  Offsets into the segment. The cursor is the next byte to be examined,
+ *  so each byte is only ever scanned once regardless of how the frame was chunked.
+ */
+@property (nonatomic, assign) NSUInteger cursor;
+@property (nonatomic, assign) NSUInteger frameStart;
+@property (nonatomic, assign) NSUInteger lineStart;
+@property (nonatomic, assign) NSUInteger bodyStart;
+
+@property (nonatomic, assign) OFFTStompFrameCommand command;
+
+/**
+ *  The value of the first content-length header, or NSNotFound if none was received.
+ */
+@property (nonatomic, assign) NSUInteger contentLength;
+
+@end
+
+@implementation OFFTStompFrameDecoder
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _pending = [[NSMutableData alloc] init];
+        _headerCapacity = OFFTStompDecoderInitialHeaderCapacity;
+        _headers = malloc(sizeof(OFFTStompFrameHeader) * _headerCapacity);
+        _contentLength = NSNotFound;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_headers);
+}
+
+#pragma mark - Public
+
+- (void)appendData:(NSData *)data {
+    if (data.length == 0) {
+        return;
+    }
+
+    if (self.pending.length == 0) {
+        // Common case: decode straight from the received chunk.
+        // The decoder must own an immutable copy as frames will reference its bytes.
+        self.segment = [data copy];
+    } else {
+        [self.pending appendData:data];
+        self.segment = self.pending;
+    }
+    self.segmentReferenced = NO;
+
+    [self decodeAvailableFrames];
+
+    self.segment = nil;
+}
+
+- (void)reset {
+    self.pending = [[NSMutableData alloc] init];
+    self.state = OFFTStompDecoderStateIdle;
+    self.cursor = 0;
+    self.frameStart = 0;
+    self.lineStart = 0;
+    self.bodyStart = 0;
+    self.contentLength = NSNotFound;
+    self.version = OFFTStompVersionUnknown;
+    _headerCount = 0;
+}
+
+#pragma mark - Private - Decoding
+
+- (void)decodeAvailableFrames {
+
+    const uint8_t *bytes = self.segment.bytes;
+    const NSUInteger length = self.segment.length;
+
+    while (_cursor < length) {
+
+        switch (_state) {
+            case OFFTStompDecoderStateIdle: {
+                // Servers MAY send EOLs between frames as heart-beats
+                // http://stomp.github.io/stomp-specification-1.2.html#Heart-beating
+                while (_cursor < length && (bytes[_cursor] == '\n' || bytes[_cursor] == '\r')) {
+                    ++_cursor;
+                }
+                if (_cursor < length) {
+                    _frameStart = _cursor;
+                    _lineStart = _cursor;
+                    _contentLength = NSNotFound;
+                    _headerCount = 0;
+                    _state = OFFTStompDecoderStateCommand;
+                }
+                break;
+            }
+
+            case OFFTStompDecoderStateCommand:
+            case OFFTStompDecoderStateHeaders: {
+                const uint8_t *lineFeed = memchr(bytes + _cursor, '\n', length - _cursor);
+                if (lineFeed == NULL) {
+                    // Wait for the rest of the line
+                    _cursor = length;
+                    break;
+                }
+
+                NSUInteger lineEnd = lineFeed - bytes;
+                _cursor = lineEnd + 1;
+
+                // STOMP 1.2 allows an optional carriage return before each line feed
+                if (lineEnd > _lineStart && bytes[lineEnd - 1] == '\r') {
+                    --lineEnd;
+                }
+
+                if (_state == OFFTStompDecoderStateCommand) {
+                    _command = OFFTStompCommandFromBytes(bytes + _lineStart, lineEnd - _lineStart);
+                    _state = OFFTStompDecoderStateHeaders;
+                }
+                // A blank line ends the headers
+                else if (lineEnd == _lineStart) {
+                    _bodyStart = _cursor;
+                    _state = OFFTStompDecoderStateBody;
+                }
+                else {
+                    [self decodeHeaderLineFromBytes:bytes start:_lineStart end:lineEnd];
+                }
+
+                _lineStart = _cursor;
+                break;
+            }
+
+            case OFFTStompDecoderStateBody: {
+                NSUInteger bodyEnd;
+
+                if (_contentLength != NSNotFound) {
+                    // Wait until the whole body and its terminating NULL have arrived
+                    if (length - _bodyStart < _contentLength + 1) {
+                        _cursor = length;
+                        break;
+                    }
+                    bodyEnd = _bodyStart + _contentLength;
+
+                    // A server's mistake, so the body is recovered by searching for the NULL byte instead
+                    if (bytes[bodyEnd] != '\0') {
+                        OFFTSTOMPLOG(@"Frame body was not terminated after %lu content-length octets", (unsigned long)_contentLength);
+                        _contentLength = NSNotFound;
+                        _cursor = _bodyStart;
+                        break;
+                    }
+                } else {
+                    const uint8_t *nullByte = memchr(bytes + _cursor, '\0', length - _cursor);
+                    if (nullByte == NULL) {
+                        _cursor = length;
+                        break;
+                    }
+                    bodyEnd = nullByte - bytes;
+                }
+
+                [self emitFrameWithBodyEnd:bodyEnd];
+
+                _cursor = bodyEnd + 1;
+                _state = OFFTStompDecoderStateIdle;
+                break;
+            }
+        }
+    }
+
+    [self retainUnconsumedBytes];
+}
+
+- (void)decodeHeaderLineFromBytes:(const uint8_t *)bytes start:(NSUInteger)start end:(NSUInteger)end {
+
+    const uint8_t *colon = memchr(bytes + start, ':', end - start);
+    if (colon == NULL) {
+        // Not a valid header, ignore it
+        return;
+    }
+
+    NSUInteger nameLength = (colon - bytes) - start;
+    NSUInteger valueStart = start + nameLength + 1;
+    NSUInteger valueLength = end - valueStart;
+
+    OFFTStompHeaderName name = OFFTStompHeaderNameFromBytes(bytes + start, nameLength);
+
+    // Only the first occurrence of a repeated header is significant
+    // http://stomp.github.io/stomp-specification-1.2.html#Repeated_Header_Entries
+    if (name == OFFTStompHeaderNameContentLength && _contentLength == NSNotFound) {
+        _contentLength = [self parseLengthFromBytes:bytes + valueStart length:valueLength];
+    }
+
+    if (_headerCount == _headerCapacity) {
+        _headerCapacity *= 2;
+        _headers = reallocf(_headers, sizeof(OFFTStompFrameHeader) * _headerCapacity);
+    }
+
+    _headers[_headerCount++] = (OFFTStompFrameHeader){
+        .name = name,
+        .nameOffset = (uint32_t)(start - _frameStart),
+        .nameLength = (uint32_t)nameLength,
+        .valueOffset = (uint32_t)(valueStart - _frameStart),
+        .valueLength = (uint32_t)valueLength,
+    };
+}
+
+- (NSUInteger)parseLengthFromBytes:(const uint8_t *)bytes length:(NSUInteger)length {
+    if (length == 0) {
+        return NSNotFound;
+    }
+
+    NSUInteger value = 0;
+    for (NSUInteger i = 0; i < length; ++i) {
+        if (bytes[i] < '0' || bytes[i] > '9' || value > (NSNotFound - 10) / 10) {
+            return NSNotFound;
+        }
+        value = value * 10 + (bytes[i] - '0');
+    }
+    return value;
+}
+
+- (void)emitFrameWithBodyEnd:(NSUInteger)bodyEnd {
+
+    // Frames with unrecognised commands are dropped
+    if (_command == OFFTStompFrameCommandUnknown) {
+        return;
+    }
+
+    OFFTStompFrame *frame = self.framePool ? [self.framePool frameWithCommand:_command]
+                                           : [[OFFTStompFrame alloc] initWithCommand:_command];
+
+    // Headers stay in the received bytes and are only decoded when they are read.
+    // Only the header block is referenced, never the rest of a pending buffer.
+    [frame setReceivedHeaders:_headers
+                        count:_headerCount
+                        bytes:[self sliceSegmentWithRange:NSMakeRange(_frameStart, _bodyStart - _frameStart)]
+                       offset:0
+                      escaped:OFFTStompCommandUsesEscaping(_command, self.version)
+                      version:self.version];
+
+    if (frame.mayHaveBody) {
+        frame.body = [self sliceSegmentWithRange:NSMakeRange(_bodyStart, bodyEnd - _bodyStart)];
+    }
+    self.segmentReferenced = YES;
+
+    [self.delegate frameDecoder:self didDecodeFrame:frame];
+}
+
+/**
+ *  Creates an NSData that points into the current segment without copying it.
+ *  The slice retains the segment, so the received bytes are freed only once
+ *  the last slice referencing them has been released.
+ */
+- (NSData *)sliceSegmentWithRange:(NSRange)range {
+    if (range.length == 0) {
+        return [NSData data];
+    }
+
+    NSData *segment = self.segment;
+    void *bytes = (void *)((const uint8_t *)segment.bytes + range.location);
+
+    return [[NSData alloc] initWithBytesNoCopy:bytes
+                                        length:range.length
+                                   deallocator:^(void *sliceBytes, NSUInteger sliceLength) {
+                                       // Referencing the segment keeps it alive for the lifetime of the slice
+                                       (void)segment;
+                                   }];
+}
+
+/**
+ *  Carries the bytes of a partially received frame over into the pending buffer,
+ *  discarding those of every completed frame.
+ */
+- (void)retainUnconsumedBytes {
+
+    const NSUInteger consumed = (_state == OFFTStompDecoderStateIdle) ? _cursor : _frameStart;
+    const NSUInteger remaining = self.segment.length - consumed;
+
+    if (self.segment == self.pending && self.segmentReferenced == NO) {
+        // Nothing points into the pending buffer, so it can be compacted in place
+        [self.pending replaceBytesInRange:NSMakeRange(0, consumed) withBytes:NULL length:0];
+    } else {
+        NSUInteger capacity = remaining;
+
+        // Reserve room for the rest of the body up front so it is appended without reallocating
+        if (_state == OFFTStompDecoderStateBody && _contentLength != NSNotFound) {
+            capacity = MAX(capacity, (_bodyStart - _frameStart) + _contentLength + 1);
+        }
+
+        NSMutableData *pending = [[NSMutableData alloc] initWithCapacity:capacity];
+        [pending appendBytes:(const uint8_t *)self.segment.bytes + consumed length:remaining];
+        self.pending = pending;
+    }
+
+    _cursor -= consumed;
+    _lineStart -= MIN(_lineStart, consumed);
+    _bodyStart -= MIN(_bodyStart, consumed);
+    _frameStart -= MIN(_frameStart, consumed);
+}
+
+@end
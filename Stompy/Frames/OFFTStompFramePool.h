@@ -0,0 +1,45 @@
+//
+//  OFFTStompFramePool.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OFFTStompFrame.h"
+
+/**
+ *  A pool of frames that are reset and reused once they have been sent or delivered,
+ *  saving the allocation of a frame and its header storage for every frame.
+ *
+ *  A pool is not thread safe and belongs to a single client.
+ */
+@interface OFFTStompFramePool : NSObject
+
+/**
+ *  The maximum number of unused frames kept for reuse. Defaults to 32.
+ */
+@property (nonatomic, assign) NSUInteger capacity;
+
+/**
+ *  The number of frames that were satisfied by reusing a pooled frame.
+ */
+@property (nonatomic, assign, readonly) NSUInteger hits;
+
+/**
+ *  The number of frames that had to be allocated as the pool was empty.
+ */
+@property (nonatomic, assign, readonly) NSUInteger misses;
+
+/**
+ *  Retrieves a frame for the specified command, reusing a pooled frame if one is available.
+ */
+- (OFFTStompFrame *)frameWithCommand:(OFFTStompFrameCommand)command;
+
+/**
+ *  Returns a frame to the pool. The frame must not be used again by the caller.
+ */
+- (void)recycleFrame:(OFFTStompFrame *)frame;
+
+@end
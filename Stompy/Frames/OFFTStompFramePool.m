@@ -0,0 +1,75 @@
+//
+//  OFFTStompFramePool.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompFramePool.h"
+
+static const NSUInteger OFFTStompFramePoolDefaultCapacity = 32;
+
+@interface OFFTStompFramePool ()
+
+@property (nonatomic, strong) NSMutableArray *frames;
+
+@property (nonatomic, assign) NSUInteger hits;
+@property (nonatomic, assign) NSUInteger misses;
+
+@end
+
+@implementation OFFTStompFramePool
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _capacity = OFFTStompFramePoolDefaultCapacity;
+    }
+    return self;
+}
+
+#pragma mark - Public
+
+- (OFFTStompFrame *)frameWithCommand:(OFFTStompFrameCommand)command {
+    OFFTStompFrame *frame = [self.frames lastObject];
+
+    if (frame) {
+        [self.frames removeLastObject];
+        [frame resetWithCommand:command];
+        ++self.hits;
+    } else {
+        frame = [[OFFTStompFrame alloc] initWithCommand:command];
+        ++self.misses;
+    }
+    return frame;
+}
+
+- (void)recycleFrame:(OFFTStompFrame *)frame {
+    if (frame == nil || self.frames.count >= self.capacity) {
+        return;
+    }
+
+    // Release the frame's references to the body and received bytes straight away
+    [frame resetWithCommand:OFFTStompFrameCommandUnknown];
+    [self.frames addObject:frame];
+}
+
+- (void)setCapacity:(NSUInteger)capacity {
+    _capacity = capacity;
+
+    if (_frames.count > capacity) {
+        [_frames removeObjectsInRange:NSMakeRange(capacity, _frames.count - capacity)];
+    }
+}
+
+#pragma mark - Lazy Instantiation
+
+- (NSMutableArray *)frames {
+    if (_frames == nil) {
+        _frames = [[NSMutableArray alloc] initWithCapacity:self.capacity];
+    }
+    return _frames;
+}
+
+@end
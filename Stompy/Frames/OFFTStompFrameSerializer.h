@@ -0,0 +1,53 @@
+//
+//  OFFTStompFrameSerializer.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OFFTStompFrame.h"
+
+/**
+ *  Converts frames into their wire representation.
+ *
+ *  The exact size of the frame is calculated first, then the command, headers,
+ *  body and terminating NULL are written in a single pass into an output buffer.
+ *  Output buffers are handed to the caller rather than copied, and return to the
+ *  serializer to be reused once the last reference to them has been released.
+ *  A serializer should be owned by a single connection.
+ */
+@interface OFFTStompFrameSerializer : NSObject
+
+/**
+ *  The protocol version used to encode frames.
+ *  Defaults to OFFTStompVersionUnknown.
+ */
+@property (nonatomic, assign) OFFTStompVersion version;
+
+/**
+ *  Serializes the frame.
+ *
+ *  A content-length header is written automatically for frames with a body.
+ *
+ *  @param frame The frame to serialize.
+ *
+ *  @return The serialized frame. The returned data is immutable and may be retained
+ *          for as long as needed, such as by a transport until it has been written.
+ */
+- (NSData *)serializeFrame:(OFFTStompFrame *)frame;
+
+/**
+ *  Serializes the frame as separate parts, so that the body is never copied.
+ *
+ *  The parts are the command and headers, the frame's body if it has one,
+ *  and the terminating NULL. They must be sent in order.
+ *
+ *  @param frame The frame to serialize.
+ *
+ *  @return An array of immutable NSData objects, which may be retained.
+ */
+- (NSArray *)serializeFrameParts:(OFFTStompFrame *)frame;
+
+@end
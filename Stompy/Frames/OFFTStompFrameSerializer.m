@@ -0,0 +1,319 @@
+//
+//  OFFTStompFrameSerializer.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompFrameSerializer.h"
+#import "OFFTStompCodecTables.h"
+#import "OFFTStompHeaderEncoding.h"
+
+static inline NSUInteger OFFTStompDecimalLength(NSUInteger value) {
+    NSUInteger digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+static inline uint8_t *OFFTStompWriteDecimal(uint8_t *output, NSUInteger value, NSUInteger digits) {
+    for (NSUInteger i = digits; i > 0; --i) {
+        output[i - 1] = '0' + (value % 10);
+        value /= 10;
+    }
+    return output + digits;
+}
+
+static inline uint8_t *OFFTStompWriteBytes(uint8_t *output, const void *bytes, NSUInteger length) {
+    memcpy(output, bytes, length);
+    return output + length;
+}
+
+/**
+ *  The serialized length of a header name or value.
+ */
+static inline NSUInteger OFFTStompHeaderBytesLength(const uint8_t *bytes, NSUInteger length, BOOL escape, OFFTStompVersion version) {
+    return escape ? OFFTStompEscapedLength(bytes, length, version) : length;
+}
+
+static inline uint8_t *OFFTStompWriteHeaderBytes(uint8_t *output, const uint8_t *bytes, NSUInteger length, NSUInteger serializedLength, OFFTStompVersion version) {
+    // Only take the slower path when something actually needs escaping
+    if (serializedLength != length) {
+        return OFFTStompWriteEscapedBytes(output, bytes, length, version);
+    }
+    return OFFTStompWriteBytes(output, bytes, length);
+}
+
+// Output buffers kept for reuse, enough for the frames a transport typically has waiting to be written
+static const NSUInteger OFFTStompSerializerBufferCount = 4;
+
+/**
+ *  The output buffers not currently referenced by any serialized frame.
+ *
+ *  Buffers are returned from whichever thread releases the frame's data,
+ *  so the list is guarded by a lock, and outlives the serializer if need be.
+ */
+@interface OFFTStompSerializerBuffers : NSObject {
+    NSLock *_lock;
+    void *_blocks[OFFTStompSerializerBufferCount];
+    NSUInteger _capacities[OFFTStompSerializerBufferCount];
+    NSUInteger _count;
+}
+
+/**
+ *  Takes a free buffer of at least the given size, growing or allocating one if needed.
+ */
+- (void *)takeBufferOfSize:(NSUInteger)size capacity:(NSUInteger *)capacity;
+
+/**
+ *  Gives a buffer back once nothing references it, freeing it if enough are already free.
+ */
+- (void)returnBuffer:(void *)buffer capacity:(NSUInteger)capacity;
+
+@end
+
+@implementation OFFTStompSerializerBuffers
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _lock = [[NSLock alloc] init];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    for (NSUInteger i = 0; i < _count; ++i) {
+        free(_blocks[i]);
+    }
+}
+
+- (void *)takeBufferOfSize:(NSUInteger)size capacity:(NSUInteger *)capacity {
+    void *buffer = NULL;
+    NSUInteger bufferCapacity = 0;
+
+    [_lock lock];
+    if (_count > 0) {
+        // Prefer a buffer that is already large enough, otherwise grow the most recently returned one
+        NSUInteger index = _count - 1;
+        for (NSUInteger i = 0; i < _count; ++i) {
+            if (_capacities[i] >= size) {
+                index = i;
+                break;
+            }
+        }
+        buffer = _blocks[index];
+        bufferCapacity = _capacities[index];
+
+        --_count;
+        _blocks[index] = _blocks[_count];
+        _capacities[index] = _capacities[_count];
+    }
+    [_lock unlock];
+
+    if (bufferCapacity < size) {
+        // Room to grow, so frames of slowly increasing size do not reallocate every time
+        bufferCapacity = MAX(size, bufferCapacity * 2);
+        buffer = reallocf(buffer, MAX(bufferCapacity, 1));
+    }
+
+    *capacity = bufferCapacity;
+    return buffer;
+}
+
+- (void)returnBuffer:(void *)buffer capacity:(NSUInteger)capacity {
+    [_lock lock];
+    if (_count < OFFTStompSerializerBufferCount) {
+        _blocks[_count] = buffer;
+        _capacities[_count] = capacity;
+        ++_count;
+        buffer = NULL;
+    }
+    [_lock unlock];
+
+    free(buffer);
+}
+
+@end
+
+@interface OFFTStompFrameSerializer ()
+
+@property (nonatomic, strong) OFFTStompSerializerBuffers *buffers;
+
+@end
+
+@implementation OFFTStompFrameSerializer
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _buffers = [[OFFTStompSerializerBuffers alloc] init];
+    }
+    return self;
+}
+
+#pragma mark - Public
+
+- (NSData *)serializeFrame:(OFFTStompFrame *)frame {
+    return [self serializeFrame:frame includingBody:YES];
+}
+
+- (NSArray *)serializeFrameParts:(OFFTStompFrame *)frame {
+    static NSData *terminator;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        terminator = [NSData dataWithBytes:"\0" length:1];
+    });
+
+    NSData *headerBlock = [self serializeFrame:frame includingBody:NO];
+    if (headerBlock == nil) {
+        return nil;
+    }
+
+    // The body is passed on as-is, frames only hold immutable bodies
+    NSData *body = frame.mayHaveBody ? frame.body : nil;
+    if (body.length > 0) {
+        return @[headerBlock, body, terminator];
+    }
+    return @[headerBlock, terminator];
+}
+
+#pragma mark - Private
+
+/**
+ *  Writes the frame into the output buffer.
+ *
+ *  @param includeBody Whether to write the body and terminating NULL,
+ *                     otherwise the buffer ends after the blank line following the headers.
+ */
+- (NSData *)serializeFrame:(OFFTStompFrame *)frame includingBody:(BOOL)includeBody {
+
+    NSUInteger commandLength = 0;
+    const char *command = OFFTStompCommandName(frame.command, &commandLength);
+    if (command == NULL) {
+        NSAssert(0, @"Cannot serialize a frame with an unknown command");
+        return nil;
+    }
+
+    // STOMP 1.2 uses OPTIONAL carriage return + REQUIRED line feed
+    // http://stomp.github.io/stomp-specification-1.2.html#STOMP_Frames
+    // Older versions use only line feed
+    // http://stomp.github.io/stomp-specification-1.1.html#STOMP_Frames
+    // http://stomp.github.io/stomp-specification-1.0.html
+    const char *eol = (self.version == OFFTStompVersion1_2) ? "\r\n" : "\n";
+    const NSUInteger eolLength = strlen(eol);
+
+    NSData *body = frame.mayHaveBody ? frame.body : nil;
+    const NSUInteger bodyLength = body.length;
+    const NSUInteger bodyLengthDigits = OFFTStompDecimalLength(bodyLength);
+
+    const OFFTStompVersion version = self.version;
+
+    const OFFTStompFrameHeader *headers = frame.rawHeaders;
+    const NSUInteger headerCount = frame.headerCount;
+    const uint8_t *headerBytes = frame.rawHeaderBytes;
+
+    // Headers received from the peer are still in their escaped form
+    const BOOL escape = OFFTStompCommandUsesEscaping(frame.command, version) && frame.rawHeadersEscaped == NO;
+
+    // First pass: calculate the exact size of the frame
+    NSUInteger size = commandLength + eolLength;
+
+    for (NSUInteger i = 0; i < headerCount; ++i) {
+        const OFFTStompFrameHeader *header = &headers[i];
+
+        // The content-length header is derived from the body
+        if (header->name == OFFTStompHeaderNameContentLength) {
+            continue;
+        }
+
+        // Well-known names never need escaping
+        NSUInteger nameLength = 0;
+        if (OFFTStompHeaderNameBytes(header->name, &nameLength) == NULL) {
+            nameLength = OFFTStompHeaderBytesLength(headerBytes + header->nameOffset, header->nameLength, escape, version);
+        }
+
+        size += nameLength + 1
+              + OFFTStompHeaderBytesLength(headerBytes + header->valueOffset, header->valueLength, escape, version)
+              + eolLength;
+    }
+
+    NSUInteger contentLengthHeaderLength = 0;
+    const char *contentLengthHeader = OFFTStompHeaderNameBytes(OFFTStompHeaderNameContentLength, &contentLengthHeaderLength);
+
+    if (body) {
+        size += contentLengthHeaderLength + 1 + bodyLengthDigits + eolLength;
+    }
+
+    // Blank line, body and terminating NULL
+    size += eolLength;
+    if (includeBody) {
+        size += bodyLength + 1;
+    }
+
+    // Second pass: write the frame
+    NSUInteger capacity = 0;
+    uint8_t *start = [self.buffers takeBufferOfSize:size capacity:&capacity];
+    if (start == NULL) {
+        return nil;
+    }
+    uint8_t *output = start;
+
+    output = OFFTStompWriteBytes(output, command, commandLength);
+    output = OFFTStompWriteBytes(output, eol, eolLength);
+
+    for (NSUInteger i = 0; i < headerCount; ++i) {
+        const OFFTStompFrameHeader *header = &headers[i];
+        if (header->name == OFFTStompHeaderNameContentLength) {
+            continue;
+        }
+
+        NSUInteger nameLength = 0;
+        const char *nameBytes = OFFTStompHeaderNameBytes(header->name, &nameLength);
+        if (nameBytes) {
+            output = OFFTStompWriteBytes(output, nameBytes, nameLength);
+        } else {
+            const uint8_t *bytes = headerBytes + header->nameOffset;
+            nameLength = OFFTStompHeaderBytesLength(bytes, header->nameLength, escape, version);
+            output = OFFTStompWriteHeaderBytes(output, bytes, header->nameLength, nameLength, version);
+        }
+        output = OFFTStompWriteBytes(output, ":", 1);
+
+        const uint8_t *valueBytes = headerBytes + header->valueOffset;
+        const NSUInteger valueLength = OFFTStompHeaderBytesLength(valueBytes, header->valueLength, escape, version);
+        output = OFFTStompWriteHeaderBytes(output, valueBytes, header->valueLength, valueLength, version);
+        output = OFFTStompWriteBytes(output, eol, eolLength);
+    }
+
+    if (body) {
+        output = OFFTStompWriteBytes(output, contentLengthHeader, contentLengthHeaderLength);
+        output = OFFTStompWriteBytes(output, ":", 1);
+        output = OFFTStompWriteDecimal(output, bodyLength, bodyLengthDigits);
+        output = OFFTStompWriteBytes(output, eol, eolLength);
+    }
+
+    // End the headers with an additional newline
+    output = OFFTStompWriteBytes(output, eol, eolLength);
+
+    if (includeBody) {
+        if (bodyLength > 0) {
+            output = OFFTStompWriteBytes(output, body.bytes, bodyLength);
+        }
+
+        // End the frame with a NULL byte
+        output = OFFTStompWriteBytes(output, "\0", 1);
+    }
+
+    NSAssert(output == start + size, @"Serialized frame size mismatch");
+
+    // Ownership of the buffer passes to the data, which gives it back once released
+    OFFTStompSerializerBuffers *buffers = self.buffers;
+    return [[NSData alloc] initWithBytesNoCopy:start length:size deallocator:^(void *bytes, NSUInteger length) {
+        [buffers returnBuffer:bytes capacity:capacity];
+    }];
+}
+
+@end
@@ -0,0 +1,81 @@
+//
+//  OFFTStompHeaderEncoding.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OFFTStompFrame.h"
+
+// Header names and values are escaped as described in
+// http://stomp.github.io/stomp-specification-1.2.html#Value_Encoding
+// http://stomp.github.io/stomp-specification-1.1.html#Value_Encoding
+//
+// Almost every header needs no escaping, so each function makes a single
+// scan of its input and avoids copying it when no special byte is found.
+
+/**
+ *  Whether the headers of a frame are escaped.
+ *  CONNECT and CONNECTED frames are never escaped, nor are frames prior to STOMP 1.1.
+ */
+extern BOOL OFFTStompCommandUsesEscaping(OFFTStompFrameCommand command, OFFTStompVersion version);
+
+/**
+ *  The length of the bytes once escaped, equal to length if no escaping is needed.
+ */
+extern NSUInteger OFFTStompEscapedLength(const uint8_t *bytes, NSUInteger length, OFFTStompVersion version);
+
+/**
+ *  Writes the escaped bytes to output, which must have room for OFFTStompEscapedLength bytes.
+ *
+ *  @return The position following the written bytes.
+ */
+extern uint8_t *OFFTStompWriteEscapedBytes(uint8_t *output, const uint8_t *bytes, NSUInteger length, OFFTStompVersion version);
+
+/**
+ *  Escapes a string.
+ *
+ *  @return The same string if no escaping is needed, otherwise an escaped copy.
+ */
+extern NSString *OFFTStompEscapedString(NSString *string, OFFTStompVersion version);
+
+/**
+ *  Creates a string from received header bytes, decoding any escape sequences.
+ *  Undefined escape sequences are kept as-is.
+ *
+ *  @param unescape Whether escape sequences should be decoded.
+ */
+extern NSString *OFFTStompCreateHeaderString(const uint8_t *bytes, NSUInteger length, BOOL unescape, OFFTStompVersion version);
+
+/**
+ *  Finds the first occurrence of a header. Frames have few headers,
+ *  so a linear search is quicker than maintaining an index.
+ *
+ *  @param headers The headers to search.
+ *  @param count   The number of headers.
+ *  @param bytes   The bytes that header offsets are relative to.
+ *  @param name    The well-known header to search for.
+ *  @param header  The name of the header, only used if name is OFFTStompHeaderNameUnknown.
+ *  @param escaped Whether the header bytes are escaped.
+ *  @param version The protocol version used to escape them.
+ *
+ *  @return The index of the header, or NSNotFound.
+ */
+extern NSUInteger OFFTStompIndexOfHeader(const OFFTStompFrameHeader *headers,
+                                         NSUInteger count,
+                                         const uint8_t *bytes,
+                                         OFFTStompHeaderName name,
+                                         NSString *header,
+                                         BOOL escaped,
+                                         OFFTStompVersion version);
+
+/**
+ *  Creates a dictionary of the headers, keeping the first value of any repeated header.
+ */
+extern NSDictionary *OFFTStompCreateHeaderDictionary(const OFFTStompFrameHeader *headers,
+                                                     NSUInteger count,
+                                                     const uint8_t *bytes,
+                                                     BOOL escaped,
+                                                     OFFTStompVersion version);
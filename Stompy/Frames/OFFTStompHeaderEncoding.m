@@ -0,0 +1,219 @@
+//
+//  OFFTStompHeaderEncoding.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompHeaderEncoding.h"
+#import "OFFTStompCodecTables.h"
+
+/**
+ *  The character following the backslash for each byte that must be escaped, or 0.
+ */
+static const uint8_t OFFTStompEscapeTable[256] = {
+    ['\r'] = 'r',
+    ['\n'] = 'n',
+    [':']  = 'c',
+    ['\\'] = '\\',
+};
+
+/**
+ *  Headers up to this length are unescaped on the stack.
+ */
+static const NSUInteger OFFTStompUnescapeStackLength = 256;
+
+/**
+ *  Header names up to this length are encoded on the stack when looked up.
+ */
+static const NSUInteger OFFTStompHeaderNameStackLength = 128;
+
+static inline uint8_t OFFTStompEscapeForByte(uint8_t byte, OFFTStompVersion version) {
+    // Carriage returns are only escaped by STOMP 1.2
+    if (byte == '\r' && version != OFFTStompVersion1_2) {
+        return 0;
+    }
+    return OFFTStompEscapeTable[byte];
+}
+
+BOOL OFFTStompCommandUsesEscaping(OFFTStompFrameCommand command, OFFTStompVersion version) {
+    if (version == OFFTStompVersionUnknown) {
+        return NO;
+    }
+    return command != OFFTStompFrameCommandConnect && command != OFFTStompFrameCommandConnected;
+}
+
+NSUInteger OFFTStompEscapedLength(const uint8_t *bytes, NSUInteger length, OFFTStompVersion version) {
+    NSUInteger escapedLength = length;
+    for (NSUInteger i = 0; i < length; ++i) {
+        if (OFFTStompEscapeForByte(bytes[i], version)) {
+            ++escapedLength;
+        }
+    }
+    return escapedLength;
+}
+
+uint8_t *OFFTStompWriteEscapedBytes(uint8_t *output, const uint8_t *bytes, NSUInteger length, OFFTStompVersion version) {
+    for (NSUInteger i = 0; i < length; ++i) {
+        uint8_t escape = OFFTStompEscapeForByte(bytes[i], version);
+        if (escape) {
+            *output++ = '\\';
+            *output++ = escape;
+        } else {
+            *output++ = bytes[i];
+        }
+    }
+    return output;
+}
+
+NSString *OFFTStompEscapedString(NSString *string, OFFTStompVersion version) {
+    static NSCharacterSet *escapedCharacters1_1;
+    static NSCharacterSet *escapedCharacters1_2;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        escapedCharacters1_1 = [NSCharacterSet characterSetWithCharactersInString:@"\n:\\"];
+        escapedCharacters1_2 = [NSCharacterSet characterSetWithCharactersInString:@"\r\n:\\"];
+    });
+
+    NSCharacterSet *escapedCharacters = (version == OFFTStompVersion1_2) ? escapedCharacters1_2 : escapedCharacters1_1;
+
+    // Fast path, nothing to escape
+    if ([string rangeOfCharacterFromSet:escapedCharacters].location == NSNotFound) {
+        return string;
+    }
+
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    NSUInteger escapedLength = OFFTStompEscapedLength(data.bytes, data.length, version);
+
+    NSMutableData *escaped = [[NSMutableData alloc] initWithLength:escapedLength];
+    OFFTStompWriteEscapedBytes(escaped.mutableBytes, data.bytes, data.length, version);
+
+    return [[NSString alloc] initWithData:escaped encoding:NSUTF8StringEncoding];
+}
+
+NSString *OFFTStompCreateHeaderString(const uint8_t *bytes, NSUInteger length, BOOL unescape, OFFTStompVersion version) {
+
+    // Fast path, nothing to unescape
+    if (unescape == NO || memchr(bytes, '\\', length) == NULL) {
+        return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    }
+
+    // Unescaping never lengthens the value
+    uint8_t stackBuffer[OFFTStompUnescapeStackLength];
+    uint8_t *buffer = (length <= sizeof(stackBuffer)) ? stackBuffer : malloc(length);
+    NSUInteger unescapedLength = 0;
+
+    for (NSUInteger i = 0; i < length; ++i) {
+        if (bytes[i] == '\\' && i + 1 < length) {
+            uint8_t decoded = 0;
+            switch (bytes[i + 1]) {
+                case 'n':  decoded = '\n'; break;
+                case 'c':  decoded = ':';  break;
+                case '\\': decoded = '\\'; break;
+                case 'r':  decoded = (version == OFFTStompVersion1_2) ? '\r' : 0; break;
+                default:   break;
+            }
+            if (decoded) {
+                buffer[unescapedLength++] = decoded;
+                ++i;
+                continue;
+            }
+        }
+        buffer[unescapedLength++] = bytes[i];
+    }
+
+    NSString *string = [[NSString alloc] initWithBytes:buffer length:unescapedLength encoding:NSUTF8StringEncoding];
+
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+    return string;
+}
+
+NSUInteger OFFTStompIndexOfHeader(const OFFTStompFrameHeader *headers,
+                                  NSUInteger count,
+                                  const uint8_t *bytes,
+                                  OFFTStompHeaderName name,
+                                  NSString *header,
+                                  BOOL escaped,
+                                  OFFTStompVersion version) {
+
+    if (name != OFFTStompHeaderNameUnknown) {
+        for (NSUInteger i = 0; i < count; ++i) {
+            if (headers[i].name == name) {
+                return i;
+            }
+        }
+        return NSNotFound;
+    }
+
+    if (header.length == 0 || count == 0) {
+        return NSNotFound;
+    }
+
+    // Received names are compared in their escaped form
+    if (escaped) {
+        header = OFFTStompEscapedString(header, version);
+    }
+
+    // Encode the name for comparison, avoiding an allocation for most names
+    uint8_t stackBuffer[OFFTStompHeaderNameStackLength];
+    NSData *heapBuffer = nil;
+    const uint8_t *nameBytes = stackBuffer;
+    NSUInteger nameLength = 0;
+    NSRange remaining = NSMakeRange(0, 0);
+
+    [header getBytes:stackBuffer
+           maxLength:sizeof(stackBuffer)
+          usedLength:&nameLength
+            encoding:NSUTF8StringEncoding
+             options:0
+               range:NSMakeRange(0, header.length)
+      remainingRange:&remaining];
+
+    if (remaining.length > 0) {
+        heapBuffer = [header dataUsingEncoding:NSUTF8StringEncoding];
+        nameBytes = heapBuffer.bytes;
+        nameLength = heapBuffer.length;
+    }
+
+    for (NSUInteger i = 0; i < count; ++i) {
+        const OFFTStompFrameHeader *entry = &headers[i];
+        if (entry->name == OFFTStompHeaderNameUnknown
+        && entry->nameLength == nameLength
+        && memcmp(bytes + entry->nameOffset, nameBytes, nameLength) == 0) {
+            return i;
+        }
+    }
+    return NSNotFound;
+}
+
+NSDictionary *OFFTStompCreateHeaderDictionary(const OFFTStompFrameHeader *headers,
+                                              NSUInteger count,
+                                              const uint8_t *bytes,
+                                              BOOL escaped,
+                                              OFFTStompVersion version) {
+
+    NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] initWithCapacity:count];
+
+    for (NSUInteger i = 0; i < count; ++i) {
+        const OFFTStompFrameHeader *entry = &headers[i];
+
+        NSString *name = OFFTStompHeaderNameString(entry->name);
+        if (name == nil) {
+            name = OFFTStompCreateHeaderString(bytes + entry->nameOffset, entry->nameLength, escaped, version);
+        }
+
+        // Only the first occurrence of a repeated header is significant
+        // http://stomp.github.io/stomp-specification-1.2.html#Repeated_Header_Entries
+        if (name && dictionary[name] == nil) {
+            NSString *value = OFFTStompCreateHeaderString(bytes + entry->valueOffset, entry->valueLength, escaped, version);
+            if (value) {
+                dictionary[name] = value;
+            }
+        }
+    }
+
+    return dictionary;
+}
@@ -8,15 +8,63 @@
 
 #import <Foundation/Foundation.h>
 #import "OFFTStompTransportAdapter.h"
+#import "OFFTStompHeaderView.h"
 
 @class OFFTStompClient;
+@class OFFTStompSubscriptionOptions;
 
 extern NSString * const OFFTStompErrorDomain;
 
 typedef NS_ENUM(NSUInteger, OFFTStompError) {
     OFFTStompConnectionError = 1,
+    OFFTStompHeartbeatTimeoutError = 2,
+    OFFTStompTransportError = 3,        // The underlying error is under NSUnderlyingErrorKey
 };
 
+/**
+ *  What happens to messages sent while the outbound buffer is full.
+ */
+typedef NS_ENUM(NSUInteger, OFFTStompOutboundPolicy) {
+    OFFTStompOutboundPolicyBlock,   // The sending thread waits until the buffer has drained
+    OFFTStompOutboundPolicyFail,    // The message is not sent, and the send method returns NO
+    OFFTStompOutboundPolicyDrop,    // The message is silently discarded
+};
+
+/**
+ *  How the messages received by a subscription are acknowledged.
+ *  https://stomp.github.io/stomp-specification-1.2.html#SUBSCRIBE_ack_Header
+ */
+typedef NS_ENUM(NSUInteger, OFFTStompAckMode) {
+    OFFTStompAckModeAuto,             // Messages are considered acknowledged as soon as the server sends them
+    OFFTStompAckModeClient,           // Acknowledging a message also acknowledges every earlier message of the subscription
+    OFFTStompAckModeClientIndividual, // Each message is acknowledged on its own
+};
+
+/**
+ *  Called once a transaction has been committed, or has failed to be.
+ *
+ *  @param committed NO if the transaction was not open, or the connection was lost
+ *                   or the receipt timeout passed before the server confirmed the commit.
+ */
+typedef void(^OFFTStompTransactionCompletion)(BOOL committed);
+
+/**
+ *  Called once a server has confirmed a message was received, or it never will.
+ *
+ *  @param confirmed NO if the message was dropped by the outbound policy, or the
+ *                   client disconnected or the receipt timeout passed before the
+ *                   server confirmed it.
+ */
+typedef void(^OFFTStompSendCompletion)(BOOL confirmed);
+
+/**
+ *  Handles the messages of a single subscription.
+ *
+ *  @param messageData The body of the received message.
+ *  @param headerView  The headers of the received message.
+ */
+typedef void(^OFFTStompMessageHandler)(NSData *messageData, OFFTStompHeaderView *headerView);
+
 @protocol OFFTStompClientDelegate <NSObject>
 
 /**
@@ -39,12 +87,16 @@ typedef NS_ENUM(NSUInteger, OFFTStompError) {
 /**
  *  A message has been received from the STOMP server.
  *
- *  The delegate should implement either
- *  this method, or the alternative:-
+ *  The delegate should implement one of
+ *  this method, or the alternatives:-
+ *  stompClient:receivedMessageData:withHeaderView
  *  stompClient:receivedMessageData:withHeaders
  *
- *  This method will NOT be called if both
- *  have been implemented.
+ *  This method will NOT be called if either
+ *  of the alternatives have been implemented.
+ *
+ *  The body is decoded as UTF8, so this method
+ *  is not suitable for receiving binary messages.
  *
  *  @param stompClient The STOMP client.
  *  @param message     The body of the received message.
@@ -57,12 +109,16 @@ typedef NS_ENUM(NSUInteger, OFFTStompError) {
 /**
  *  A message has been received from the STOMP server.
  *
- *  The delegate should implement either
- *  this method, or the alternative:-
+ *  The delegate should implement one of
+ *  this method, or the alternatives:-
+ *  stompClient:receivedMessageData:withHeaderView
  *  stompClient:receivedMessage:withHeaders
  *
- *  This method will take precendence if both
- *  have been implemented.
+ *  This method will take precendence over
+ *  stompClient:receivedMessage:withHeaders.
+ *
+ *  The message data references the transport's receive
+ *  buffer directly rather than being a copy of it.
  *
  *  @param stompClient The STOMP client.
  *  @param messageData The body of the received message.
@@ -72,14 +128,72 @@ typedef NS_ENUM(NSUInteger, OFFTStompError) {
 receivedMessageData:(NSData *)messageData
         withHeaders:(NSDictionary *)headers;
 
+/**
+ *  A message has been received from the STOMP server.
+ *
+ *  Unlike the alternatives, no header is decoded into
+ *  a string until it is read from the header view,
+ *  making this the cheapest way to receive messages.
+ *
+ *  This method will take precendence over both
+ *  alternatives if implemented.
+ *
+ *  @param stompClient The STOMP client.
+ *  @param messageData The body of the received message.
+ *  @param headerView  The headers of the received message.
+ */
+- (void)stompClient:(OFFTStompClient *)stompClient
+receivedMessageData:(NSData *)messageData
+     withHeaderView:(OFFTStompHeaderView *)headerView;
+
+/**
+ *  The data waiting to be written has reached the outbound high watermark.
+ *  Further messages are handled according to the outbound policy until it drains.
+ *
+ *  @param stompClient The STOMP client.
+ */
+- (void)stompClientOutboundBufferFull:(OFFTStompClient *)stompClient;
+
+/**
+ *  The data waiting to be written has fallen to the outbound low watermark.
+ *
+ *  @param stompClient The STOMP client.
+ */
+- (void)stompClientOutboundBufferDrained:(OFFTStompClient *)stompClient;
+
+/**
+ *  The connection has been lost and the client will try to reconnect.
+ *  Only called when the client reconnects automatically.
+ *
+ *  Once reconnected, stompClientDidConnect: is called again
+ *  and the client's subscriptions have been restored.
+ *
+ *  @param stompClient The STOMP client.
+ *  @param delay       How long until the client tries to reconnect.
+ *  @param attempt     The number of the attempt, starting from 1.
+ */
+- (void)stompClient:(OFFTStompClient *)stompClient willReconnectAfterDelay:(NSTimeInterval)delay attempt:(NSUInteger)attempt;
+
 @end
 
 @interface OFFTStompClient : NSObject
 
 @property (nonatomic, weak) id<OFFTStompClientDelegate> delegate;
 
+/**
+ *  The serial queue on which received data is parsed and the client's state is managed.
+ */
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+
+/**
+ *  The queue on which delegate methods are called.
+ *  Defaults to nil, calling the delegate directly on the processing queue.
+ */
+@property (nonatomic, strong) dispatch_queue_t delegateQueue;
+
 /**
  *  Creates a new STOMP client that will connect over the provided transport.
+ *  The client and its transport run on the main queue.
  *
  *  @param transport A transport adapter that will handle the sending & receiving of data.
  *
@@ -87,6 +201,20 @@ receivedMessageData:(NSData *)messageData
  */
 + (instancetype)stompWithTransport:(id<OFFTStompTransportAdapter>)transport;
 
+/**
+ *  Creates a new STOMP client that will connect over the provided transport.
+ *
+ *  Frames are parsed and handled on the provided queue, which the transport
+ *  is also asked to call back on. Methods of the client may be called from
+ *  any thread, their work is performed on the queue.
+ *
+ *  @param transport A transport adapter that will handle the sending & receiving of data.
+ *  @param queue     A serial queue, or nil to use the main queue.
+ *
+ *  @return A new OFFTStompClient instance
+ */
++ (instancetype)stompWithTransport:(id<OFFTStompTransportAdapter>)transport queue:(dispatch_queue_t)queue;
+
 - (void)connect;
 
 - (void)disconnect;
@@ -98,8 +226,10 @@ receivedMessageData:(NSData *)messageData
  *
  *  @param message     The message to be sent.
  *  @param destination Where to send the message.
+ *
+ *  @return NO if the message was rejected because the outbound buffer is full.
  */
-- (void)sendMessage:(NSString *)message
+- (BOOL)sendMessage:(NSString *)message
       toDestination:(NSString *)destination;
 
 /**
@@ -108,48 +238,253 @@ receivedMessageData:(NSData *)messageData
  *  @param message     The message to be sent.
  *  @param destination Where to send the message.
  *  @param headers     User-defined headers as a dictionary of NSString : NSString objects.
+ *
+ *  @return NO if the message was rejected because the outbound buffer is full.
  */
-- (void)sendMessage:(NSString *)message
+- (BOOL)sendMessage:(NSString *)message
       toDestination:(NSString *)destination
   withCustomHeaders:(NSDictionary *)headers;
 
 /**
  *  Sends a message to the provided destination.
- *  The data versions of sendMessage... are intended as helper
- *  methods for sending JSON or base64 data. They
- *  should not be used to send non-UTF8 encoded data.
+ *  The data may be arbitrary binary, such as a protobuf payload,
+ *  as the body is framed using the content-length header.
  *
- *  @param message     The message to be sent. The data must represent a UTF8 encoded string.
+ *  @param message     The message to be sent.
  *  @param destination Where to send the message.
+ *
+ *  @return NO if the message was rejected because the outbound buffer is full.
  */
-- (void)sendMessageData:(NSData *)messageData
+- (BOOL)sendMessageData:(NSData *)messageData
           toDestination:(NSString *)destination;
 
 /**
  *  Sends a message to the provided destination.
- *  The data versions of sendMessage... are intended as helper
- *  methods for sending JSON or base64 data. They
- *  should not be used to send non-UTF8 encoded data.
+ *  The data may be arbitrary binary, such as a protobuf payload,
+ *  as the body is framed using the content-length header.
  *
- *  @param message     The message to be sent. The data must represent a UTF8 encoded string.
+ *  @param message     The message to be sent.
  *  @param destination Where to send the message.
  *  @param headers     User-defined headers as a dictionary of NSString : NSString objects.
+ *
+ *  @return NO if the message was rejected because the outbound buffer is full.
  */
-- (void)sendMessageData:(NSData *)messageData
+- (BOOL)sendMessageData:(NSData *)messageData
           toDestination:(NSString *)destination
       withCustomHeaders:(NSDictionary *)headers;
 
+#pragma mark - Write Coalescing
+
+/**
+ *  When enabled, frames sent in the same turn of the processing queue are
+ *  combined into a single transport write, reducing the number of writes
+ *  or WebSocket messages sent by bursty publishers. Defaults to NO.
+ */
+@property (nonatomic, assign) BOOL coalescesWrites;
+
+/**
+ *  How long to wait for further frames before writing coalesced frames.
+ *  Defaults to 0, writing at the end of the current queue turn.
+ */
+@property (nonatomic, assign) NSTimeInterval coalescingInterval;
+
+/**
+ *  Coalesced frames are written immediately once this many bytes are waiting.
+ *  Defaults to 64KB.
+ */
+@property (nonatomic, assign) NSUInteger coalescingByteThreshold;
+
+/**
+ *  Immediately writes any coalesced frames, for latency-critical sends.
+ */
+- (void)flush;
+
+#pragma mark - Outbound Buffer
+
+/**
+ *  Once this many bytes are waiting to be written the outbound buffer
+ *  is full and messages are handled according to the outbound policy.
+ *  Defaults to 0, for no limit.
+ *
+ *  Transports that do not report their writes, such as the SockJS transport,
+ *  are considered to have written data as soon as they have accepted it, so
+ *  the buffer never fills with them. The SocketRocket transport polls its
+ *  socket's output buffer, so notices writes up to 100ms late.
+ */
+@property (nonatomic, assign) NSUInteger outboundHighWatermark;
+
+/**
+ *  A full outbound buffer is drained once no more than this many bytes are waiting to be written.
+ *  Defaults to 0.
+ */
+@property (nonatomic, assign) NSUInteger outboundLowWatermark;
+
+/**
+ *  What happens to messages sent while the outbound buffer is full.
+ *  Defaults to OFFTStompOutboundPolicyBlock.
+ */
+@property (nonatomic, assign) OFFTStompOutboundPolicy outboundPolicy;
+
+/**
+ *  The number of bytes waiting to be written.
+ */
+@property (nonatomic, assign, readonly) NSUInteger outboundBytes;
+
+/**
+ *  The number of frames waiting to be written.
+ */
+@property (nonatomic, assign, readonly) NSUInteger outboundFrames;
+
+/**
+ *  The number of messages discarded by OFFTStompOutboundPolicyDrop.
+ */
+@property (nonatomic, assign, readonly) NSUInteger droppedMessageCount;
+
+#pragma mark - Frame Pool
+
+/**
+ *  Frames are reused once they have been sent or delivered rather
+ *  than being allocated for every message. These counters can be
+ *  used to size the pool for the expected message rate.
+ */
+
+/**
+ *  The maximum number of unused frames kept for reuse. Defaults to 32.
+ */
+@property (nonatomic, assign) NSUInteger framePoolCapacity;
+
+/**
+ *  The number of frames that reused a pooled frame.
+ */
+@property (nonatomic, assign, readonly) NSUInteger framePoolHits;
+
+/**
+ *  The number of frames that had to be allocated because the pool was empty.
+ */
+@property (nonatomic, assign, readonly) NSUInteger framePoolMisses;
+
+#pragma mark - Heart-beating
+
+/**
+ *  How often the client offers to send heart-beats, negotiated with the server
+ *  when connecting. Heart-beats are only sent while nothing else is being sent.
+ *  Defaults to 0, for none.
+ */
+@property (nonatomic, assign) NSTimeInterval heartbeatSendInterval;
+
+/**
+ *  How often the client asks the server to send heart-beats, negotiated with the
+ *  server when connecting. If nothing at all is received for one and a half times
+ *  the negotiated interval the connection is assumed to be dead and is closed,
+ *  with an OFFTStompHeartbeatTimeoutError. Silence is checked for twice per
+ *  interval, so the connection is closed at most half an interval after that.
+ *  Defaults to 0, for none.
+ *
+ *  The heart-beat timers of every client run from a single timing wheel.
+ */
+@property (nonatomic, assign) NSTimeInterval heartbeatReceiveInterval;
+
+#pragma mark - Reconnection
+
+/**
+ *  When enabled, the client reconnects whenever the connection is lost
+ *  until it is asked to disconnect. Defaults to NO.
+ *
+ *  After reconnecting, every active subscription is subscribed again in a
+ *  single write, and frames sent with a receipt request that had not been
+ *  confirmed are sent again.
+ */
+@property (nonatomic, assign) BOOL automaticallyReconnects;
+
+/**
+ *  The delay before the first attempt to reconnect, which doubles with each
+ *  further attempt. Each delay is randomised between zero and its full
+ *  length, so that many clients losing the same broker do not reconnect
+ *  in lockstep. Defaults to 0.5 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval reconnectInitialDelay;
+
+/**
+ *  The longest delay between attempts to reconnect. Defaults to 30 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval reconnectMaximumDelay;
+
+/**
+ *  The number of consecutive attempts to reconnect before giving up.
+ *  Defaults to 0, for no limit.
+ */
+@property (nonatomic, assign) NSUInteger maximumReconnectAttempts;
+
 #pragma mark - Subscriptions
 
 /**
  *  Subscribes to a given destination.
  *
+ *  The subscription remains active until unsubscribed or the client disconnects.
+ *  Subscriptions made before the client has connected are sent once it has.
+ *
  *  @param destination The destination of the subscription.
  *
  *  @return An opaque type that can be used to unsubscribe.
  */
 - (id)subscribe:(NSString *)destination;
 
+/**
+ *  Subscribes to a given destination, acknowledging its messages as provided.
+ *
+ *  Unless the ack mode is OFFTStompAckModeAuto, each message received must be
+ *  acknowledged with ackMessageWithHeaders: or nackMessageWithHeaders:, and the
+ *  server redelivers any message not acknowledged when the connection is lost.
+ *
+ *  @param destination The destination of the subscription.
+ *  @param ackMode     How the subscription's messages are acknowledged.
+ *
+ *  @return An opaque type that can be used to unsubscribe.
+ */
+- (id)subscribe:(NSString *)destination ackMode:(OFFTStompAckMode)ackMode;
+
+/**
+ *  Subscribes to a given destination with the provided options,
+ *  such as its ack mode, prefetch window and further headers.
+ *
+ *  @param destination The destination of the subscription.
+ *  @param options     The options of the subscription, or nil for the defaults.
+ *
+ *  @return An opaque type that can be used to unsubscribe.
+ */
+- (id)subscribe:(NSString *)destination options:(OFFTStompSubscriptionOptions *)options;
+
+/**
+ *  Subscribes to a given destination, handling its messages with a block
+ *  instead of the delegate.
+ *
+ *  Messages are routed to their subscription's handler by the integer in their
+ *  subscription header, so the cost does not grow with the number of subscriptions.
+ *
+ *  @param destination The destination of the subscription.
+ *  @param handler     Called for each message received by the subscription.
+ *  @param queue       The queue the handler is called on, or nil for the delegate queue.
+ *
+ *  @return An opaque type that can be used to unsubscribe.
+ */
+- (id)subscribe:(NSString *)destination handler:(OFFTStompMessageHandler)handler queue:(dispatch_queue_t)queue;
+
+/**
+ *  Subscribes to a given destination with the provided options, handling
+ *  its messages with a block instead of the delegate.
+ *
+ *  @param destination The destination of the subscription.
+ *  @param options     The options of the subscription, or nil for the defaults.
+ *  @param handler     Called for each message received by the subscription.
+ *  @param queue       The queue the handler is called on, or nil for the delegate queue.
+ *
+ *  @return An opaque type that can be used to unsubscribe.
+ */
+- (id)subscribe:(NSString *)destination
+        options:(OFFTStompSubscriptionOptions *)options
+        handler:(OFFTStompMessageHandler)handler
+          queue:(dispatch_queue_t)queue;
+
 /**
  *  Unsubscribes from an existing subscription.
  *
@@ -157,4 +492,152 @@ receivedMessageData:(NSData *)messageData
  */
 - (void)unsubscribe:(id)subscription;
 
+#pragma mark - Acknowledgement
+
+/**
+ *  Acknowledges a message received by a subscription made with
+ *  OFFTStompAckModeClient or OFFTStompAckModeClientIndividual.
+ *  Has no effect for messages of other subscriptions.
+ *
+ *  The message is identified by its ack header when STOMP 1.2 has been
+ *  negotiated, or by its message-id and subscription headers for 1.1.
+ *
+ *  @param headers The headers of the received message, either the header view or the dictionary provided to the delegate.
+ */
+- (void)ackMessageWithHeaders:(id)headers;
+
+/**
+ *  Tells the server a message received by a subscription made with OFFTStompAckModeClient
+ *  or OFFTStompAckModeClientIndividual has not been consumed, so may be redelivered.
+ *  Any acknowledgements of the subscription waiting to be batched are sent first.
+ *
+ *  @param headers The headers of the received message, either the header view or the dictionary provided to the delegate.
+ */
+- (void)nackMessageWithHeaders:(id)headers;
+
+/**
+ *  For subscriptions made with OFFTStompAckModeClient, acknowledgements are
+ *  batched and sent as a single cumulative ACK for the latest message once this
+ *  many messages have been acknowledged. Messages should be acknowledged in
+ *  the order they were received.
+ *
+ *  Defaults to 1, sending every acknowledgement immediately. 0 sends
+ *  acknowledgements only once the ack batch interval has passed.
+ *
+ *  A subscription with a prefetch count has its batch sent once it covers
+ *  the prefetch window, however large the batch size.
+ */
+@property (nonatomic, assign) NSUInteger ackBatchSize;
+
+/**
+ *  A batch of acknowledgements is sent at most this long after its first
+ *  acknowledgement, however few messages it covers. Defaults to 0, for no limit.
+ *
+ *  Batched acknowledgements are sent before disconnecting or unsubscribing,
+ *  any still waiting when the connection is lost are discarded.
+ */
+@property (nonatomic, assign) NSTimeInterval ackBatchInterval;
+
+#pragma mark - Receipts
+
+/**
+ *  Sends a message to the provided destination, requesting a receipt for it.
+ *
+ *  Up to the confirmed send window's worth of messages wait for their receipts
+ *  at once, later messages are queued by the client until earlier ones have been
+ *  confirmed. Messages are sent again after reconnecting automatically until
+ *  their receipt arrives.
+ *
+ *  @param message     The message to be sent.
+ *  @param destination Where to send the message.
+ *  @param headers     User-defined headers as a dictionary of NSString : NSString objects. May be nil.
+ *  @param completion  Called on the delegate queue, if set, once the message has been confirmed or has failed. May be nil.
+ *
+ *  @return NO if the message was rejected because the outbound buffer is full.
+ */
+- (BOOL)sendMessageData:(NSData *)messageData
+          toDestination:(NSString *)destination
+      withCustomHeaders:(NSDictionary *)headers
+             completion:(OFFTStompSendCompletion)completion;
+
+/**
+ *  How long to wait for a receipt before treating it as never arriving.
+ *  Defaults to 10 seconds, 0 waits for as long as the connection lasts.
+ *
+ *  Time spent reconnecting is not counted. A DISCONNECT whose receipt
+ *  does not arrive in time closes the connection anyway.
+ */
+@property (nonatomic, assign) NSTimeInterval receiptTimeout;
+
+/**
+ *  The most confirmed sends waiting for their receipts at once. Defaults to 128, 0 for no limit.
+ */
+@property (nonatomic, assign) NSUInteger confirmedSendWindow;
+
+#pragma mark - Transactions
+
+/**
+ *  Begins a transaction.
+ *
+ *  Messages sent and acknowledgements made in a transaction take effect together
+ *  once it has been committed, or not at all if it is aborted or the connection
+ *  is lost first. When called from another queue, waits for the client's queue.
+ *
+ *  @return An opaque type identifying the transaction, or nil if the client is not connected.
+ */
+- (id)beginTransaction;
+
+/**
+ *  Sends a message to the provided destination as part of a transaction.
+ *  The message is not delivered until the transaction has been committed,
+ *  and is discarded if the transaction is no longer open.
+ *
+ *  @param message     The message to be sent.
+ *  @param destination Where to send the message.
+ *  @param headers     User-defined headers as a dictionary of NSString : NSString objects. May be nil.
+ *  @param transaction The opaque transaction type provided by an earlier call to beginTransaction
+ *
+ *  @return NO if the message was rejected because the outbound buffer is full.
+ */
+- (BOOL)sendMessageData:(NSData *)messageData
+          toDestination:(NSString *)destination
+      withCustomHeaders:(NSDictionary *)headers
+            transaction:(id)transaction;
+
+/**
+ *  Acknowledges a message as part of a transaction. Unlike other acknowledgements,
+ *  it is never batched or withheld, as it has no effect until the transaction is committed.
+ *
+ *  @param headers     The headers of the received message, either the header view or the dictionary provided to the delegate.
+ *  @param transaction The opaque transaction type provided by an earlier call to beginTransaction
+ */
+- (void)ackMessageWithHeaders:(id)headers transaction:(id)transaction;
+
+/**
+ *  Rejects a message as part of a transaction.
+ *
+ *  @param headers     The headers of the received message, either the header view or the dictionary provided to the delegate.
+ *  @param transaction The opaque transaction type provided by an earlier call to beginTransaction
+ */
+- (void)nackMessageWithHeaders:(id)headers transaction:(id)transaction;
+
+/**
+ *  Commits a transaction with a single COMMIT frame requesting a receipt,
+ *  confirming everything sent in the transaction with one round trip.
+ *
+ *  A commit is never sent again after reconnecting, as the server
+ *  aborts transactions along with the connection they were begun on.
+ *
+ *  @param transaction The opaque transaction type provided by an earlier call to beginTransaction
+ *  @param completion  Called on the delegate queue, if set, once the receipt has arrived or the commit has failed. May be nil.
+ */
+- (void)commitTransaction:(id)transaction completion:(OFFTStompTransactionCompletion)completion;
+
+/**
+ *  Aborts a transaction, discarding everything sent in it.
+ *
+ *  @param transaction The opaque transaction type provided by an earlier call to beginTransaction
+ */
+- (void)abortTransaction:(id)transaction;
+
 @end
@@ -9,9 +9,20 @@
 #import "OFFTStompClient.h"
 #import "OFFTStompTransportAdapter.h"
 #import "OFFTStompFrame.h"
+#import "OFFTStompFrameDecoder.h"
+#import "OFFTStompFrameSerializer.h"
+#import "OFFTStompFramePool.h"
+#import "OFFTStompCodecTables.h"
 #import "OFFTStompSubscription.h"
+#import "OFFTStompSubscriptionOptions.h"
+#import "OFFTStompTransaction.h"
+#import "OFFTStompTimingWheel.h"
+#import "OFFTStompReceiptTable.h"
+#include <stdatomic.h>
 
-#define OFFTSTOMPDEBUG 1
+#ifndef OFFTSTOMPDEBUG
+#define OFFTSTOMPDEBUG 0
+#endif
 
 #if OFFTSTOMPDEBUG
 #define OFFTSTOMPLOG NSLog
@@ -21,23 +32,26 @@
 
 NSString * const OFFTStompErrorDomain = @"OFFTStompErrorDomain";
 
-// Standard frame headers
-NSString * const OFFTStompHeaderAcceptVersion = @"accept-version";
-NSString * const OFFTStompHeaderVersion       = @"version";
-NSString * const OFFTStompHeaderHost          = @"host";
-NSString * const OFFTStompHeaderReceipt       = @"receipt";
-NSString * const OFFTStompHeaderDestination   = @"destination";
-NSString * const OFFTStompHeaderContentLength = @"content-length";
-NSString * const OFFTStompHeaderID            = @"id";
-
 // Supported/accepted versions
-typedef NS_ENUM(NSUInteger, OFFTStompVersion) {
-    OFFTStompVersionUnknown,
-    OFFTStompVersion1_1,
-    OFFTStompVersion1_2,
-};
 NSString * const OFFTStompAcceptVersions = @"1.1,1.2";
 
+// Coalesced writes are sent once this many bytes are pending
+static const NSUInteger OFFTStompDefaultCoalescingByteThreshold = 64 * 1024;
+
+// Bodies at least this large are sent separately from the headers rather than copied alongside them
+static const NSUInteger OFFTStompScatterGatherBodyLength = 16 * 1024;
+
+static const NSUInteger OFFTStompDefaultAckBatchSize = 1;
+
+static const NSTimeInterval OFFTStompDefaultReceiptTimeout = 10.0;
+static const NSUInteger OFFTStompDefaultConfirmedSendWindow = 128;
+
+static const NSTimeInterval OFFTStompDefaultReconnectInitialDelay = 0.5;
+static const NSTimeInterval OFFTStompDefaultReconnectMaximumDelay = 30.0;
+
+// The server is assumed to be gone once nothing has been received for this many heart-beat intervals
+static const double OFFTStompHeartbeatTolerance = 1.5;
+
 typedef NS_ENUM(NSUInteger, OFFTStompState) {
     OFFTStompStateDisconnected,
     OFFTStompStateConnecting,
@@ -45,12 +59,49 @@ typedef NS_ENUM(NSUInteger, OFFTStompState) {
     OFFTStompStateDisconnecting,
 };
 
-typedef void(^OFFTStompReceiptHandler)();
-
-@interface OFFTStompClient () <OFFTStompTransportDelegate>
+@interface OFFTStompClient () <OFFTStompTransportDelegate, OFFTStompFrameDecoderDelegate>
 @property (nonatomic, strong, nonnull) id<OFFTStompTransportAdapter> transport;
+@property (nonatomic, strong) dispatch_queue_t queue;
 @property (nonatomic, copy) NSString *host;
 
+/**
+ *  Reassembles frames from the bytes received by the transport.
+ */
+@property (nonatomic, strong) OFFTStompFrameDecoder *frameDecoder;
+
+/**
+ *  Writes outgoing frames into a buffer reused for the lifetime of the connection.
+ */
+@property (nonatomic, strong) OFFTStompFrameSerializer *frameSerializer;
+
+/**
+ *  Frames are recycled once they have been sent or delivered.
+ */
+@property (nonatomic, strong) OFFTStompFramePool *framePool;
+
+/**
+ *  Serialized frames waiting to be written as one when coalescing writes.
+ */
+@property (nonatomic, strong) NSMutableData *pendingWrites;
+@property (nonatomic, assign) BOOL flushScheduled;
+
+/**
+ *  Guards the outbound accounting, which senders on other threads consult before queueing a message.
+ */
+@property (nonatomic, strong) NSCondition *outboundCondition;
+
+/**
+ *  The lengths of frames not yet completely written by the transport, oldest first.
+ */
+@property (nonatomic, strong) NSMutableArray *outboundFrameLengths;
+
+/**
+ *  Bytes of the oldest outbound frame that have already been written.
+ */
+@property (nonatomic, assign) NSUInteger outboundWrittenBytes;
+
+@property (nonatomic, assign) BOOL outboundFull;
+
 /**
  * The versions of the STOMP protocol this client supports.
  */
@@ -64,119 +115,350 @@ typedef void(^OFFTStompReceiptHandler)();
 @property (nonatomic, assign) OFFTStompState state;
 
 /**
- *  A counter that can be used to generate unique receipt headers.
+ *  The receipts being waited for, along with the serialized frames sent again
+ *  after reconnecting until their receipt arrives. Frames are only kept when
+ *  reconnecting automatically.
  */
-@property (nonatomic, assign) NSUInteger receiptCounter;
+@property (nonatomic, strong) OFFTStompReceiptTable *receiptTable;
 
 /**
- *  A dictionary of receipt headers : receipt handler blocks
+ *  Confirmed sends waiting for room in the confirmed send window, oldest first,
+ *  as blocks that either send the message or complete it unsent.
  */
-@property (nonatomic, copy) NSMutableDictionary *receiptHandlers;
+@property (nonatomic, strong) NSMutableArray *waitingConfirmedSends;
+@property (nonatomic, assign) NSUInteger confirmedSendsInFlight;
+
+/**
+ *  A dictionary of subscription identifiers : active subscriptions, restored after reconnecting.
+ */
+@property (nonatomic, strong) NSMutableDictionary *subscriptions;
+
+/**
+ *  The same subscriptions keyed by their number, which received messages are routed on
+ *  without decoding their subscription header into a string.
+ */
+@property (nonatomic, strong) NSMutableDictionary *subscriptionRoutes;
+
+/**
+ *  A dictionary of subscription identifiers : the ack or message-id header of the latest message
+ *  acknowledged, for client mode subscriptions whose acknowledgements are waiting to be sent.
+ */
+@property (nonatomic, strong) NSMutableDictionary *pendingAcks;
+@property (nonatomic, assign) NSUInteger pendingAckCount;
+@property (nonatomic, assign) BOOL ackFlushScheduled;
+
+/**
+ *  Incremented whenever the pending acknowledgements are sent, so a scheduled
+ *  flush that is no longer needed does nothing rather than cut short the next batch.
+ */
+@property (nonatomic, assign) NSUInteger ackFlushGeneration;
+
+/**
+ *  A dictionary of transaction identifiers : transactions open on the current connection.
+ */
+@property (nonatomic, strong) NSMutableDictionary *transactions;
+
+/**
+ *  Whether the app wants the client to be connected, cleared when it asks to disconnect.
+ */
+@property (nonatomic, assign) BOOL wantsConnection;
+
+@property (nonatomic, assign) NSUInteger reconnectAttempts;
+@property (nonatomic, assign) BOOL reconnectScheduled;
+
+/**
+ *  Heart-beat timers, scheduled on the shared timing wheel once connected.
+ */
+@property (nonatomic, strong) OFFTStompWheelTimer *sendHeartbeatTimer;
+@property (nonatomic, strong) OFFTStompWheelTimer *receiveHeartbeatTimer;
+
+/**
+ *  Whether anything has been sent since the send heart-beat timer last fired.
+ */
+@property (nonatomic, assign) BOOL sentSinceHeartbeat;
+
+/**
+ *  When anything was last received, and how long the server may then stay silent.
+ */
+@property (nonatomic, assign) CFAbsoluteTime lastReceivedTime;
+@property (nonatomic, assign) NSTimeInterval receiveTimeout;
+
+/**
+ *  Reported to the delegate once the transport has closed.
+ */
+@property (nonatomic, strong) NSError *disconnectionError;
 
 @end
 
-@implementation OFFTStompClient
+@implementation OFFTStompClient {
+    // Subscription identifiers are never reused, so late messages are not routed to a newer subscription
+    atomic_uint_fast64_t _lastSubscriptionNumber;
+}
 
 + (instancetype)stompWithTransport:(id<OFFTStompTransportAdapter>)transport {
+    return [self stompWithTransport:transport queue:nil];
+}
+
++ (instancetype)stompWithTransport:(id<OFFTStompTransportAdapter>)transport queue:(dispatch_queue_t)queue {
     
     OFFTStompClient *client = [[self alloc] init];
+    client.queue = queue ?: dispatch_get_main_queue();
+    client.coalescingByteThreshold = OFFTStompDefaultCoalescingByteThreshold;
+    client.outboundCondition = [[NSCondition alloc] init];
+    client.ackBatchSize = OFFTStompDefaultAckBatchSize;
+    client.receiptTimeout = OFFTStompDefaultReceiptTimeout;
+    client.confirmedSendWindow = OFFTStompDefaultConfirmedSendWindow;
+    client.reconnectInitialDelay = OFFTStompDefaultReconnectInitialDelay;
+    client.reconnectMaximumDelay = OFFTStompDefaultReconnectMaximumDelay;
+    
+    // Marks the queue so the client can tell when it is already running on it
+    dispatch_queue_set_specific(client.queue, (__bridge const void *)client, (__bridge void *)client, NULL);
+    
     client.transport = transport;
     client.transport.delegate = client;
+    if ([client.transport respondsToSelector:@selector(setDelegateQueue:)]) {
+        [client.transport setDelegateQueue:client.queue];
+    }
     return client;
 }
 
+- (void)dealloc {
+    dispatch_queue_set_specific(_queue, (__bridge const void *)self, NULL, NULL);
+}
+
+#pragma mark - Public - Write Coalescing
+
+- (void)flush {
+    [self performOnQueue:^{
+        [self flushPendingWrites];
+    }];
+}
+
+#pragma mark - Public - Frame Pool
+
+- (NSUInteger)framePoolHits {
+    return self.framePool.hits;
+}
+
+- (NSUInteger)framePoolMisses {
+    return self.framePool.misses;
+}
+
+- (NSUInteger)framePoolCapacity {
+    return self.framePool.capacity;
+}
+
+- (void)setFramePoolCapacity:(NSUInteger)framePoolCapacity {
+    self.framePool.capacity = framePoolCapacity;
+}
+
 #pragma mark - Public - Connection
 
 // TODO: login & passcode support
 // http://stomp.github.io/stomp-specification-1.2.html#CONNECT_or_STOMP_Frame
 - (void)connect {
-    self.state = OFFTStompStateConnecting;
-    [self.transport open];
+    [self performOnQueue:^{
+        self.wantsConnection = YES;
+        self.reconnectAttempts = 0;
+        self.reconnectScheduled = NO;
+        
+        self.state = OFFTStompStateConnecting;
+        [self.transport open];
+    }];
 }
 
 - (void)disconnect {
-    self.state = OFFTStompStateDisconnecting;
+    [self performOnQueue:^{
+        self.wantsConnection = NO;
+        
+        // Waiting to reconnect, so there is no connection to close
+        if (self.reconnectScheduled) {
+            self.reconnectScheduled = NO;
+            self.state = OFFTStompStateDisconnected;
+            [self endSession];
+            [self notifyDelegate:^(id<OFFTStompClientDelegate> delegate) {
+                [delegate stompClient:self didDisconnectWithError:nil];
+            }];
+            return;
+        }
+        
+        // Otherwise the server would redeliver the messages they acknowledge
+        for (OFFTStompSubscription *subscription in _subscriptions.allValues) {
+            [self sendWithheldAcksForSubscription:subscription];
+        }
+        [self sendPendingAcks];
+        
+        // Whatever the window, their receipts arrive before the DISCONNECT's
+        [self sendWaitingConfirmedSendsIgnoringWindow:YES];
+        
+        self.state = OFFTStompStateDisconnecting;
 
-    OFFTStompFrame *frame = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandDisconnect];
-    
-    __weak typeof(self) weakSelf = self;
-    [self sendFrame:frame withReceiptHandler:^{
-        [weakSelf forceDisconnect];
+        OFFTStompFrame *frame = [self.framePool frameWithCommand:OFFTStompFrameCommandDisconnect];
+        
+        // Closed once the receipt arrives, or the receipt timeout has passed without it
+        __weak typeof(self) weakSelf = self;
+        [self sendFrame:frame withReceiptHandler:^(BOOL received) {
+            if (weakSelf.state == OFFTStompStateDisconnecting) {
+                [weakSelf forceDisconnect];
+            }
+        }];
     }];
 }
 
 #pragma mark - Public - Sending Messages
 
-- (void)sendMessage:(NSString *)message
+- (BOOL)sendMessage:(NSString *)message
       toDestination:(NSString *)destination {
-    [self sendMessage:message
+    return [self sendMessage:message
         toDestination:destination
     withCustomHeaders:nil];
 }
 
-- (void)sendMessage:(NSString *)message
+- (BOOL)sendMessage:(NSString *)message
       toDestination:(NSString *)destination
   withCustomHeaders:(NSDictionary *)headers {
-    [self sendMessageData:[message dataUsingEncoding:NSUTF8StringEncoding]
+    return [self sendMessageData:[message dataUsingEncoding:NSUTF8StringEncoding]
             toDestination:destination
         withCustomHeaders:headers];
 }
 
-- (void)sendMessageData:(NSData *)messageData
+- (BOOL)sendMessageData:(NSData *)messageData
           toDestination:(NSString *)destination {
-    [self sendMessageData:messageData
+    return [self sendMessageData:messageData
             toDestination:destination
         withCustomHeaders:nil];
 }
 
-- (void)sendMessageData:(NSData *)messageData
+- (BOOL)sendMessageData:(NSData *)messageData
           toDestination:(NSString *)destination
       withCustomHeaders:(NSDictionary *)headers {
+    return [self sendMessageData:messageData
+            toDestination:destination
+        withCustomHeaders:headers
+           transactionID:nil];
+}
 
-    __block BOOL invalidHeaders = NO;
-
-    __block OFFTStompFrame *frame = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandSend];
+/**
+ *  Sends a message, as part of a transaction when its identifier is provided.
+ */
+- (BOOL)sendMessageData:(NSData *)messageData
+          toDestination:(NSString *)destination
+      withCustomHeaders:(NSDictionary *)headers
+          transactionID:(NSString *)transactionID {
     
-    // Add the user defined headers, ensuring they are comprised only of strings
-    [headers enumerateKeysAndObjectsUsingBlock:^(id header, id value, BOOL *stop) {
-        if ([header isKindOfClass:[NSString class]]
-        && [value isKindOfClass:[NSString class]]) {
-            
-            [frame setHeader:header value:value];
-            
-        } else {
-            NSAssert(0, @"Custom headers (and their values) must be strings.");
-            *stop = YES;
-            invalidHeaders = YES;
+    // Dropped messages are reported as sent, rejected messages are not
+    BOOL rejected = NO;
+    if ([self shouldSendOutboundMessage:&rejected] == NO) {
+        return !rejected;
+    }
+    
+    // Protect against changes made by the caller before the frame is built
+    messageData = [messageData copy];
+    headers = [headers copy];
+    
+    [self performOnQueue:^{
+        // The transaction was aborted, perhaps along with its connection
+        if (transactionID && _transactions[transactionID] == nil) {
+            return;
+        }
+        OFFTStompFrame *frame = [self messageFrameWithData:messageData toDestination:destination withCustomHeaders:headers];
+        if (frame == nil) {
+            return;
         }
+        if (transactionID) {
+            [frame setHeader:OFFTStompHeaderTransaction value:transactionID];
+        }
+        [self sendFrame:frame];
     }];
+    return YES;
+}
+
+- (BOOL)sendMessageData:(NSData *)messageData
+          toDestination:(NSString *)destination
+      withCustomHeaders:(NSDictionary *)headers
+             completion:(OFFTStompSendCompletion)completion {
     
-    // Needed if NS_BLOCK_ASSERTIONS is enabled
-    if (invalidHeaders) {
-        return;
+    completion = [completion copy] ?: ^(BOOL confirmed) {};
+    
+    // A dropped message is never confirmed
+    BOOL rejected = NO;
+    if ([self shouldSendOutboundMessage:&rejected] == NO) {
+        if (rejected == NO) {
+            [self performCompletion:^{
+                completion(NO);
+            }];
+        }
+        return !rejected;
     }
     
-    [frame setHeader:OFFTStompHeaderDestination value:destination];
-    [frame setHeader:OFFTStompHeaderContentLength
-               value:[NSString stringWithFormat:@"%ld", messageData.length]];
-    [frame setBody:messageData];
+    // Protect against changes made by the caller before the frame is built
+    messageData = [messageData copy];
+    headers = [headers copy];
     
-    [self sendFrame:frame];
+    [self performOnQueue:^{
+        void (^send)(BOOL) = ^(BOOL shouldSend) {
+            if (shouldSend) {
+                [self sendConfirmedMessageData:messageData toDestination:destination withCustomHeaders:headers completion:completion];
+            } else {
+                [self performCompletion:^{
+                    completion(NO);
+                }];
+            }
+        };
+        
+        if (self.confirmedSendWindow > 0 && self.confirmedSendsInFlight >= self.confirmedSendWindow) {
+            [self.waitingConfirmedSends addObject:[send copy]];
+        } else {
+            send(YES);
+        }
+    }];
+    return YES;
 }
 
 #pragma mark - Public - Subscriptions
 
 - (id)subscribe:(NSString *)destination {
+    return [self subscribe:destination ackMode:OFFTStompAckModeAuto];
+}
+
+- (id)subscribe:(NSString *)destination ackMode:(OFFTStompAckMode)ackMode {
+    return [self subscribe:destination options:[OFFTStompSubscriptionOptions optionsWithAckMode:ackMode prefetchCount:0]];
+}
+
+- (id)subscribe:(NSString *)destination options:(OFFTStompSubscriptionOptions *)options {
+    return [self subscribe:destination options:options handler:nil queue:nil];
+}
+
+- (id)subscribe:(NSString *)destination handler:(OFFTStompMessageHandler)handler queue:(dispatch_queue_t)queue {
+    return [self subscribe:destination options:nil handler:handler queue:queue];
+}
+
+- (id)subscribe:(NSString *)destination
+        options:(OFFTStompSubscriptionOptions *)options
+        handler:(OFFTStompMessageHandler)handler
+          queue:(dispatch_queue_t)queue {
     
-    NSString *identifier = [[NSUUID UUID] UUIDString];
-    
-    OFFTStompFrame *frame = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandSubscribe];
-    [frame setHeader:OFFTStompHeaderDestination value:destination];
-    [frame setHeader:OFFTStompHeaderID value:identifier];
+    // Numbered so that messages can be routed on the digits of their subscription header
+    const uint64_t number = atomic_fetch_add(&_lastSubscriptionNumber, 1) + 1;
+    NSString *identifier = [NSString stringWithFormat:@"%llu", number];
+    OFFTStompSubscription *subscription = [[OFFTStompSubscription alloc] initWithIdentifier:identifier
+                                                                                destination:destination
+                                                                                    options:options];
+    subscription.number = number;
+    subscription.handler = handler;
+    subscription.handlerQueue = queue;
     
-    [self sendFrame:frame];
+    [self performOnQueue:^{
+        self.subscriptions[identifier] = subscription;
+        self.subscriptionRoutes[@(number)] = subscription;
+        
+        // Otherwise it is sent once connected
+        if (self.state == OFFTStompStateConnected) {
+            [self sendFrame:[self subscribeFrameForSubscription:subscription]];
+        }
+    }];
     
-    return [[OFFTStompSubscription alloc] initWithIdentifier:identifier];
+    return subscription;
 }
 
 - (void)unsubscribe:(id)subscription {
@@ -188,10 +470,144 @@ typedef void(^OFFTStompReceiptHandler)();
     
     NSString *identifier = [(OFFTStompSubscription *)subscription identifier];
     
-    OFFTStompFrame *frame = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandUnsubscribe];
-    [frame setHeader:OFFTStompHeaderID value:identifier];
+    [self performOnQueue:^{
+        OFFTStompSubscription *existing = _subscriptions[identifier];
+        if (existing == nil) {
+            return;
+        }
+        [self.subscriptions removeObjectForKey:identifier];
+        [_subscriptionRoutes removeObjectForKey:@(existing.number)];
+        
+        if (self.state == OFFTStompStateConnected) {
+            [self sendWithheldAcksForSubscription:existing];
+            [self sendPendingAckForSubscription:identifier];
+            
+            OFFTStompFrame *frame = [self.framePool frameWithCommand:OFFTStompFrameCommandUnsubscribe];
+            [frame setHeader:OFFTStompHeaderID value:identifier];
+            
+            [self sendFrame:frame];
+        }
+    }];
+}
+
+#pragma mark - Public - Acknowledgement
+
+- (void)ackMessageWithHeaders:(id)headers {
+    [self acknowledgeMessageWithHeaders:headers command:OFFTStompFrameCommandAck transactionID:nil];
+}
+
+- (void)nackMessageWithHeaders:(id)headers {
+    [self acknowledgeMessageWithHeaders:headers command:OFFTStompFrameCommandNack transactionID:nil];
+}
+
+#pragma mark - Public - Transactions
+
+- (id)beginTransaction {
+    
+    __block OFFTStompTransaction *transaction = nil;
     
-    [self sendFrame:frame];
+    dispatch_block_t begin = ^{
+        // Transactions do not outlive the connection they were begun on
+        if (self.state != OFFTStompStateConnected) {
+            return;
+        }
+        
+        NSString *identifier = [[NSUUID UUID] UUIDString];
+        transaction = [[OFFTStompTransaction alloc] initWithIdentifier:identifier];
+        self.transactions[identifier] = transaction;
+        
+        OFFTStompFrame *frame = [self.framePool frameWithCommand:OFFTStompFrameCommandBegin];
+        [frame setHeader:OFFTStompHeaderTransaction value:identifier];
+        [self sendFrame:frame];
+    };
+    
+    // The caller is told straight away whether the transaction has begun
+    if ([self isOnQueue]) {
+        begin();
+    } else {
+        dispatch_sync(self.queue, begin);
+    }
+    
+    return transaction;
+}
+
+- (BOOL)sendMessageData:(NSData *)messageData
+          toDestination:(NSString *)destination
+      withCustomHeaders:(NSDictionary *)headers
+            transaction:(id)transaction {
+    
+    NSString *transactionID = [self identifierOfTransaction:transaction];
+    if (transactionID == nil) {
+        return NO;
+    }
+    
+    return [self sendMessageData:messageData
+            toDestination:destination
+        withCustomHeaders:headers
+           transactionID:transactionID];
+}
+
+- (void)ackMessageWithHeaders:(id)headers transaction:(id)transaction {
+    NSString *transactionID = [self identifierOfTransaction:transaction];
+    if (transactionID) {
+        [self acknowledgeMessageWithHeaders:headers command:OFFTStompFrameCommandAck transactionID:transactionID];
+    }
+}
+
+- (void)nackMessageWithHeaders:(id)headers transaction:(id)transaction {
+    NSString *transactionID = [self identifierOfTransaction:transaction];
+    if (transactionID) {
+        [self acknowledgeMessageWithHeaders:headers command:OFFTStompFrameCommandNack transactionID:transactionID];
+    }
+}
+
+- (void)commitTransaction:(id)transaction completion:(OFFTStompTransactionCompletion)completion {
+    NSString *transactionID = [self identifierOfTransaction:transaction];
+    if (transactionID == nil) {
+        return;
+    }
+    
+    completion = [completion copy] ?: ^(BOOL committed) {};
+    
+    [self performOnQueue:^{
+        OFFTStompTransaction *open = _transactions[transactionID];
+        if (open == nil || open.commitCompletion) {
+            [self performCompletion:^{
+                completion(NO);
+            }];
+            return;
+        }
+        open.commitCompletion = completion;
+        
+        OFFTStompFrame *frame = [self.framePool frameWithCommand:OFFTStompFrameCommandCommit];
+        [frame setHeader:OFFTStompHeaderTransaction value:transactionID];
+        
+        __weak typeof(self) weakSelf = self;
+        [self sendFrame:frame withReceiptHandler:^(BOOL received) {
+            [weakSelf transaction:transactionID committed:received];
+        }];
+    }];
+}
+
+- (void)abortTransaction:(id)transaction {
+    NSString *transactionID = [self identifierOfTransaction:transaction];
+    if (transactionID == nil) {
+        return;
+    }
+    
+    [self performOnQueue:^{
+        OFFTStompTransaction *open = _transactions[transactionID];
+        
+        // Too late once it has been committed
+        if (open == nil || open.commitCompletion) {
+            return;
+        }
+        [_transactions removeObjectForKey:transactionID];
+        
+        OFFTStompFrame *frame = [self.framePool frameWithCommand:OFFTStompFrameCommandAbort];
+        [frame setHeader:OFFTStompHeaderTransaction value:transactionID];
+        [self sendFrame:frame];
+    }];
 }
 
 #pragma mark - Transport Delegate
@@ -203,12 +619,17 @@ typedef void(^OFFTStompReceiptHandler)();
     
     // Construct the frame
     // 1.1 and 1.2 clients SHOULD continue to use the CONNECT command to remain backward compatible with STOMP 1.0 servers
-    OFFTStompFrame *frame = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandConnect];
+    OFFTStompFrame *frame = [self.framePool frameWithCommand:OFFTStompFrameCommandConnect];
     
     [frame setHeader:OFFTStompHeaderAcceptVersion value:OFFTStompAcceptVersions];
     [frame setHeader:OFFTStompHeaderHost value:[self.transport host]];
     
-    // TODO: Heartbeat
+    if (self.heartbeatSendInterval > 0 || self.heartbeatReceiveInterval > 0) {
+        NSString *heartbeat = [NSString stringWithFormat:@"%lu,%lu",
+                               (unsigned long)(self.heartbeatSendInterval * 1000),
+                               (unsigned long)(self.heartbeatReceiveInterval * 1000)];
+        [frame setHeader:OFFTStompHeaderHeartBeat value:heartbeat];
+    }
     
     // TODO: Login & password
     
@@ -217,18 +638,83 @@ typedef void(^OFFTStompReceiptHandler)();
 
 - (void)transportDidClose:(id<OFFTStompTransportAdapter>)transport {
     
-    // Wipe out the receipt handlers and reset the counter
-    _receiptHandlers = nil;
-    _receiptCounter = 0;
+    [self stopHeartbeat];
+    
+    // The server redelivers whatever they would have acknowledged, and aborts any open transaction
+    [self discardPendingAcks];
+    [self failTransactions];
+    for (OFFTStompSubscription *subscription in _subscriptions.allValues) {
+        [subscription.withheldAcks removeAllObjects];
+    }
+    
+    NSError *error = self.disconnectionError;
+    self.disconnectionError = nil;
+    
+    // Any partially received frame or unsent data belonged to the old connection
+    [_frameDecoder reset];
+    _pendingWrites = nil;
+    [self resetOutboundAccounting];
+    self.negotiatedVersion = OFFTStompVersionUnknown;
+    _frameSerializer.version = OFFTStompVersionUnknown;
+    
+    // The session survives for as long as the client keeps reconnecting,
+    // and receipts only wait while there is a connection to receive them on
+    if ([self shouldReconnect]) {
+        [_receiptTable failUnconfirmableReceipts];
+        [_receiptTable suspendDeadlines];
+        [self scheduleReconnect];
+        return;
+    }
     
     self.state = OFFTStompStateDisconnected;
-    [self.delegate stompClient:self didDisconnectWithError:nil];
+    [self endSession];
+    
+    [self notifyDelegate:^(id<OFFTStompClientDelegate> delegate) {
+        [delegate stompClient:self didDisconnectWithError:error];
+    }];
 }
 
 - (void)transport:(id<OFFTStompTransportAdapter>)transport didReceiveMessage:(NSString *)message {
-    NSLog(@"Received message: %@", message);
+    OFFTSTOMPLOG(@"Received message: %@", message);
+    
+    self.lastReceivedTime = CFAbsoluteTimeGetCurrent();
+    [self.frameDecoder appendData:[message dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didWriteDataOfLength:(NSUInteger)length {
+    [self outboundDataWrittenOfLength:length];
+}
+
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didFailWithError:(NSError *)error {
+    OFFTSTOMPLOG(@"Transport failed: %@", error);
+    
+    // Reported once the transport has closed, unless the client closed it for a reason of its own
+    if (self.disconnectionError == nil) {
+        self.disconnectionError = [NSError errorWithDomain:OFFTStompErrorDomain
+                                                      code:OFFTStompTransportError
+                                                  userInfo:@{ NSUnderlyingErrorKey : error }];
+    }
+}
+
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didReceiveData:(NSData *)data {
+    OFFTSTOMPLOG(@"Received %lu bytes", (unsigned long)data.length);
+    
+    self.lastReceivedTime = CFAbsoluteTimeGetCurrent();
+    [self.frameDecoder appendData:data];
+}
+
+#pragma mark - Frame Decoder Delegate
+
+- (void)frameDecoder:(OFFTStompFrameDecoder *)decoder didDecodeFrame:(OFFTStompFrame *)frame {
+    [self handleFrame:frame];
     
-    OFFTStompFrame *frame = [self deserializeFrameFromString:message];
+    // Nothing retains the frame once it has been handled
+    [self.framePool recycleFrame:frame];
+}
+
+#pragma mark - Private
+
+- (void)handleFrame:(OFFTStompFrame *)frame {
     
     if (self.state == OFFTStompStateConnecting) {
         // We're expecting either a CONNECTED frame...
@@ -238,10 +724,12 @@ typedef void(^OFFTStompReceiptHandler)();
         
         // or an ERROR
         else if (frame.command == OFFTStompFrameCommandError) {
-            self.state = OFFTStompStateDisconnected;
-            [self.delegate stompClient:self didDisconnectWithError:[NSError errorWithDomain:OFFTStompErrorDomain
-                                                                                       code:OFFTStompConnectionError
-                                                                                   userInfo:nil]];
+            // Reconnecting would be rejected again, so the session ends once the transport has closed
+            self.wantsConnection = NO;
+            self.disconnectionError = [NSError errorWithDomain:OFFTStompErrorDomain
+                                                          code:OFFTStompConnectionError
+                                                      userInfo:nil];
+            [self.transport close];
         }
         
         // Do no further message processing
@@ -252,274 +740,1098 @@ typedef void(^OFFTStompReceiptHandler)();
     if (frame.command == OFFTStompFrameCommandMessage) {
         [self handleMessageFrame:frame];
     }
-    // Handle receipt frames
+    // Handle receipt frames, whose receipt-id is always one of the client's integers
     else if (frame.command == OFFTStompFrameCommandReceipt) {
-        NSString *receipt = [frame valueForHeader:OFFTStompHeaderReceipt];
-        OFFTStompReceiptHandler handler = _receiptHandlers[receipt];
-        if (handler) {
-            handler();
-            [_receiptHandlers removeObjectForKey:receipt];
+        uint64_t receipt = 0;
+        if ([frame getUnsignedIntegerValue:&receipt forHeaderName:OFFTStompHeaderNameReceiptID]) {
+            [_receiptTable completeReceipt:receipt];
         }
     }
 }
 
-#pragma mark - Private
-
 - (void)sendFrame:(OFFTStompFrame *)frame {
+    [self sendFrame:frame unconfirmedReceipt:0];
+}
+
+/**
+ *  Sends a frame, keeping a copy of it to send again after
+ *  reconnecting when the receipt is provided.
+ */
+- (void)sendFrame:(OFFTStompFrame *)frame unconfirmedReceipt:(uint64_t)receipt {
     if (self.state == OFFTStompStateDisconnecting
     && frame.command != OFFTStompFrameCommandDisconnect) {
         NSAssert(0, @"Cannot send frames while in the process of disconnecting");
+        [self.framePool recycleFrame:frame];
         return;
     }
     
-    NSData *serializedFrame = [self serializeFrame:frame];
+    if (frame.body.length >= OFFTStompScatterGatherBodyLength
+    && [self.transport respondsToSelector:@selector(sendDataParts:)]) {
+        
+        NSArray *parts = [self.frameSerializer serializeFrameParts:frame];
+        [self.framePool recycleFrame:frame];
+        
+        OFFTSTOMPLOG(@"Sending frame in %lu parts", (unsigned long)parts.count);
+        
+        NSUInteger length = 0;
+        for (NSData *part in parts) {
+            length += part.length;
+        }
+        [self trackOutboundFrameOfLength:length];
+        
+        // Kept as they are, the body is never copied
+        if (receipt) {
+            [self.receiptTable setFrameParts:parts forReceipt:receipt];
+        }
+        
+        // Keep frames in order
+        [self flushPendingWrites];
+        [self.transport sendDataParts:parts];
+        [self transportAcceptedDataOfLength:length];
+        return;
+    }
+    
+    NSData *serializedFrame = [self.frameSerializer serializeFrame:frame];
+    [self.framePool recycleFrame:frame];
     
 #if OFFTSTOMPDEBUG
     NSLog(@"Sending message: %@", [[NSString alloc] initWithData:serializedFrame encoding:NSUTF8StringEncoding]);
 #endif
     
-    [self.transport sendData:serializedFrame];
+    if (receipt) {
+        [self.receiptTable setFrameParts:@[serializedFrame] forReceipt:receipt];
+    }
+    
+    [self trackOutboundFrameOfLength:serializedFrame.length];
+    [self writeData:serializedFrame];
 }
 
 - (void)sendFrame:(OFFTStompFrame *)frame withReceiptHandler:(OFFTStompReceiptHandler)receiptHandler {
     
-    // Associate a receipt header with this frame before it is sent
-    NSString *receipt = [NSString stringWithFormat:@"%lu", ++self.receiptCounter];
-    [frame setHeader:OFFTStompHeaderReceipt value:receipt];
+    // Track this receipt request, and associate its receipt header with the frame before it is sent
+    const uint64_t receipt = [self.receiptTable addReceiptWithTimeout:self.receiptTimeout handler:receiptHandler];
+    [frame setHeader:OFFTStompHeaderReceipt value:[NSString stringWithFormat:@"%llu", receipt]];
     
-    // Track this receipt request
-    self.receiptHandlers[receipt] = receiptHandler;
-    
-    [self sendFrame:frame];
+    // A DISCONNECT is never sent again, as the client does not reconnect once it has been sent,
+    // nor a COMMIT, as its transaction is aborted along with the connection
+    BOOL resend = self.automaticallyReconnects
+               && frame.command != OFFTStompFrameCommandDisconnect
+               && frame.command != OFFTStompFrameCommandCommit;
+    [self sendFrame:frame unconfirmedReceipt:resend ? receipt : 0];
 }
 
-- (void)forceDisconnect {
-    [self.transport close];
+- (OFFTStompFrame *)subscribeFrameForSubscription:(OFFTStompSubscription *)subscription {
+    OFFTStompFrame *frame = [self.framePool frameWithCommand:OFFTStompFrameCommandSubscribe];
+    
+    OFFTStompSubscriptionOptions *options = subscription.options;
+    [options.headers enumerateKeysAndObjectsUsingBlock:^(id header, id value, BOOL *stop) {
+        if ([header isKindOfClass:[NSString class]]
+        && [value isKindOfClass:[NSString class]]) {
+            [frame setHeader:header value:value];
+        } else {
+            NSAssert(0, @"Subscription headers (and their values) must be strings.");
+        }
+    }];
+    
+    // Understood by ActiveMQ and RabbitMQ respectively, and ignored by other brokers
+    if (options.prefetchCount > 0) {
+        NSString *prefetchCount = [NSString stringWithFormat:@"%lu", (unsigned long)options.prefetchCount];
+        if (options.headers[@"activemq.prefetchSize"] == nil) {
+            [frame setHeader:@"activemq.prefetchSize" value:prefetchCount];
+        }
+        if (options.headers[@"prefetch-count"] == nil) {
+            [frame setHeader:@"prefetch-count" value:prefetchCount];
+        }
+    }
+    
+    // Set last so they replace any custom headers of the same name
+    [frame setHeader:OFFTStompHeaderDestination value:subscription.destination];
+    [frame setHeader:OFFTStompHeaderID value:subscription.identifier];
+    
+    switch (subscription.ackMode) {
+        case OFFTStompAckModeAuto:
+            // The default, so it needn't be sent
+            break;
+        case OFFTStompAckModeClient:
+            [frame setHeader:OFFTStompHeaderAck value:@"client"];
+            break;
+        case OFFTStompAckModeClientIndividual:
+            [frame setHeader:OFFTStompHeaderAck value:@"client-individual"];
+            break;
+    }
+    return frame;
 }
 
-#pragma mark - Private - Frame Handlers
+- (void)forceDisconnect {
+    [self flushPendingWrites];
+    [self.transport close];
+}
 
-- (void)handleConnectedFrame:(OFFTStompFrame *)frame {
+/**
+ *  Builds a SEND frame, or returns nil if the custom headers are invalid.
+ */
+- (OFFTStompFrame *)messageFrameWithData:(NSData *)messageData
+                           toDestination:(NSString *)destination
+                       withCustomHeaders:(NSDictionary *)headers {
     
-    NSString *negotiatedVersion = [frame valueForHeader:OFFTStompHeaderVersion];
-    if ([negotiatedVersion isEqualToString:@"1.2"]) {
-        self.negotiatedVersion = OFFTStompVersion1_2;
-    } else if ([negotiatedVersion isEqualToString:@"1.1"]) {
-        self.negotiatedVersion = OFFTStompVersion1_1;
-    } else {
-        NSAssert(0, @"Somehow managed to negotiate to an unknown protocol version.");
+    __block BOOL invalidHeaders = NO;
+    
+    __block OFFTStompFrame *frame = [self.framePool frameWithCommand:OFFTStompFrameCommandSend];
+    
+    // Add the user defined headers, ensuring they are comprised only of strings
+    [headers enumerateKeysAndObjectsUsingBlock:^(id header, id value, BOOL *stop) {
+        if ([header isKindOfClass:[NSString class]]
+        && [value isKindOfClass:[NSString class]]) {
+            
+            [frame setHeader:header value:value];
+            
+        } else {
+            NSAssert(0, @"Custom headers (and their values) must be strings.");
+            *stop = YES;
+            invalidHeaders = YES;
+        }
+    }];
+    
+    // Needed if NS_BLOCK_ASSERTIONS is enabled
+    if (invalidHeaders) {
+        [self.framePool recycleFrame:frame];
+        return nil;
     }
     
-    self.state = OFFTStompStateConnected;
-    [self.delegate stompClientDidConnect:self];
+    // The content-length header is written by the serializer
+    [frame setHeader:OFFTStompHeaderDestination value:destination];
+    [frame setBody:messageData];
+    
+    return frame;
 }
 
-- (void)handleMessageFrame:(OFFTStompFrame *)frame {
+#pragma mark - Private - Heart-beating
+
+// http://stomp.github.io/stomp-specification-1.2.html#Heart-beating
+- (void)startHeartbeatWithServerHeartbeat:(NSString *)serverHeartbeat {
+    [self stopHeartbeat];
     
-    // Data version of delegate method takes precendence
-    if ([self.delegate respondsToSelector:@selector(stompClient:receivedMessageData:withHeaders:)]) {
-        
-        [self.delegate stompClient:self
-               receivedMessageData:[frame body]
-                       withHeaders:[frame allHeaders]];
-        
+    NSArray *components = [serverHeartbeat componentsSeparatedByString:@","];
+    if (components.count != 2) {
+        return;
     }
-    // Fall back to the string-based delegate method
-    else if ([self.delegate respondsToSelector:@selector(stompClient:receivedMessage:withHeaders:)]) {
-        
-        NSString *message = [[NSString alloc] initWithData:frame.body
-                                                  encoding:NSUTF8StringEncoding];
-        [self.delegate stompClient:self
-                   receivedMessage:message
-                       withHeaders:[frame allHeaders]];
-        
+    
+    NSTimeInterval serverSendInterval = [components[0] integerValue] / 1000.0;
+    NSTimeInterval serverReceiveInterval = [components[1] integerValue] / 1000.0;
+    
+    // Each side uses the slower of what one offers and the other asks for, 0 if either declines
+    NSTimeInterval sendInterval = 0;
+    if (self.heartbeatSendInterval > 0 && serverReceiveInterval > 0) {
+        sendInterval = MAX(self.heartbeatSendInterval, serverReceiveInterval);
+    }
+    NSTimeInterval receiveInterval = 0;
+    if (self.heartbeatReceiveInterval > 0 && serverSendInterval > 0) {
+        receiveInterval = MAX(self.heartbeatReceiveInterval, serverSendInterval);
+    }
+    
+    OFFTStompTimingWheel *wheel = [OFFTStompTimingWheel sharedWheel];
+    __weak typeof(self) weakSelf = self;
+    
+    if (sendInterval > 0) {
+        // Checking twice per interval keeps the gap between writes within it
+        self.sentSinceHeartbeat = YES;
+        self.sendHeartbeatTimer = [wheel scheduleTimerWithInterval:sendInterval / 2 queue:self.queue handler:^{
+            [weakSelf sendHeartbeatIfIdle];
+        }];
+    }
+    
+    if (receiveInterval > 0) {
+        // Checking twice per interval notices silence soon after the timeout, rather than up to a whole timeout later
+        self.lastReceivedTime = CFAbsoluteTimeGetCurrent();
+        self.receiveTimeout = receiveInterval * OFFTStompHeartbeatTolerance;
+        self.receiveHeartbeatTimer = [wheel scheduleTimerWithInterval:receiveInterval / 2 queue:self.queue handler:^{
+            [weakSelf checkServerIsAlive];
+        }];
     }
 }
 
-#pragma mark - Private - Utilities
+- (void)stopHeartbeat {
+    [self.sendHeartbeatTimer cancel];
+    [self.receiveHeartbeatTimer cancel];
+    self.sendHeartbeatTimer = nil;
+    self.receiveHeartbeatTimer = nil;
+}
 
-- (NSString *)stringForCommand:(OFFTStompFrameCommand)command {
-    switch (command) {
-        case OFFTStompFrameCommandMessage:
-            return @"MESSAGE";
+- (void)sendHeartbeatIfIdle {
+    if (self.state != OFFTStompStateConnected) {
+        return;
+    }
+    
+    if (self.sentSinceHeartbeat) {
+        self.sentSinceHeartbeat = NO;
+        return;
+    }
+    
+    static const uint8_t OFFTStompHeartbeat = '\n';
+    NSData *heartbeat = [NSData dataWithBytesNoCopy:(void *)&OFFTStompHeartbeat length:1 freeWhenDone:NO];
+    
+    [self trackOutboundFrameOfLength:heartbeat.length];
+    [self writeData:heartbeat];
+}
 
-        case OFFTStompFrameCommandSend:
-            return @"SEND";
-            
-        case OFFTStompFrameCommandSubscribe:
-            return @"SUBSCRIBE";
-            
-        case OFFTStompFrameCommandUnsubscribe:
-            return @"UNSUBSCRIBE";
-            
-        case OFFTStompFrameCommandError:
-            return @"ERROR";
-            
-        case OFFTStompFrameCommandReceipt:
-            return @"RECEIPT";
-            
-        case OFFTStompFrameCommandConnect:
-            return @"CONNECT";
-            
-        case OFFTStompFrameCommandConnected:
-            return @"CONNECTED";
-            
-        case OFFTStompFrameCommandDisconnect:
-            return @"DISCONNECT";
-            
-        default:
-            return nil;
+- (void)checkServerIsAlive {
+    if (self.state != OFFTStompStateConnected) {
+        return;
+    }
+    
+    if (CFAbsoluteTimeGetCurrent() - self.lastReceivedTime < self.receiveTimeout) {
+        return;
     }
+    
+    OFFTSTOMPLOG(@"Nothing received within the heart-beat interval, closing the connection");
+    
+    self.disconnectionError = [NSError errorWithDomain:OFFTStompErrorDomain
+                                                  code:OFFTStompHeartbeatTimeoutError
+                                              userInfo:nil];
+    [self stopHeartbeat];
+    [self.transport close];
 }
 
-- (OFFTStompFrameCommand)commandForString:(NSString *)commandString {
-    if ([commandString isEqualToString:@"MESSAGE"]) {
-        return OFFTStompFrameCommandMessage;
-        
-    } else if ([commandString isEqualToString:@"SEND"]) {
-        return OFFTStompFrameCommandSend;
-        
-    } else if ([commandString isEqualToString:@"SUBSCRIBE"]) {
-        return OFFTStompFrameCommandSubscribe;
-        
-    } else if ([commandString isEqualToString:@"UNSUBSCRIBE"]) {
-        return OFFTStompFrameCommandUnsubscribe;
-        
-    } else if ([commandString isEqualToString:@"ERROR"]) {
-        return OFFTStompFrameCommandError;
+#pragma mark - Private - Acknowledgement
+
+- (void)acknowledgeMessageWithHeaders:(id)headers command:(OFFTStompFrameCommand)command transactionID:(NSString *)transactionID {
+    // Protection
+    if ([headers respondsToSelector:@selector(objectForKeyedSubscript:)] == NO) {
+        NSAssert(0, @"You must provide the headers of a received message.");
+        return;
+    }
+    
+    // 1.2 messages that must be acknowledged have an ack header, 1.1 messages are identified by their message-id
+    NSString *subscriptionID = headers[OFFTStompHeaderSubscription];
+    NSString *ackID = headers[OFFTStompHeaderAck] ?: headers[OFFTStompHeaderMessageID];
+    if (subscriptionID == nil || ackID == nil) {
+        NSAssert(0, @"The message has neither an ack nor a message-id header.");
+        return;
+    }
+    
+    [self performOnQueue:^{
+        OFFTStompSubscription *subscription = _subscriptions[subscriptionID];
+        if (self.state != OFFTStompStateConnected
+        || subscription == nil
+        || subscription.ackMode == OFFTStompAckModeAuto) {
+            return;
+        }
         
-    } else if ([commandString isEqualToString:@"RECEIPT"]) {
-        return OFFTStompFrameCommandReceipt;
+        // Takes effect once committed, so is sent straight away
+        if (transactionID) {
+            if (_transactions[transactionID] == nil) {
+                return;
+            }
+            [self sendPendingAckForSubscription:subscriptionID];
+            
+            OFFTStompFrame *frame = [self frameWithCommand:command ackID:ackID subscriptionID:subscriptionID];
+            [frame setHeader:OFFTStompHeaderTransaction value:transactionID];
+            [self sendFrame:frame];
+            return;
+        }
         
-    } else if ([commandString isEqualToString:@"CONNECT"]) {
-        return OFFTStompFrameCommandConnect;
+        // The server sends no more messages until the delegate has caught up
+        if ([self isFlowControlledSubscription:subscription]
+        && subscription.queuedMessageCount > subscription.options.prefetchCount) {
+            [subscription.withheldAcks addObject:@[ @(command), ackID ]];
+            return;
+        }
         
-    } else if ([commandString isEqualToString:@"CONNECTED"]) {
-        return OFFTStompFrameCommandConnected;
+        [self acknowledgeWithCommand:command ackID:ackID subscription:subscription];
+    }];
+}
+
+- (void)acknowledgeWithCommand:(OFFTStompFrameCommand)command ackID:(NSString *)ackID subscription:(OFFTStompSubscription *)subscription {
+    NSString *subscriptionID = subscription.identifier;
+    
+    if (command == OFFTStompFrameCommandAck
+    && subscription.ackMode == OFFTStompAckModeClient
+    && [self batchesAcks]) {
+        [self batchAck:ackID forSubscription:subscription];
+        return;
+    }
+    
+    // A NACK must not overtake the acknowledgement of an earlier message
+    [self sendPendingAckForSubscription:subscriptionID];
+    [self sendFrame:[self frameWithCommand:command ackID:ackID subscriptionID:subscriptionID]];
+}
+
+#pragma mark - Private - Transactions
+
+- (NSString *)identifierOfTransaction:(id)transaction {
+    // Protection
+    if ([transaction isKindOfClass:[OFFTStompTransaction class]] == NO) {
+        NSAssert(0, @"You must provide an OFFTStompTransaction object.");
+        return nil;
+    }
+    return [(OFFTStompTransaction *)transaction identifier];
+}
+
+- (void)transaction:(NSString *)transactionID committed:(BOOL)committed {
+    OFFTStompTransaction *transaction = _transactions[transactionID];
+    if (transaction == nil) {
+        return;
+    }
+    [_transactions removeObjectForKey:transactionID];
+    
+    OFFTStompTransactionCompletion completion = transaction.commitCompletion;
+    [self performCompletion:^{
+        completion(committed);
+    }];
+}
+
+/**
+ *  Fails the commit of every open transaction, which the server has aborted along with the connection.
+ */
+- (void)failTransactions {
+    NSDictionary *transactions = _transactions;
+    _transactions = nil;
+    
+    for (OFFTStompTransaction *transaction in transactions.allValues) {
+        OFFTStompTransactionCompletion completion = transaction.commitCompletion;
+        if (completion) {
+            [self performCompletion:^{
+                completion(NO);
+            }];
+        }
+    }
+}
+
+#pragma mark - Private - Confirmed Sends
+
+- (void)sendConfirmedMessageData:(NSData *)messageData
+                   toDestination:(NSString *)destination
+               withCustomHeaders:(NSDictionary *)headers
+                      completion:(OFFTStompSendCompletion)completion {
+    
+    OFFTStompFrame *frame = [self messageFrameWithData:messageData toDestination:destination withCustomHeaders:headers];
+    if (frame == nil) {
+        [self performCompletion:^{
+            completion(NO);
+        }];
+        return;
+    }
+    
+    ++self.confirmedSendsInFlight;
+    
+    __weak typeof(self) weakSelf = self;
+    [self sendFrame:frame withReceiptHandler:^(BOOL received) {
+        [weakSelf confirmedSendCompleted:completion confirmed:received];
+    }];
+}
+
+- (void)confirmedSendCompleted:(OFFTStompSendCompletion)completion confirmed:(BOOL)confirmed {
+    --self.confirmedSendsInFlight;
+    [self performCompletion:^{
+        completion(confirmed);
+    }];
+    
+    if (self.state == OFFTStompStateConnected) {
+        [self sendWaitingConfirmedSendsIgnoringWindow:NO];
+    }
+}
+
+- (void)sendWaitingConfirmedSendsIgnoringWindow:(BOOL)ignoringWindow {
+    while (_waitingConfirmedSends.count > 0
+    && (ignoringWindow || self.confirmedSendWindow == 0 || self.confirmedSendsInFlight < self.confirmedSendWindow)) {
+        void (^send)(BOOL) = _waitingConfirmedSends[0];
+        [_waitingConfirmedSends removeObjectAtIndex:0];
+        send(YES);
+    }
+}
+
+/**
+ *  Completes every confirmed send still waiting for room in the window, unsent.
+ */
+- (void)failWaitingConfirmedSends {
+    NSArray *waitingConfirmedSends = _waitingConfirmedSends;
+    _waitingConfirmedSends = nil;
+    
+    for (void (^send)(BOOL) in waitingConfirmedSends) {
+        send(NO);
+    }
+}
+
+/**
+ *  Calls a completion block on the delegate queue if one has been set.
+ */
+- (void)performCompletion:(dispatch_block_t)completion {
+    dispatch_queue_t delegateQueue = self.delegateQueue;
+    if (delegateQueue) {
+        dispatch_async(delegateQueue, completion);
+    } else {
+        completion();
+    }
+}
+
+#pragma mark - Private - Flow Control
+
+- (BOOL)isFlowControlledSubscription:(OFFTStompSubscription *)subscription {
+    return subscription.options.prefetchCount > 0 && subscription.ackMode != OFFTStompAckModeAuto;
+}
+
+/**
+ *  Finds a received message's subscription from the digits of its subscription header.
+ */
+- (OFFTStompSubscription *)subscriptionForFrame:(OFFTStompFrame *)frame {
+    uint64_t number = 0;
+    if (_subscriptionRoutes.count == 0
+    || [frame getUnsignedIntegerValue:&number forHeaderName:OFFTStompHeaderNameSubscription] == NO) {
+        return nil;
+    }
+    return _subscriptionRoutes[@(number)];
+}
+
+/**
+ *  Called on the delegate or handler queue once a message has been handled.
+ */
+- (void)delegateHandledMessageForSubscription:(OFFTStompSubscription *)subscription {
+    if (subscription == nil) {
+        return;
+    }
+    
+    [self performOnQueue:^{
+        subscription.queuedMessageCount -= MIN(1, subscription.queuedMessageCount);
         
-    } else if ([commandString isEqualToString:@"DISCONNECT"]) {
-        return OFFTStompFrameCommandDisconnect;
+        if (subscription.queuedMessageCount <= subscription.options.prefetchCount
+        && self.state == OFFTStompStateConnected
+        && _subscriptions[subscription.identifier] == subscription) {
+            [self sendWithheldAcksForSubscription:subscription];
+        }
+    }];
+}
+
+- (void)sendWithheldAcksForSubscription:(OFFTStompSubscription *)subscription {
+    if (subscription.withheldAcks.count == 0) {
+        return;
+    }
+    
+    NSArray *withheldAcks = [subscription.withheldAcks copy];
+    [subscription.withheldAcks removeAllObjects];
+    
+    for (NSArray *withheldAck in withheldAcks) {
+        [self acknowledgeWithCommand:[withheldAck[0] unsignedIntegerValue] ackID:withheldAck[1] subscription:subscription];
+    }
+}
+
+- (BOOL)batchesAcks {
+    return self.ackBatchSize > 1 || (self.ackBatchSize == 0 && self.ackBatchInterval > 0);
+}
+
+- (void)batchAck:(NSString *)ackID forSubscription:(OFFTStompSubscription *)subscription {
+    // In client mode acknowledging the latest message acknowledges every earlier one
+    self.pendingAcks[subscription.identifier] = ackID;
+    ++self.pendingAckCount;
+    ++subscription.batchedAckCount;
+    
+    // The server sends nothing more until the prefetch window has been acknowledged
+    if ([self isFlowControlledSubscription:subscription]
+    && subscription.batchedAckCount >= subscription.options.prefetchCount) {
+        [self sendPendingAckForSubscription:subscription.identifier];
+    } else if (self.ackBatchSize > 0 && self.pendingAckCount >= self.ackBatchSize) {
+        [self sendPendingAcks];
+    } else if (self.ackBatchInterval > 0) {
+        [self scheduleAckFlush];
+    }
+}
+
+- (void)scheduleAckFlush {
+    if (self.ackFlushScheduled) {
+        return;
+    }
+    self.ackFlushScheduled = YES;
+    
+    const NSUInteger generation = self.ackFlushGeneration;
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.ackBatchInterval * NSEC_PER_SEC)), self.queue, ^{
+        typeof(self) strongSelf = weakSelf;
         
-    } else {
-        return OFFTStompFrameCommandUnknown;
+        // The batch it was scheduled for has already been sent
+        if (strongSelf.ackFlushGeneration != generation) {
+            return;
+        }
+        [strongSelf sendPendingAcks];
+    });
+}
+
+- (void)cancelAckFlush {
+    self.ackFlushScheduled = NO;
+    ++self.ackFlushGeneration;
+}
+
+/**
+ *  Sends one cumulative ACK for each subscription with acknowledgements waiting.
+ */
+- (void)sendPendingAcks {
+    [self cancelAckFlush];
+    
+    if (_pendingAcks.count == 0) {
+        return;
     }
+    if (self.state != OFFTStompStateConnected) {
+        [self discardPendingAcks];
+        return;
+    }
+    
+    NSDictionary *pendingAcks = _pendingAcks;
+    [self discardPendingAcks];
+    
+    [pendingAcks enumerateKeysAndObjectsUsingBlock:^(NSString *subscriptionID, NSString *ackID, BOOL *stop) {
+        [self sendFrame:[self frameWithCommand:OFFTStompFrameCommandAck ackID:ackID subscriptionID:subscriptionID]];
+    }];
 }
 
-#pragma mark - Private - Frame Conversion
+- (void)sendPendingAckForSubscription:(NSString *)subscriptionID {
+    NSString *ackID = _pendingAcks[subscriptionID];
+    if (ackID == nil) {
+        return;
+    }
+    
+    [_pendingAcks removeObjectForKey:subscriptionID];
+    [_subscriptions[subscriptionID] setBatchedAckCount:0];
+    if (_pendingAcks.count == 0) {
+        _pendingAckCount = 0;
+        [self cancelAckFlush];
+    }
+    
+    [self sendFrame:[self frameWithCommand:OFFTStompFrameCommandAck ackID:ackID subscriptionID:subscriptionID]];
+}
 
-- (NSData *)serializeFrame:(OFFTStompFrame *)frame {
+- (void)discardPendingAcks {
+    for (NSString *subscriptionID in _pendingAcks) {
+        [_subscriptions[subscriptionID] setBatchedAckCount:0];
+    }
+    _pendingAcks = nil;
+    _pendingAckCount = 0;
+    [self cancelAckFlush];
+}
 
-    NSData *eol = nil;
-    // STOMP 1.2 uses OPTIONAL carriage return + REQUIRED line feed
-    // http://stomp.github.io/stomp-specification-1.2.html#STOMP_Frames
+// https://stomp.github.io/stomp-specification-1.2.html#ACK
+// https://stomp.github.io/stomp-specification-1.1.html#ACK
+- (OFFTStompFrame *)frameWithCommand:(OFFTStompFrameCommand)command ackID:(NSString *)ackID subscriptionID:(NSString *)subscriptionID {
+    OFFTStompFrame *frame = [self.framePool frameWithCommand:command];
+    
     if (self.negotiatedVersion == OFFTStompVersion1_2) {
-        eol = [@"\r\n" dataUsingEncoding:NSUTF8StringEncoding];
+        [frame setHeader:OFFTStompHeaderID value:ackID];
+    } else {
+        [frame setHeader:OFFTStompHeaderMessageID value:ackID];
+        [frame setHeader:OFFTStompHeaderSubscription value:subscriptionID];
     }
-    // Older versions use only line feed
-    // http://stomp.github.io/stomp-specification-1.1.html#STOMP_Frames
-    // http://stomp.github.io/stomp-specification-1.0.html
-    else {
-        eol = [@"\n" dataUsingEncoding:NSUTF8StringEncoding];
+    return frame;
+}
+
+#pragma mark - Private - Reconnection
+
+- (BOOL)shouldReconnect {
+    if (self.automaticallyReconnects == NO
+    || self.wantsConnection == NO
+    || self.state == OFFTStompStateDisconnecting) {
+        return NO;
     }
+    return self.maximumReconnectAttempts == 0 || self.reconnectAttempts < self.maximumReconnectAttempts;
+}
+
+- (void)scheduleReconnect {
+    const NSUInteger attempt = ++self.reconnectAttempts;
     
-    NSData *nullByte = [@"\0" dataUsingEncoding:NSUTF8StringEncoding];
+    // Exponential backoff with full jitter
+    NSTimeInterval delay = MIN(self.reconnectMaximumDelay, self.reconnectInitialDelay * pow(2, MIN(attempt - 1, 32)));
+    delay *= (double)arc4random_uniform(UINT32_MAX) / UINT32_MAX;
     
-    // Start with the command
-    NSString *command = [self stringForCommand:frame.command];
-    NSMutableData *data = [NSMutableData dataWithData:[command dataUsingEncoding:NSUTF8StringEncoding]];
-    [data appendData:eol];
+    self.state = OFFTStompStateConnecting;
+    self.reconnectScheduled = YES;
     
-    // Append the headers, each followed with a newline
-    NSDictionary *frameHeaders = [frame allHeaders];
-    for (NSString *key in frameHeaders) {
-        
-        // TODO: escape colons
-        // http://stomp.github.io/stomp-specification-1.1.html#Value_Encoding
+    [self notifyDelegate:^(id<OFFTStompClientDelegate> delegate) {
+        if ([delegate respondsToSelector:@selector(stompClient:willReconnectAfterDelay:attempt:)]) {
+            [delegate stompClient:self willReconnectAfterDelay:delay attempt:attempt];
+        }
+    }];
+    
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), self.queue, ^{
+        typeof(self) strongSelf = weakSelf;
         
-        NSString *headerLine = [NSString stringWithFormat:@"%@:%@", key, frameHeaders[key]];
-        [data appendData:[headerLine dataUsingEncoding:NSUTF8StringEncoding]];
-        [data appendData:eol];
+        // Cancelled by a call to connect or disconnect in the meantime
+        if (strongSelf.reconnectScheduled == NO || strongSelf.reconnectAttempts != attempt) {
+            return;
+        }
+        strongSelf.reconnectScheduled = NO;
+        [strongSelf.transport open];
+    }];
+}
+
+/**
+ *  Subscribes again to every active subscription, and sends again
+ *  every frame whose receipt has not arrived, in a single write.
+ */
+- (void)restoreSession {
+    [_receiptTable resumeDeadlines];
+    
+    NSArray *unconfirmedParts = [_receiptTable unconfirmedFrameParts];
+    if (_subscriptions.count == 0 && unconfirmedParts.count == 0) {
+        [self sendWaitingConfirmedSendsIgnoringWindow:NO];
+        return;
     }
     
-    // End the headers with an additional newline
-    [data appendData:eol];
+    // SUBSCRIBE frames are small, so are gathered into one part
+    NSMutableData *subscribeFrames = [[NSMutableData alloc] init];
+    for (OFFTStompSubscription *subscription in _subscriptions.allValues) {
+        OFFTStompFrame *frame = [self subscribeFrameForSubscription:subscription];
+        [subscribeFrames appendData:[self.frameSerializer serializeFrame:frame]];
+        [self.framePool recycleFrame:frame];
+    }
     
-    // Append the body data
-    if (frame.body) {
-        [data appendData:frame.body];
+    // Unconfirmed frames may have large bodies, so are sent as they are, in the order they were first sent
+    NSMutableArray *parts = [[NSMutableArray alloc] initWithCapacity:unconfirmedParts.count + 1];
+    NSUInteger length = subscribeFrames.length;
+    if (subscribeFrames.length > 0) {
+        [parts addObject:subscribeFrames];
+    }
+    for (NSData *part in unconfirmedParts) {
+        [parts addObject:part];
+        length += part.length;
     }
     
-    // End the frame with a NULL byte
-    [data appendData:nullByte];
+    [self trackOutboundFrameOfLength:length];
+    [self flushPendingWrites];
+    [self sendParts:parts];
+    [self transportAcceptedDataOfLength:length];
     
-    return data;
+    // Confirmed sends that were waiting when the connection was lost
+    [self sendWaitingConfirmedSendsIgnoringWindow:NO];
 }
 
-- (OFFTStompFrame *)deserializeFrameFromString:(NSString *)frameString {
-    NSArray *lines = [frameString componentsSeparatedByString:@"\n"];
+/**
+ *  Writes the parts in one go, concatenating them when the transport cannot gather them itself.
+ */
+- (void)sendParts:(NSArray *)parts {
+    if (parts.count == 1) {
+        [self.transport sendData:parts.firstObject];
+        return;
+    }
+    if ([self.transport respondsToSelector:@selector(sendDataParts:)]) {
+        [self.transport sendDataParts:parts];
+        return;
+    }
     
-    if (lines.count > 1) {
-        
-        OFFTStompFrameCommand command = [self commandForString:lines[0]];
-        if (command != OFFTStompFrameCommandUnknown) {
-            OFFTStompFrame *frame = [[OFFTStompFrame alloc] initWithCommand:command];
-            
-            // Parse headers
-            for (int i=1; i < lines.count; ++i) {
-                
-                // TODO: decode colons
-                // http://stomp.github.io/stomp-specification-1.1.html#Value_Encoding
-                
-                NSString *line = lines[i];
-                NSUInteger indexOfFirstColon = [line rangeOfString:@":"].location;
-                
-                if (indexOfFirstColon == NSNotFound) {
-                    break;
-                }
-                
-                NSString *headerName = [line substringToIndex:indexOfFirstColon];
-                NSString *headerValue = [line substringFromIndex:indexOfFirstColon + 1];
-                
-                // Don't overwrite existing headers
-                // http://stomp.github.io/stomp-specification-1.2.html#Repeated_Header_Entries
-                // http://stomp.github.io/stomp-specification-1.1.html#Repeated_Header_Entries
-                if ([frame valueForHeader:headerName] == nil) {
-                    [frame setHeader:headerName value:headerValue];
+    NSMutableData *data = [[NSMutableData alloc] init];
+    for (NSData *part in parts) {
+        [data appendData:part];
+    }
+    [self.transport sendData:data];
+}
+
+/**
+ *  Forgets everything that would otherwise be restored after reconnecting.
+ */
+- (void)endSession {
+    // Before the receipts, whose handlers would otherwise send them
+    [self failWaitingConfirmedSends];
+    [_receiptTable failAllReceipts];
+    _subscriptions = nil;
+    _subscriptionRoutes = nil;
+    _reconnectAttempts = 0;
+}
+
+#pragma mark - Private - Write Coalescing
+
+/**
+ *  Writes a serialized frame to the transport, or appends it to the
+ *  pending writes to be sent along with other frames when coalescing.
+ */
+- (void)writeData:(NSData *)data {
+    if (self.coalescesWrites == NO) {
+        [self.transport sendData:data];
+        [self transportAcceptedDataOfLength:data.length];
+        return;
+    }
+    
+    [self.pendingWrites appendData:data];
+    
+    if (self.pendingWrites.length >= self.coalescingByteThreshold) {
+        [self flushPendingWrites];
+    } else {
+        [self scheduleFlush];
+    }
+}
+
+/**
+ *  Flushes the pending writes at the end of the current queue turn,
+ *  or once the coalescing interval has passed.
+ */
+- (void)scheduleFlush {
+    if (self.flushScheduled) {
+        return;
+    }
+    self.flushScheduled = YES;
+    
+    __weak typeof(self) weakSelf = self;
+    dispatch_block_t flush = ^{
+        [weakSelf flushPendingWrites];
+    };
+    
+    if (self.coalescingInterval > 0) {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.coalescingInterval * NSEC_PER_SEC)), self.queue, flush);
+    } else {
+        dispatch_async(self.queue, flush);
+    }
+}
+
+- (void)flushPendingWrites {
+    self.flushScheduled = NO;
+    
+    if (_pendingWrites.length == 0) {
+        return;
+    }
+    
+    // Handed over to the transport, the next frame starts a new buffer
+    NSData *pendingWrites = _pendingWrites;
+    _pendingWrites = nil;
+    [self.transport sendData:pendingWrites];
+    
+    [self transportAcceptedDataOfLength:pendingWrites.length];
+}
+
+#pragma mark - Private - Outbound Accounting
+
+/**
+ *  Applies the outbound policy to a message about to be sent.
+ *
+ *  @param rejected On return, whether the caller should be told the message was not sent.
+ *
+ *  @return Whether the message should be sent.
+ */
+- (BOOL)shouldSendOutboundMessage:(BOOL *)rejected {
+    if (self.outboundHighWatermark == 0) {
+        return YES;
+    }
+    
+    BOOL shouldSend = YES;
+    
+    [self.outboundCondition lock];
+    if (_outboundFull) {
+        switch (self.outboundPolicy) {
+            case OFFTStompOutboundPolicyBlock:
+                // Waiting on the processing queue would prevent it ever draining
+                if ([self isOnQueue] == NO) {
+                    while (_outboundFull) {
+                        [self.outboundCondition wait];
+                    }
                 }
+                break;
+            case OFFTStompOutboundPolicyFail:
+                shouldSend = NO;
+                *rejected = YES;
+                break;
+            case OFFTStompOutboundPolicyDrop:
+                shouldSend = NO;
+                ++_droppedMessageCount;
+                break;
+        }
+    }
+    [self.outboundCondition unlock];
+    
+    return shouldSend;
+}
+
+- (void)trackOutboundFrameOfLength:(NSUInteger)length {
+    BOOL becameFull = NO;
+    
+    [self.outboundCondition lock];
+    [self.outboundFrameLengths addObject:@(length)];
+    _outboundBytes += length;
+    _outboundFrames += 1;
+    
+    if (_outboundFull == NO && self.outboundHighWatermark > 0 && _outboundBytes >= self.outboundHighWatermark) {
+        _outboundFull = becameFull = YES;
+    }
+    [self.outboundCondition unlock];
+    
+    if (becameFull) {
+        [self notifyDelegate:^(id<OFFTStompClientDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(stompClientOutboundBufferFull:)]) {
+                [delegate stompClientOutboundBufferFull:self];
             }
-            
-            // Parse the body
-            if (frame.mayHaveBody) {
-                if ([lines.lastObject isKindOfClass:[NSString class]]) {
-                    
-                    // TODO: Read exactly header[content-length]
-                    // NOTE: Dealing with UTF-8 strings will render this
-                    // impossible if NULLs are present within the body.
-                    // Will likely need to use NSData throughout.
-                    
-                    NSData *body = [lines.lastObject dataUsingEncoding:NSUTF8StringEncoding];
-                    
-                    // The body will include the trailing NULL
-                    frame.body = [body subdataWithRange:NSMakeRange(0, body.length - 1)];
-                } else {
-                    NSAssert(0, @"Unexpected frame body type: %@", [lines.lastObject class]);
-                }
+        }];
+    }
+}
+
+/**
+ *  Transports that report their writes are accounted for as the bytes reach the network,
+ *  any others as soon as they accept the data.
+ */
+- (void)transportAcceptedDataOfLength:(NSUInteger)length {
+    self.sentSinceHeartbeat = YES;
+    
+    if ([self.transport respondsToSelector:@selector(reportsWrites)] && [self.transport reportsWrites]) {
+        return;
+    }
+    [self outboundDataWrittenOfLength:length];
+}
+
+- (void)outboundDataWrittenOfLength:(NSUInteger)length {
+    BOOL drained = NO;
+    
+    [self.outboundCondition lock];
+    _outboundBytes -= MIN(length, _outboundBytes);
+    
+    // Frames are complete once all of their bytes have been written
+    _outboundWrittenBytes += length;
+    while (self.outboundFrameLengths.count > 0) {
+        NSUInteger frameLength = [self.outboundFrameLengths[0] unsignedIntegerValue];
+        if (frameLength > _outboundWrittenBytes) {
+            break;
+        }
+        _outboundWrittenBytes -= frameLength;
+        _outboundFrames -= 1;
+        [self.outboundFrameLengths removeObjectAtIndex:0];
+    }
+    
+    if (_outboundFull && _outboundBytes <= self.outboundLowWatermark) {
+        _outboundFull = NO;
+        drained = YES;
+        [self.outboundCondition broadcast];
+    }
+    [self.outboundCondition unlock];
+    
+    if (drained) {
+        [self notifyDelegate:^(id<OFFTStompClientDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(stompClientOutboundBufferDrained:)]) {
+                [delegate stompClientOutboundBufferDrained:self];
             }
-            
-            return frame;
+        }];
+    }
+}
+
+- (void)resetOutboundAccounting {
+    [self.outboundCondition lock];
+    [self.outboundFrameLengths removeAllObjects];
+    _outboundBytes = 0;
+    _outboundFrames = 0;
+    _outboundWrittenBytes = 0;
+    
+    // Nothing can drain once disconnected, so release any blocked senders
+    _outboundFull = NO;
+    [self.outboundCondition broadcast];
+    [self.outboundCondition unlock];
+}
+
+#pragma mark - Private - Queues
+
+- (BOOL)isOnQueue {
+    return dispatch_get_specific((__bridge const void *)self) == (__bridge void *)self;
+}
+
+/**
+ *  Runs the block on the processing queue, immediately if already running on it.
+ */
+- (void)performOnQueue:(dispatch_block_t)block {
+    if ([self isOnQueue]) {
+        block();
+    } else {
+        dispatch_async(self.queue, block);
+    }
+}
+
+/**
+ *  Calls the delegate, on the delegate queue if one has been set.
+ *
+ *  Frames are recycled once handled, so anything the
+ *  block needs from a frame must be captured beforehand.
+ */
+- (void)notifyDelegate:(void (^)(id<OFFTStompClientDelegate> delegate))block {
+    id<OFFTStompClientDelegate> delegate = self.delegate;
+    if (delegate == nil) {
+        return;
+    }
+    
+    dispatch_queue_t delegateQueue = self.delegateQueue;
+    if (delegateQueue) {
+        dispatch_async(delegateQueue, ^{
+            block(delegate);
+        });
+    } else {
+        block(delegate);
+    }
+}
+
+#pragma mark - Private - Frame Handlers
+
+- (void)handleConnectedFrame:(OFFTStompFrame *)frame {
+    
+    NSString *negotiatedVersion = [frame valueForHeaderName:OFFTStompHeaderNameVersion];
+    if ([negotiatedVersion isEqualToString:@"1.2"]) {
+        self.negotiatedVersion = OFFTStompVersion1_2;
+    } else if ([negotiatedVersion isEqualToString:@"1.1"]) {
+        self.negotiatedVersion = OFFTStompVersion1_1;
+    } else {
+        NSAssert(0, @"Somehow managed to negotiate to an unknown protocol version.");
+    }
+    self.frameSerializer.version = self.negotiatedVersion;
+    self.frameDecoder.version = self.negotiatedVersion;
+    
+    self.state = OFFTStompStateConnected;
+    self.reconnectAttempts = 0;
+    [self startHeartbeatWithServerHeartbeat:[frame valueForHeaderName:OFFTStompHeaderNameHeartBeat]];
+    [self restoreSession];
+    
+    [self notifyDelegate:^(id<OFFTStompClientDelegate> delegate) {
+        [delegate stompClientDidConnect:self];
+    }];
+}
+
+- (void)handleMessageFrame:(OFFTStompFrame *)frame {
+    
+    NSData *body = frame.body;
+    
+    OFFTStompSubscription *route = [self subscriptionForFrame:frame];
+    
+    // Counted until the delegate has handled it
+    OFFTStompSubscription *subscription = [self isFlowControlledSubscription:route] ? route : nil;
+    ++subscription.queuedMessageCount;
+    
+    // Subscriptions with their own handler bypass the delegate
+    OFFTStompMessageHandler handler = route.handler;
+    if (handler) {
+        
+        OFFTStompHeaderView *headerView = [[OFFTStompHeaderView alloc] initWithFrame:frame];
+        dispatch_block_t block = ^{
+            handler(body, headerView);
+            [self delegateHandledMessageForSubscription:subscription];
+        };
+        
+        dispatch_queue_t handlerQueue = route.handlerQueue ?: self.delegateQueue;
+        if (handlerQueue) {
+            dispatch_async(handlerQueue, block);
+        } else {
+            block();
         }
+        return;
     }
+    
+    // Header view version of delegate method avoids decoding unused headers
+    if ([self.delegate respondsToSelector:@selector(stompClient:receivedMessageData:withHeaderView:)]) {
+        
+        OFFTStompHeaderView *headerView = [[OFFTStompHeaderView alloc] initWithFrame:frame];
+        [self notifyDelegate:^(id<OFFTStompClientDelegate> delegate) {
+            [delegate stompClient:self
+              receivedMessageData:body
+                   withHeaderView:headerView];
+            [self delegateHandledMessageForSubscription:subscription];
+        }];
+        
+    }
+    // Data version of delegate method takes precendence
+    else if ([self.delegate respondsToSelector:@selector(stompClient:receivedMessageData:withHeaders:)]) {
+        
+        NSDictionary *headers = [frame allHeaders];
+        [self notifyDelegate:^(id<OFFTStompClientDelegate> delegate) {
+            [delegate stompClient:self
+              receivedMessageData:body
+                      withHeaders:headers];
+            [self delegateHandledMessageForSubscription:subscription];
+        }];
         
-    return nil;
+    }
+    // Fall back to the string-based delegate method
+    else if ([self.delegate respondsToSelector:@selector(stompClient:receivedMessage:withHeaders:)]) {
+        
+        NSString *message = [[NSString alloc] initWithData:body
+                                                  encoding:NSUTF8StringEncoding];
+        NSDictionary *headers = [frame allHeaders];
+        [self notifyDelegate:^(id<OFFTStompClientDelegate> delegate) {
+            [delegate stompClient:self
+                  receivedMessage:message
+                      withHeaders:headers];
+            [self delegateHandledMessageForSubscription:subscription];
+        }];
+        
+    }
+    // Nothing will handle it
+    else {
+        [self delegateHandledMessageForSubscription:subscription];
+    }
 }
 
 #pragma mark - Lazy Instantiation
 
-- (NSMutableDictionary *)receiptHandlers {
-    if (_receiptHandlers == nil) {
-        _receiptHandlers = [[NSMutableDictionary alloc] init];
+- (OFFTStompReceiptTable *)receiptTable {
+    if (_receiptTable == nil) {
+        _receiptTable = [[OFFTStompReceiptTable alloc] initWithQueue:self.queue];
+    }
+    return _receiptTable;
+}
+
+- (NSMutableArray *)waitingConfirmedSends {
+    if (_waitingConfirmedSends == nil) {
+        _waitingConfirmedSends = [[NSMutableArray alloc] init];
+    }
+    return _waitingConfirmedSends;
+}
+
+- (NSMutableDictionary *)subscriptions {
+    if (_subscriptions == nil) {
+        _subscriptions = [[NSMutableDictionary alloc] init];
+    }
+    return _subscriptions;
+}
+
+- (NSMutableDictionary *)subscriptionRoutes {
+    if (_subscriptionRoutes == nil) {
+        _subscriptionRoutes = [[NSMutableDictionary alloc] init];
+    }
+    return _subscriptionRoutes;
+}
+
+- (NSMutableDictionary *)transactions {
+    if (_transactions == nil) {
+        _transactions = [[NSMutableDictionary alloc] init];
+    }
+    return _transactions;
+}
+
+- (NSMutableDictionary *)pendingAcks {
+    if (_pendingAcks == nil) {
+        _pendingAcks = [[NSMutableDictionary alloc] init];
+    }
+    return _pendingAcks;
+}
+
+- (NSMutableArray *)outboundFrameLengths {
+    if (_outboundFrameLengths == nil) {
+        _outboundFrameLengths = [[NSMutableArray alloc] init];
+    }
+    return _outboundFrameLengths;
+}
+
+- (NSMutableData *)pendingWrites {
+    if (_pendingWrites == nil) {
+        _pendingWrites = [[NSMutableData alloc] initWithCapacity:self.coalescingByteThreshold];
+    }
+    return _pendingWrites;
+}
+
+- (OFFTStompFramePool *)framePool {
+    if (_framePool == nil) {
+        _framePool = [[OFFTStompFramePool alloc] init];
+    }
+    return _framePool;
+}
+
+- (OFFTStompFrameDecoder *)frameDecoder {
+    if (_frameDecoder == nil) {
+        _frameDecoder = [[OFFTStompFrameDecoder alloc] init];
+        _frameDecoder.delegate = self;
+        _frameDecoder.framePool = self.framePool;
+    }
+    return _frameDecoder;
+}
+
+- (OFFTStompFrameSerializer *)frameSerializer {
+    if (_frameSerializer == nil) {
+        _frameSerializer = [[OFFTStompFrameSerializer alloc] init];
     }
-    return _receiptHandlers;
+    return _frameSerializer;
 }
 
 @end
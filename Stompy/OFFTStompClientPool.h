@@ -0,0 +1,180 @@
+//
+//  OFFTStompClientPool.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OFFTStompClient.h"
+
+/**
+ *  How published messages are spread across the pool's connections.
+ *  Messages to the same destination always use the same connection, so they stay in order.
+ */
+typedef NS_ENUM(NSUInteger, OFFTStompClientPoolRouting) {
+    OFFTStompClientPoolRoutingDestinationHash,  // Destinations are hashed to a connection
+    OFFTStompClientPoolRoutingRoundRobin,       // Each new destination is given the next connection in turn
+};
+
+/**
+ *  Creates the transport for one of a pool's connections.
+ *
+ *  @param index The index of the connection.
+ */
+typedef id<OFFTStompTransportAdapter>(^OFFTStompTransportFactory)(NSUInteger index);
+
+/**
+ *  Spreads the work of a single client across several connections to the same broker.
+ *
+ *  Each connection is a separate client with its own transport and its own serial
+ *  queue, so frames for different connections are parsed and handled concurrently.
+ *  Subscriptions are assigned a connection by hashing their destination, and
+ *  published messages according to the publish routing.
+ *
+ *  Delegate methods are called by the individual clients, on their own queues
+ *  unless a delegate queue is set.
+ */
+@interface OFFTStompClientPool : NSObject
+
+/**
+ *  Creates a pool of clients.
+ *
+ *  @param count            The number of connections to open.
+ *  @param transportFactory Called once for each connection to create its transport.
+ *
+ *  @return A new OFFTStompClientPool instance
+ */
++ (instancetype)poolWithConnectionCount:(NSUInteger)count
+                       transportFactory:(OFFTStompTransportFactory)transportFactory;
+
+/**
+ *  The pool's clients, one per connection.
+ */
+@property (nonatomic, copy, readonly) NSArray *clients;
+
+/**
+ *  The delegate of every client in the pool.
+ */
+@property (nonatomic, weak) id<OFFTStompClientDelegate> delegate;
+
+/**
+ *  The queue every client calls its delegate on.
+ *  Defaults to nil, calling the delegate on each client's own queue.
+ */
+@property (nonatomic, strong) dispatch_queue_t delegateQueue;
+
+/**
+ *  How published messages are spread across connections.
+ *  Defaults to OFFTStompClientPoolRoutingDestinationHash.
+ */
+@property (nonatomic, assign) OFFTStompClientPoolRouting publishRouting;
+
+/**
+ *  The most destinations round-robin routing remembers the connection of. Defaults to 4096.
+ *
+ *  Destinations are never forgotten, as moving one to another connection could reorder its
+ *  messages. Once the limit has been reached, further destinations are hashed instead.
+ */
+@property (nonatomic, assign) NSUInteger roundRobinDestinationLimit;
+
+/**
+ *  The client messages to a destination are published through.
+ *
+ *  @param destination The destination.
+ */
+- (OFFTStompClient *)clientForDestination:(NSString *)destination;
+
+- (void)connect;
+
+- (void)disconnect;
+
+#pragma mark - Sending messages
+
+/**
+ *  Sends a message through the client for its destination.
+ *  See the equivalent methods of OFFTStompClient.
+ */
+- (BOOL)sendMessage:(NSString *)message
+      toDestination:(NSString *)destination;
+
+- (BOOL)sendMessage:(NSString *)message
+      toDestination:(NSString *)destination
+  withCustomHeaders:(NSDictionary *)headers;
+
+- (BOOL)sendMessageData:(NSData *)messageData
+          toDestination:(NSString *)destination;
+
+- (BOOL)sendMessageData:(NSData *)messageData
+          toDestination:(NSString *)destination
+      withCustomHeaders:(NSDictionary *)headers;
+
+#pragma mark - Subscriptions
+
+/**
+ *  Subscribes to a given destination on the connection its destination hashes to.
+ *
+ *  @param destination The destination of the subscription.
+ *
+ *  @return An opaque type that can be used to unsubscribe.
+ */
+- (id)subscribe:(NSString *)destination;
+
+/**
+ *  Subscribes to a given destination on the connection its destination hashes to.
+ *  Messages must be acknowledged through the client the delegate received them from.
+ *
+ *  @param destination The destination of the subscription.
+ *  @param ackMode     How the subscription's messages are acknowledged.
+ *
+ *  @return An opaque type that can be used to unsubscribe.
+ */
+- (id)subscribe:(NSString *)destination ackMode:(OFFTStompAckMode)ackMode;
+
+/**
+ *  Subscribes to a given destination on the connection its destination hashes to.
+ *
+ *  @param destination The destination of the subscription.
+ *  @param options     The options of the subscription, or nil for the defaults.
+ *
+ *  @return An opaque type that can be used to unsubscribe.
+ */
+- (id)subscribe:(NSString *)destination options:(OFFTStompSubscriptionOptions *)options;
+
+/**
+ *  Subscribes to a given destination on the connection its destination hashes to,
+ *  handling its messages with a block instead of the delegate.
+ *
+ *  @param destination The destination of the subscription.
+ *  @param handler     Called for each message received by the subscription.
+ *  @param queue       The queue the handler is called on, or nil for the delegate queue.
+ *
+ *  @return An opaque type that can be used to unsubscribe.
+ */
+- (id)subscribe:(NSString *)destination handler:(OFFTStompMessageHandler)handler queue:(dispatch_queue_t)queue;
+
+/**
+ *  Subscribes to a given destination on the connection its destination hashes to,
+ *  handling its messages with a block instead of the delegate.
+ *
+ *  @param destination The destination of the subscription.
+ *  @param options     The options of the subscription, or nil for the defaults.
+ *  @param handler     Called for each message received by the subscription.
+ *  @param queue       The queue the handler is called on, or nil for the delegate queue.
+ *
+ *  @return An opaque type that can be used to unsubscribe.
+ */
+- (id)subscribe:(NSString *)destination
+        options:(OFFTStompSubscriptionOptions *)options
+        handler:(OFFTStompMessageHandler)handler
+          queue:(dispatch_queue_t)queue;
+
+/**
+ *  Unsubscribes from an existing subscription.
+ *
+ *  @param subscription The opaque subscription type provided by an earlier call to subscribe:
+ */
+- (void)unsubscribe:(id)subscription;
+
+@end
@@ -0,0 +1,219 @@
+//
+//  OFFTStompClientPool.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompClientPool.h"
+#import "OFFTStompSubscriptionOptions.h"
+
+/**
+ *  FNV-1a, which spreads similar destinations such as /topic/a and /topic/b evenly.
+ */
+static inline uint32_t OFFTStompDestinationHash(NSString *destination) {
+    uint32_t hash = 2166136261u;
+    for (const char *c = destination.UTF8String; c && *c; ++c) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    return hash;
+}
+
+static const NSUInteger OFFTStompClientPoolDefaultRoundRobinDestinationLimit = 4096;
+
+@interface OFFTStompClientPool ()
+@property (nonatomic, copy) NSArray *clients;
+
+/**
+ *  Guards the routing tables, which are used by senders on any thread.
+ */
+@property (nonatomic, strong) NSLock *lock;
+
+/**
+ *  A dictionary of destinations : client indexes, for round-robin routing.
+ */
+@property (nonatomic, strong) NSMutableDictionary *assignedDestinations;
+@property (nonatomic, assign) NSUInteger nextClientIndex;
+
+/**
+ *  Subscriptions : the clients they were made on.
+ */
+@property (nonatomic, strong) NSMapTable *subscriptionClients;
+
+@end
+
+@implementation OFFTStompClientPool
+
++ (instancetype)poolWithConnectionCount:(NSUInteger)count
+                       transportFactory:(OFFTStompTransportFactory)transportFactory {
+
+    NSAssert(count > 0, @"A pool needs at least one connection.");
+
+    NSMutableArray *clients = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        // Each connection is handled on its own queue
+        NSString *label = [NSString stringWithFormat:@"OFFTStompClientPool.%lu", (unsigned long)i];
+        dispatch_queue_t queue = dispatch_queue_create(label.UTF8String, DISPATCH_QUEUE_SERIAL);
+
+        [clients addObject:[OFFTStompClient stompWithTransport:transportFactory(i) queue:queue]];
+    }
+
+    OFFTStompClientPool *pool = [[self alloc] init];
+    pool.clients = clients;
+    pool.lock = [[NSLock alloc] init];
+    pool.roundRobinDestinationLimit = OFFTStompClientPoolDefaultRoundRobinDestinationLimit;
+    return pool;
+}
+
+#pragma mark - Public
+
+- (void)setDelegate:(id<OFFTStompClientDelegate>)delegate {
+    _delegate = delegate;
+    for (OFFTStompClient *client in self.clients) {
+        client.delegate = delegate;
+    }
+}
+
+- (void)setDelegateQueue:(dispatch_queue_t)delegateQueue {
+    _delegateQueue = delegateQueue;
+    for (OFFTStompClient *client in self.clients) {
+        client.delegateQueue = delegateQueue;
+    }
+}
+
+- (OFFTStompClient *)clientForDestination:(NSString *)destination {
+    if (self.publishRouting == OFFTStompClientPoolRoutingDestinationHash || destination == nil) {
+        return [self hashedClientForDestination:destination];
+    }
+
+    [self.lock lock];
+    NSNumber *index = self.assignedDestinations[destination];
+    if (index == nil) {
+        if (self.assignedDestinations.count >= self.roundRobinDestinationLimit) {
+            [self.lock unlock];
+
+            // Hashing needs nothing remembered to keep the destination on one connection
+            return [self hashedClientForDestination:destination];
+        }
+        index = @(self.nextClientIndex);
+        self.nextClientIndex = (self.nextClientIndex + 1) % self.clients.count;
+        self.assignedDestinations[destination] = index;
+    }
+    [self.lock unlock];
+
+    return self.clients[index.unsignedIntegerValue];
+}
+
+- (void)connect {
+    for (OFFTStompClient *client in self.clients) {
+        [client connect];
+    }
+}
+
+- (void)disconnect {
+    for (OFFTStompClient *client in self.clients) {
+        [client disconnect];
+    }
+}
+
+#pragma mark - Public - Sending Messages
+
+- (BOOL)sendMessage:(NSString *)message
+      toDestination:(NSString *)destination {
+    return [[self clientForDestination:destination] sendMessage:message
+                                                  toDestination:destination];
+}
+
+- (BOOL)sendMessage:(NSString *)message
+      toDestination:(NSString *)destination
+  withCustomHeaders:(NSDictionary *)headers {
+    return [[self clientForDestination:destination] sendMessage:message
+                                                  toDestination:destination
+                                              withCustomHeaders:headers];
+}
+
+- (BOOL)sendMessageData:(NSData *)messageData
+          toDestination:(NSString *)destination {
+    return [[self clientForDestination:destination] sendMessageData:messageData
+                                                      toDestination:destination];
+}
+
+- (BOOL)sendMessageData:(NSData *)messageData
+          toDestination:(NSString *)destination
+      withCustomHeaders:(NSDictionary *)headers {
+    return [[self clientForDestination:destination] sendMessageData:messageData
+                                                      toDestination:destination
+                                                  withCustomHeaders:headers];
+}
+
+#pragma mark - Public - Subscriptions
+
+- (id)subscribe:(NSString *)destination {
+    return [self subscribe:destination ackMode:OFFTStompAckModeAuto];
+}
+
+- (id)subscribe:(NSString *)destination ackMode:(OFFTStompAckMode)ackMode {
+    return [self subscribe:destination options:[OFFTStompSubscriptionOptions optionsWithAckMode:ackMode prefetchCount:0]];
+}
+
+- (id)subscribe:(NSString *)destination options:(OFFTStompSubscriptionOptions *)options {
+    return [self subscribe:destination options:options handler:nil queue:nil];
+}
+
+- (id)subscribe:(NSString *)destination handler:(OFFTStompMessageHandler)handler queue:(dispatch_queue_t)queue {
+    return [self subscribe:destination options:nil handler:handler queue:queue];
+}
+
+- (id)subscribe:(NSString *)destination
+        options:(OFFTStompSubscriptionOptions *)options
+        handler:(OFFTStompMessageHandler)handler
+          queue:(dispatch_queue_t)queue {
+    OFFTStompClient *client = [self hashedClientForDestination:destination];
+    id subscription = [client subscribe:destination options:options handler:handler queue:queue];
+
+    [self.lock lock];
+    [self.subscriptionClients setObject:client forKey:subscription];
+    [self.lock unlock];
+
+    return subscription;
+}
+
+- (void)unsubscribe:(id)subscription {
+    [self.lock lock];
+    OFFTStompClient *client = [self.subscriptionClients objectForKey:subscription];
+    [self.subscriptionClients removeObjectForKey:subscription];
+    [self.lock unlock];
+
+    if (client == nil) {
+        NSAssert(0, @"You must provide a subscription made by this pool.");
+        return;
+    }
+
+    [client unsubscribe:subscription];
+}
+
+#pragma mark - Private
+
+- (OFFTStompClient *)hashedClientForDestination:(NSString *)destination {
+    return self.clients[OFFTStompDestinationHash(destination) % self.clients.count];
+}
+
+#pragma mark - Lazy Instantiation
+
+- (NSMutableDictionary *)assignedDestinations {
+    if (_assignedDestinations == nil) {
+        _assignedDestinations = [[NSMutableDictionary alloc] init];
+    }
+    return _assignedDestinations;
+}
+
+- (NSMapTable *)subscriptionClients {
+    if (_subscriptionClients == nil) {
+        // Subscriptions the app no longer holds cannot be unsubscribed, so need not be kept
+        _subscriptionClients = [NSMapTable weakToWeakObjectsMapTable];
+    }
+    return _subscriptionClients;
+}
+
+@end
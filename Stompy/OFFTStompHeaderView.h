@@ -0,0 +1,73 @@
+//
+//  OFFTStompHeaderView.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class OFFTStompFrame;
+
+/**
+ *  An immutable, read-only view of the headers of a received message.
+ *
+ *  Headers are kept as bytes in the transport's receive buffer and a header
+ *  is only decoded into an NSString when it is accessed. Where only a few
+ *  headers are of interest this avoids building a dictionary for every message.
+ *
+ *  Where a header is repeated, the first occurrence is used.
+ */
+@interface OFFTStompHeaderView : NSObject <NSCopying>
+
+/**
+ *  Creates a view of the headers of a frame.
+ *
+ *  @param frame The frame, which may be reused once the view has been created.
+ */
+- (instancetype)initWithFrame:(OFFTStompFrame *)frame NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  The number of headers, including any repeated headers.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ *  Whether the header is present.
+ */
+- (BOOL)hasHeader:(NSString *)header;
+
+/**
+ *  Compares the value of a header with the provided bytes, without decoding it into a string.
+ *
+ *  @param header The name of the header.
+ *  @param bytes  The UTF-8 encoded value to compare against.
+ *  @param length The length of the value in bytes.
+ *
+ *  @return YES if the header is present and its value is equal to the bytes.
+ */
+- (BOOL)hasHeader:(NSString *)header equalToBytes:(const void *)bytes length:(NSUInteger)length;
+
+/**
+ *  Compares the value of a header with the provided string, without decoding it into a string.
+ */
+- (BOOL)hasHeader:(NSString *)header equalToString:(NSString *)string;
+
+/**
+ *  Retrieves the value of the provided header, or nil if the header does not exist.
+ */
+- (NSString *)valueForHeader:(NSString *)header;
+
+/**
+ *  Allows headers to be read using subscripting, i.e. view[@"destination"].
+ */
+- (NSString *)objectForKeyedSubscript:(NSString *)header;
+
+/**
+ *  All headers as a dictionary of NSString : NSString objects.
+ *  The dictionary is built the first time it is requested.
+ */
+- (NSDictionary *)dictionary;
+
+@end
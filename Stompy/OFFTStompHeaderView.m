@@ -0,0 +1,130 @@
+//
+//  OFFTStompHeaderView.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompHeaderView.h"
+#import "OFFTStompFrame.h"
+#import "OFFTStompCodecTables.h"
+#import "OFFTStompHeaderEncoding.h"
+
+@interface OFFTStompHeaderView () {
+    OFFTStompFrameHeader *_headers;
+    const uint8_t *_bytes;
+}
+
+@property (nonatomic, assign) NSUInteger count;
+
+/**
+ *  Owns the bytes that header offsets refer to.
+ */
+@property (nonatomic, strong) NSData *data;
+
+@property (nonatomic, assign) BOOL escaped;
+@property (nonatomic, assign) OFFTStompVersion version;
+
+@property (nonatomic, copy) NSDictionary *headerDictionary;
+
+@end
+
+@implementation OFFTStompHeaderView
+
+- (instancetype)initWithFrame:(OFFTStompFrame *)frame {
+    self = [super init];
+    if (self) {
+        _count = frame.headerCount;
+        _escaped = frame.rawHeadersEscaped;
+        _version = frame.rawHeadersVersion;
+
+        // Received header blocks are immutable slices, retained rather than copied
+        _data = frame.rawHeaderData;
+        _bytes = (const uint8_t *)_data.bytes + frame.rawHeaderOffset;
+
+        if (_count > 0) {
+            _headers = malloc(sizeof(OFFTStompFrameHeader) * _count);
+            memcpy(_headers, frame.rawHeaders, sizeof(OFFTStompFrameHeader) * _count);
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_headers);
+}
+
+#pragma mark - Public
+
+- (BOOL)hasHeader:(NSString *)header {
+    return [self indexOfHeader:header] != NSNotFound;
+}
+
+- (BOOL)hasHeader:(NSString *)header equalToBytes:(const void *)bytes length:(NSUInteger)length {
+    NSUInteger index = [self indexOfHeader:header];
+    if (index == NSNotFound) {
+        return NO;
+    }
+
+    const OFFTStompFrameHeader *entry = &_headers[index];
+    const uint8_t *value = _bytes + entry->valueOffset;
+
+    // Values containing escape sequences must be decoded before comparing
+    if (self.escaped && memchr(value, '\\', entry->valueLength) != NULL) {
+        NSData *decoded = [[self valueOfHeaderAtIndex:index] dataUsingEncoding:NSUTF8StringEncoding];
+        return decoded.length == length && memcmp(decoded.bytes, bytes, length) == 0;
+    }
+
+    return entry->valueLength == length && memcmp(value, bytes, length) == 0;
+}
+
+- (BOOL)hasHeader:(NSString *)header equalToString:(NSString *)string {
+    const char *bytes = string.UTF8String;
+    if (bytes == NULL) {
+        return NO;
+    }
+    return [self hasHeader:header equalToBytes:bytes length:strlen(bytes)];
+}
+
+- (NSString *)valueForHeader:(NSString *)header {
+    NSUInteger index = [self indexOfHeader:header];
+    return (index != NSNotFound) ? [self valueOfHeaderAtIndex:index] : nil;
+}
+
+- (NSString *)objectForKeyedSubscript:(NSString *)header {
+    return [self valueForHeader:header];
+}
+
+- (NSDictionary *)dictionary {
+    if (self.headerDictionary == nil) {
+        self.headerDictionary = OFFTStompCreateHeaderDictionary(_headers, _count, _bytes, self.escaped, self.version);
+    }
+    return self.headerDictionary;
+}
+
+#pragma mark - NSObject
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p> %@", NSStringFromClass([self class]), self, [self dictionary]];
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone {
+    // Immutable
+    return self;
+}
+
+#pragma mark - Private
+
+- (NSUInteger)indexOfHeader:(NSString *)header {
+    return OFFTStompIndexOfHeader(_headers, _count, _bytes, OFFTStompHeaderNameFromString(header), header, self.escaped, self.version);
+}
+
+- (NSString *)valueOfHeaderAtIndex:(NSUInteger)index {
+    const OFFTStompFrameHeader *entry = &_headers[index];
+    return OFFTStompCreateHeaderString(_bytes + entry->valueOffset, entry->valueLength, self.escaped, self.version);
+}
+
+@end
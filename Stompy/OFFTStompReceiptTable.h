@@ -0,0 +1,91 @@
+//
+//  OFFTStompReceiptTable.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  Called once a receipt has arrived, or has failed to.
+ *
+ *  @param received NO if the receipt's deadline passed or the table was cleared first.
+ */
+typedef void(^OFFTStompReceiptHandler)(BOOL received);
+
+/**
+ *  The receipts a client is waiting for, keyed by the integers used as their receipt headers.
+ *
+ *  Receipts are numbered in the order they are requested and kept in that
+ *  order, so finding one is a binary search, and finding the oldest, which
+ *  servers usually confirm first, takes a single comparison.
+ *
+ *  Receipts may have a deadline, after which their handler is called with NO.
+ *  Deadlines are checked on the shared timing wheel, only while any are pending.
+ *
+ *  The table is not thread safe, and must only be used on the queue it was created with.
+ */
+@interface OFFTStompReceiptTable : NSObject
+
+/**
+ *  @param queue The queue the table is used on, which handlers are called on when deadlines pass.
+ */
+- (instancetype)initWithQueue:(dispatch_queue_t)queue NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  Requests a new receipt.
+ *
+ *  @param timeout How long to wait for the receipt, or 0 to wait for as long as the table is not cleared.
+ *  @param handler Called once the receipt has arrived or has failed to.
+ *
+ *  @return The receipt's number, to be sent as the frame's receipt header.
+ */
+- (uint64_t)addReceiptWithTimeout:(NSTimeInterval)timeout handler:(OFFTStompReceiptHandler)handler;
+
+/**
+ *  Keeps a serialized frame to be sent again if its receipt has not arrived before reconnecting.
+ *
+ *  @param frameParts The NSData parts of the frame, as they were sent. They are retained, not copied.
+ */
+- (void)setFrameParts:(NSArray *)frameParts forReceipt:(uint64_t)receipt;
+
+/**
+ *  Completes a receipt that has arrived, calling its handler with YES.
+ *
+ *  @return NO if the receipt was not waiting.
+ */
+- (BOOL)completeReceipt:(uint64_t)receipt;
+
+/**
+ *  The parts of every frame kept to be sent again, in the order they were first sent.
+ */
+- (NSArray *)unconfirmedFrameParts;
+
+/**
+ *  Fails every receipt whose frame is not kept to be sent again.
+ */
+- (void)failUnconfirmableReceipts;
+
+/**
+ *  Fails every receipt, and restarts the numbering.
+ */
+- (void)failAllReceipts;
+
+/**
+ *  Stops deadlines passing, such as while the connection is being re-established.
+ */
+- (void)suspendDeadlines;
+
+/**
+ *  Restarts every deadline from now.
+ */
+- (void)resumeDeadlines;
+
+/**
+ *  The number of receipts waiting.
+ */
+- (NSUInteger)count;
+
+@end
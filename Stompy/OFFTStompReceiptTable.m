@@ -0,0 +1,241 @@
+//
+//  OFFTStompReceiptTable.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompReceiptTable.h"
+#import "OFFTStompTimingWheel.h"
+
+/**
+ *  A receipt being waited for.
+ */
+@interface OFFTStompReceiptEntry : NSObject
+@property (nonatomic, assign) uint64_t receipt;
+@property (nonatomic, assign) NSTimeInterval timeout;
+@property (nonatomic, assign) CFAbsoluteTime deadline;
+@property (nonatomic, copy) OFFTStompReceiptHandler handler;
+@property (nonatomic, copy) NSArray *frameParts;
+@end
+
+@implementation OFFTStompReceiptEntry
+@end
+
+@interface OFFTStompReceiptTable ()
+@property (nonatomic, strong) dispatch_queue_t queue;
+
+/**
+ *  Entries in ascending order of receipt.
+ */
+@property (nonatomic, strong) NSMutableArray *entries;
+@property (nonatomic, assign) uint64_t lastReceipt;
+
+/**
+ *  The number of entries with a deadline.
+ */
+@property (nonatomic, assign) NSUInteger deadlineCount;
+@property (nonatomic, assign) BOOL deadlinesSuspended;
+
+/**
+ *  Only exists while deadlines are pending.
+ */
+@property (nonatomic, strong) OFFTStompWheelTimer *sweepTimer;
+
+@end
+
+@implementation OFFTStompReceiptTable
+
+- (instancetype)init {
+    return [self initWithQueue:dispatch_get_main_queue()];
+}
+
+- (instancetype)initWithQueue:(dispatch_queue_t)queue {
+    self = [super init];
+    if (self) {
+        _queue = queue;
+        _entries = [[NSMutableArray alloc] init];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [_sweepTimer cancel];
+}
+
+#pragma mark - Public
+
+- (uint64_t)addReceiptWithTimeout:(NSTimeInterval)timeout handler:(OFFTStompReceiptHandler)handler {
+    OFFTStompReceiptEntry *entry = [[OFFTStompReceiptEntry alloc] init];
+    entry.receipt = ++self.lastReceipt;
+    entry.timeout = timeout;
+    entry.handler = handler;
+
+    // Receipts are numbered in ascending order, so are always added at the end
+    [self.entries addObject:entry];
+
+    if (timeout > 0) {
+        entry.deadline = CFAbsoluteTimeGetCurrent() + timeout;
+        ++self.deadlineCount;
+        [self startSweeping];
+    }
+
+    return entry.receipt;
+}
+
+- (void)setFrameParts:(NSArray *)frameParts forReceipt:(uint64_t)receipt {
+    NSUInteger index = [self indexOfReceipt:receipt];
+    if (index != NSNotFound) {
+        [self.entries[index] setFrameParts:frameParts];
+    }
+}
+
+- (BOOL)completeReceipt:(uint64_t)receipt {
+    NSUInteger index = [self indexOfReceipt:receipt];
+    if (index == NSNotFound) {
+        return NO;
+    }
+
+    OFFTStompReceiptEntry *entry = self.entries[index];
+    [self removeEntryAtIndex:index];
+
+    if (entry.handler) {
+        entry.handler(YES);
+    }
+    return YES;
+}
+
+- (NSArray *)unconfirmedFrameParts {
+    NSMutableArray *frameParts = [[NSMutableArray alloc] init];
+    for (OFFTStompReceiptEntry *entry in self.entries) {
+        if (entry.frameParts) {
+            [frameParts addObjectsFromArray:entry.frameParts];
+        }
+    }
+    return frameParts;
+}
+
+- (void)failUnconfirmableReceipts {
+    NSIndexSet *indexes = [self.entries indexesOfObjectsPassingTest:^BOOL(OFFTStompReceiptEntry *entry, NSUInteger idx, BOOL *stop) {
+        return entry.frameParts == nil;
+    }];
+    [self failEntriesAtIndexes:indexes];
+}
+
+- (void)failAllReceipts {
+    // Before the handlers, which may request further receipts
+    self.lastReceipt = 0;
+    [self failEntriesAtIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, self.entries.count)]];
+}
+
+- (void)suspendDeadlines {
+    self.deadlinesSuspended = YES;
+    [self stopSweeping];
+}
+
+- (void)resumeDeadlines {
+    self.deadlinesSuspended = NO;
+
+    const CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    for (OFFTStompReceiptEntry *entry in self.entries) {
+        if (entry.timeout > 0) {
+            entry.deadline = now + entry.timeout;
+        }
+    }
+    [self startSweeping];
+}
+
+- (NSUInteger)count {
+    return self.entries.count;
+}
+
+#pragma mark - Private
+
+- (NSUInteger)indexOfReceipt:(uint64_t)receipt {
+    NSArray *entries = self.entries;
+    if (entries.count == 0) {
+        return NSNotFound;
+    }
+
+    // Receipts usually arrive in the order they were requested
+    if ([entries[0] receipt] == receipt) {
+        return 0;
+    }
+
+    NSUInteger low = 0;
+    NSUInteger high = entries.count;
+    while (low < high) {
+        const NSUInteger middle = low + (high - low) / 2;
+        const uint64_t candidate = [entries[middle] receipt];
+        if (candidate == receipt) {
+            return middle;
+        }
+        if (candidate < receipt) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return NSNotFound;
+}
+
+- (void)removeEntryAtIndex:(NSUInteger)index {
+    OFFTStompReceiptEntry *entry = self.entries[index];
+    [self.entries removeObjectAtIndex:index];
+
+    if (entry.timeout > 0 && --self.deadlineCount == 0) {
+        [self stopSweeping];
+    }
+}
+
+/**
+ *  Removes the entries before calling their handlers, which may add further receipts.
+ */
+- (void)failEntriesAtIndexes:(NSIndexSet *)indexes {
+    if (indexes.count == 0) {
+        return;
+    }
+
+    NSArray *failed = [self.entries objectsAtIndexes:indexes];
+    for (NSUInteger index = indexes.lastIndex; index != NSNotFound; index = [indexes indexLessThanIndex:index]) {
+        [self removeEntryAtIndex:index];
+    }
+
+    for (OFFTStompReceiptEntry *entry in failed) {
+        if (entry.handler) {
+            entry.handler(NO);
+        }
+    }
+}
+
+- (void)startSweeping {
+    if (self.sweepTimer || self.deadlinesSuspended || self.deadlineCount == 0) {
+        return;
+    }
+
+    // Every tick of the wheel, deadlines being as precise as the wheel's other timers
+    __weak typeof(self) weakSelf = self;
+    self.sweepTimer = [[OFFTStompTimingWheel sharedWheel] scheduleTimerWithInterval:0 queue:self.queue handler:^{
+        [weakSelf failExpiredReceipts];
+    }];
+}
+
+- (void)stopSweeping {
+    [self.sweepTimer cancel];
+    self.sweepTimer = nil;
+}
+
+- (void)failExpiredReceipts {
+    if (self.deadlinesSuspended) {
+        return;
+    }
+
+    const CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    NSIndexSet *indexes = [self.entries indexesOfObjectsPassingTest:^BOOL(OFFTStompReceiptEntry *entry, NSUInteger idx, BOOL *stop) {
+        return entry.timeout > 0 && entry.deadline <= now;
+    }];
+    [self failEntriesAtIndexes:indexes];
+}
+
+@end
@@ -7,11 +7,53 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "OFFTStompSubscriptionOptions.h"
+#import "OFFTStompClient.h"
 
 @interface OFFTStompSubscription : NSObject
 
 - (instancetype)initWithIdentifier:(NSString *)identifier;
 
+- (instancetype)initWithIdentifier:(NSString *)identifier destination:(NSString *)destination;
+
+- (instancetype)initWithIdentifier:(NSString *)identifier destination:(NSString *)destination options:(OFFTStompSubscriptionOptions *)options;
+
 - (NSString *)identifier;
 
+- (NSString *)destination;
+
+- (OFFTStompSubscriptionOptions *)options;
+
+- (OFFTStompAckMode)ackMode;
+
+/**
+ *  The integer the client made the identifier from, 0 if it was not made from one.
+ *  Messages are routed on it rather than on the identifier string.
+ */
+@property (nonatomic, assign) uint64_t number;
+
+/**
+ *  Handles the subscription's messages instead of the client's delegate, on the handler queue.
+ */
+@property (nonatomic, copy) OFFTStompMessageHandler handler;
+@property (nonatomic, strong) dispatch_queue_t handlerQueue;
+
+/**
+ *  The number of messages received but not yet handled by the client's delegate.
+ *  Only counted when the subscription has a prefetch window, on the client's queue.
+ */
+@property (nonatomic, assign) NSUInteger queuedMessageCount;
+
+/**
+ *  ACK and NACK frames withheld while the queued messages are over the prefetch
+ *  window, as arrays of the command and the ack or message-id header.
+ */
+@property (nonatomic, strong) NSMutableArray *withheldAcks;
+
+/**
+ *  The number of acknowledgements batched but not yet sent, on the client's queue.
+ *  A batch is sent once it covers the prefetch window, as the server sends nothing more until then.
+ */
+@property (nonatomic, assign) NSUInteger batchedAckCount;
+
 @end
@@ -10,16 +10,41 @@
 
 @interface OFFTStompSubscription ()
 @property (nonatomic, copy) NSString *identifier;
+@property (nonatomic, copy) NSString *destination;
+@property (nonatomic, copy) OFFTStompSubscriptionOptions *options;
 @end
 
 @implementation OFFTStompSubscription
 
 - (instancetype)initWithIdentifier:(NSString *)identifier {
+    return [self initWithIdentifier:identifier destination:nil];
+}
+
+- (instancetype)initWithIdentifier:(NSString *)identifier destination:(NSString *)destination {
+    return [self initWithIdentifier:identifier destination:destination options:nil];
+}
+
+- (instancetype)initWithIdentifier:(NSString *)identifier destination:(NSString *)destination options:(OFFTStompSubscriptionOptions *)options {
     self = [super init];
     if (self) {
         _identifier = [identifier copy];
+        _destination = [destination copy];
+        _options = [options copy] ?: [[OFFTStompSubscriptionOptions alloc] init];
     }
     return self;
 }
 
+- (OFFTStompAckMode)ackMode {
+    return self.options.ackMode;
+}
+
+#pragma mark - Lazy Instantiation
+
+- (NSMutableArray *)withheldAcks {
+    if (_withheldAcks == nil) {
+        _withheldAcks = [[NSMutableArray alloc] init];
+    }
+    return _withheldAcks;
+}
+
 @end
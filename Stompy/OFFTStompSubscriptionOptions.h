@@ -0,0 +1,47 @@
+//
+//  OFFTStompSubscriptionOptions.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OFFTStompClient.h"
+
+/**
+ *  How a subscription is made, and how the client paces the messages it receives.
+ */
+@interface OFFTStompSubscriptionOptions : NSObject <NSCopying>
+
+/**
+ *  @param ackMode       How the subscription's messages are acknowledged.
+ *  @param prefetchCount The subscription's prefetch window, or 0 for none.
+ */
++ (instancetype)optionsWithAckMode:(OFFTStompAckMode)ackMode prefetchCount:(NSUInteger)prefetchCount;
+
+/**
+ *  How the subscription's messages are acknowledged. Defaults to OFFTStompAckModeAuto.
+ */
+@property (nonatomic, assign) OFFTStompAckMode ackMode;
+
+/**
+ *  The most messages the subscription should have waiting to be handled.
+ *  Defaults to 0, for no limit.
+ *
+ *  The window is sent to the server as the activemq.prefetchSize and
+ *  prefetch-count headers, limiting how many unacknowledged messages it sends.
+ *  Unless the ack mode is OFFTStompAckModeAuto the client also enforces it:
+ *  while more messages than the window have been received but not yet handled
+ *  by the delegate, acknowledgements are withheld, so the server sends no more
+ *  until the delegate has caught up.
+ */
+@property (nonatomic, assign) NSUInteger prefetchCount;
+
+/**
+ *  Further headers of the SUBSCRIBE frame, as a dictionary of NSString : NSString objects.
+ *  They cannot replace the destination, id or ack headers.
+ */
+@property (nonatomic, copy) NSDictionary *headers;
+
+@end
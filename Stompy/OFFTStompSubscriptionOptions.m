@@ -0,0 +1,30 @@
+//
+//  OFFTStompSubscriptionOptions.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompSubscriptionOptions.h"
+
+@implementation OFFTStompSubscriptionOptions
+
++ (instancetype)optionsWithAckMode:(OFFTStompAckMode)ackMode prefetchCount:(NSUInteger)prefetchCount {
+    OFFTStompSubscriptionOptions *options = [[self alloc] init];
+    options.ackMode = ackMode;
+    options.prefetchCount = prefetchCount;
+    return options;
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone {
+    OFFTStompSubscriptionOptions *copy = [[[self class] allocWithZone:zone] init];
+    copy.ackMode = self.ackMode;
+    copy.prefetchCount = self.prefetchCount;
+    copy.headers = self.headers;
+    return copy;
+}
+
+@end
@@ -0,0 +1,59 @@
+//
+//  OFFTStompTimingWheel.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  A timer scheduled on a timing wheel.
+ */
+@interface OFFTStompWheelTimer : NSObject
+
+/**
+ *  Stops the timer. Its handler may still be called once if it has already fired.
+ */
+- (void)cancel;
+
+@end
+
+/**
+ *  Runs any number of timers from a single dispatch timer.
+ *
+ *  Timers are kept in a ring of slots, one slot per tick. Each tick only
+ *  the timers in the current slot are examined, so the cost of a tick does
+ *  not depend on how many timers are scheduled, and no dispatch timer runs
+ *  at all while nothing is scheduled. Timers fire on the tick at or after
+ *  they fall due, so are only as precise as the tick interval.
+ */
+@interface OFFTStompTimingWheel : NSObject
+
+/**
+ *  The wheel shared by every client in the process, with a tick interval of 100ms.
+ */
++ (OFFTStompTimingWheel *)sharedWheel;
+
+/**
+ *  @param tickInterval How often the wheel advances.
+ *  @param slotCount    The number of slots. Timers further away than a full
+ *                      turn of the wheel wait for as many turns as needed.
+ */
+- (instancetype)initWithTickInterval:(NSTimeInterval)tickInterval slotCount:(NSUInteger)slotCount NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  Schedules a repeating timer.
+ *
+ *  @param interval How often the timer fires.
+ *  @param queue    The queue the handler is called on.
+ *  @param handler  Called each time the timer fires.
+ *
+ *  @return The timer, which keeps firing until cancelled.
+ */
+- (OFFTStompWheelTimer *)scheduleTimerWithInterval:(NSTimeInterval)interval
+                                             queue:(dispatch_queue_t)queue
+                                           handler:(dispatch_block_t)handler;
+
+@end
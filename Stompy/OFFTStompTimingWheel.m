@@ -0,0 +1,183 @@
+//
+//  OFFTStompTimingWheel.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompTimingWheel.h"
+
+static const NSTimeInterval OFFTStompDefaultTickInterval = 0.1;
+static const NSUInteger OFFTStompDefaultSlotCount = 512;
+
+@interface OFFTStompWheelTimer ()
+
+/**
+ *  The timer's interval as a number of ticks.
+ */
+@property (nonatomic, assign) NSUInteger ticks;
+
+/**
+ *  The number of further turns of the wheel before the timer falls due.
+ */
+@property (nonatomic, assign) NSUInteger rounds;
+
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, copy) dispatch_block_t handler;
+
+@property (atomic, assign) BOOL cancelled;
+
+@end
+
+@implementation OFFTStompWheelTimer
+
+- (void)cancel {
+    // Removed from the wheel when its slot is next reached
+    self.cancelled = YES;
+}
+
+@end
+
+@interface OFFTStompTimingWheel ()
+
+/**
+ *  The slots are only touched on this queue.
+ */
+@property (nonatomic, strong) dispatch_queue_t queue;
+
+@property (nonatomic, assign) NSTimeInterval tickInterval;
+@property (nonatomic, copy) NSArray *slots;
+@property (nonatomic, assign) NSUInteger cursor;
+@property (nonatomic, assign) NSUInteger timerCount;
+
+/**
+ *  Only exists while timers are scheduled.
+ */
+@property (nonatomic, strong) dispatch_source_t source;
+
+@end
+
+@implementation OFFTStompTimingWheel
+
++ (OFFTStompTimingWheel *)sharedWheel {
+    static OFFTStompTimingWheel *sharedWheel;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedWheel = [[self alloc] init];
+    });
+    return sharedWheel;
+}
+
+- (instancetype)init {
+    return [self initWithTickInterval:OFFTStompDefaultTickInterval slotCount:OFFTStompDefaultSlotCount];
+}
+
+- (instancetype)initWithTickInterval:(NSTimeInterval)tickInterval slotCount:(NSUInteger)slotCount {
+    self = [super init];
+    if (self) {
+        NSAssert(tickInterval > 0 && slotCount > 0, @"A timing wheel needs a tick interval and at least one slot.");
+
+        _queue = dispatch_queue_create("OFFTStompTimingWheel", DISPATCH_QUEUE_SERIAL);
+        _tickInterval = tickInterval;
+
+        NSMutableArray *slots = [[NSMutableArray alloc] initWithCapacity:slotCount];
+        for (NSUInteger i = 0; i < slotCount; ++i) {
+            [slots addObject:[[NSMutableArray alloc] init]];
+        }
+        _slots = slots;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_source) {
+        dispatch_source_cancel(_source);
+    }
+}
+
+#pragma mark - Public
+
+- (OFFTStompWheelTimer *)scheduleTimerWithInterval:(NSTimeInterval)interval
+                                             queue:(dispatch_queue_t)queue
+                                           handler:(dispatch_block_t)handler {
+
+    OFFTStompWheelTimer *timer = [[OFFTStompWheelTimer alloc] init];
+    timer.ticks = MAX(1, (NSUInteger)ceil(interval / self.tickInterval));
+    timer.queue = queue ?: dispatch_get_main_queue();
+    timer.handler = handler;
+
+    dispatch_async(self.queue, ^{
+        [self insertTimer:timer];
+        ++self.timerCount;
+        [self startTicking];
+    });
+
+    return timer;
+}
+
+#pragma mark - Private
+
+- (void)insertTimer:(OFFTStompWheelTimer *)timer {
+    const NSUInteger slotCount = self.slots.count;
+    timer.rounds = (timer.ticks - 1) / slotCount;
+    [self.slots[(self.cursor + timer.ticks) % slotCount] addObject:timer];
+}
+
+- (void)startTicking {
+    if (self.source) {
+        return;
+    }
+
+    const uint64_t tick = (uint64_t)(self.tickInterval * NSEC_PER_SEC);
+
+    self.source = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.queue);
+    dispatch_source_set_timer(self.source, dispatch_time(DISPATCH_TIME_NOW, tick), tick, tick / 10);
+
+    __weak typeof(self) weakSelf = self;
+    dispatch_source_set_event_handler(self.source, ^{
+        [weakSelf tick];
+    });
+    dispatch_resume(self.source);
+}
+
+- (void)stopTicking {
+    dispatch_source_cancel(self.source);
+    self.source = nil;
+}
+
+- (void)tick {
+    self.cursor = (self.cursor + 1) % self.slots.count;
+
+    NSMutableArray *slot = self.slots[self.cursor];
+    if (slot.count == 0) {
+        return;
+    }
+
+    NSArray *timers = [slot copy];
+    [slot removeAllObjects];
+
+    for (OFFTStompWheelTimer *timer in timers) {
+        if (timer.cancelled) {
+            --self.timerCount;
+            continue;
+        }
+
+        if (timer.rounds > 0) {
+            timer.rounds -= 1;
+            [slot addObject:timer];
+            continue;
+        }
+
+        dispatch_async(timer.queue, timer.handler);
+
+        // Timers repeat until cancelled
+        [self insertTimer:timer];
+    }
+
+    if (self.timerCount == 0) {
+        [self stopTicking];
+    }
+}
+
+@end
@@ -0,0 +1,23 @@
+//
+//  OFFTStompTransaction.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OFFTStompClient.h"
+
+@interface OFFTStompTransaction : NSObject
+
+- (instancetype)initWithIdentifier:(NSString *)identifier;
+
+- (NSString *)identifier;
+
+/**
+ *  Set once the transaction has been committed, until its receipt arrives.
+ */
+@property (nonatomic, copy) OFFTStompTransactionCompletion commitCompletion;
+
+@end
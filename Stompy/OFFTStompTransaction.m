@@ -0,0 +1,25 @@
+//
+//  OFFTStompTransaction.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompTransaction.h"
+
+@interface OFFTStompTransaction ()
+@property (nonatomic, copy) NSString *identifier;
+@end
+
+@implementation OFFTStompTransaction
+
+- (instancetype)initWithIdentifier:(NSString *)identifier {
+    self = [super init];
+    if (self) {
+        _identifier = [identifier copy];
+    }
+    return self;
+}
+
+@end
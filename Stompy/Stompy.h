@@ -7,8 +7,13 @@
 //
 
 #import "OFFTStompClient.h"
+#import "OFFTStompClientPool.h"
+#import "OFFTStompSubscriptionOptions.h"
 
 
 // TODO: Refactor these into their own framework
 #import "OFFTStompSocketRocketTransport.h"
-#import "OFFTStompGCDAsyncSocketTransport.h"
\ No newline at end of file
+#import "OFFTStompGCDAsyncSocketTransport.h"
+#import "OFFTStompPOSIXSocketTransport.h"
+#import "OFFTStompSockJSTransport.h"
+#import "OFFTStompLoopbackTransport.h"
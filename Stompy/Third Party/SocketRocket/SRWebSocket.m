@@ -727,6 +727,16 @@ static __strong NSData *CRLFCRLF;
     });
 }
 
+- (NSUInteger)bufferedAmount;
+{
+    // Includes anything sent but still waiting to be framed, as that is queued ahead of this
+    __block NSUInteger bufferedAmount = 0;
+    dispatch_sync(_workQueue, ^{
+        bufferedAmount = _outputBuffer.length - _outputBufferOffset;
+    });
+    return bufferedAmount;
+}
+
 - (void)sendPing:(NSData *)data;
 {
     NSAssert(self.readyState == SR_OPEN, @"Invalid State: Cannot call send: until connection is open");
@@ -862,6 +872,11 @@ static inline BOOL closeCodeIsValid(int closeCode) {
     
     switch (opcode) {
         case SROpCodeTextFrame: {
+            if ([self.delegate respondsToSelector:@selector(webSocketShouldConvertTextFrameToString:)] && ![self.delegate webSocketShouldConvertTextFrameToString:self]) {
+                // Validated as UTF-8 while it was read
+                [self _handleMessage:[frameData copy]];
+                break;
+            }
             NSString *str = [[NSString alloc] initWithData:frameData encoding:NSUTF8StringEncoding];
             if (str == nil && frameData) {
                 [self closeWithCode:SRStatusCodeInvalidUTF8 reason:@"Text frames must be valid UTF-8"];
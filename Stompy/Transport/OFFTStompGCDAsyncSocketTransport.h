@@ -14,4 +14,12 @@
                                                  port:(uint16_t)port
                                     connectionTimeout:(NSTimeInterval)connectionTimeout;
 
+/**
+ *  The maximum number of bytes read from the socket at a time. Defaults to 64KB.
+ *
+ *  Larger chunks mean fewer reads under load, while each chunk
+ *  remains in memory for as long as a message body references it.
+ */
+@property (nonatomic, assign) NSUInteger readChunkSize;
+
 @end
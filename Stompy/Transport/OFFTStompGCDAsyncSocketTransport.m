@@ -11,6 +11,8 @@
 
 #define GCDAsyncSocketLoggingEnabled 1
 
+static const NSUInteger OFFTStompGCDAsyncSocketDefaultReadChunkSize = 64 * 1024;
+
 @interface OFFTStompGCDAsyncSocketTransport () <GCDAsyncSocketDelegate>
 @property (nonatomic, strong) GCDAsyncSocket *socket;
 
@@ -38,6 +40,7 @@
         _host = [host copy];
         _port = port;
         _connectionTimeout = connectionTimeout;
+        _readChunkSize = OFFTStompGCDAsyncSocketDefaultReadChunkSize;
         _socket = [[GCDAsyncSocket alloc] initWithDelegate:self delegateQueue:dispatch_get_main_queue()];
     }
     return self;
@@ -62,13 +65,44 @@
 //}
 
 - (void)sendData:(NSData *)data {
-    [self.socket writeData:data withTimeout:-1 tag:0];
-    [self.socket readDataWithTimeout:-1 tag:0];
+    // GCDAsyncSocket retains rather than copies the data it writes
+    // Each write is tagged with its length so it can be reported once written
+    [self.socket writeData:data withTimeout:-1 tag:(long)data.length];
+}
+
+- (void)sendDataParts:(NSArray *)parts {
+    // Writes are queued and sent in order
+    for (NSData *part in parts) {
+        [self.socket writeData:part withTimeout:-1 tag:(long)part.length];
+    }
+}
+
+- (BOOL)reportsWrites {
+    return YES;
+}
+
+- (void)setDelegateQueue:(dispatch_queue_t)queue {
+    [self.socket setDelegateQueue:queue ?: dispatch_get_main_queue()];
+}
+
+#pragma mark - Helpers
+
+/**
+ *  Queues the next read. Exactly one read is outstanding while connected,
+ *  so data is received whether or not anything is being sent.
+ */
+- (void)readNextChunk {
+    [self.socket readDataWithTimeout:-1
+                              buffer:nil
+                        bufferOffset:0
+                           maxLength:self.readChunkSize
+                                 tag:0];
 }
 
 #pragma mark - GCDAsyncSocketDelegate
 
 - (void)socket:(GCDAsyncSocket *)sock didConnectToHost:(NSString *)host port:(uint16_t)port {
+    [self readNextChunk];
     [self.delegate transportDidOpen:self];
 }
 
@@ -76,8 +110,20 @@
     [self.delegate transportDidClose:self];
 }
 
+- (void)socket:(GCDAsyncSocket *)sock didWriteDataWithTag:(long)tag {
+    if ([self.delegate respondsToSelector:@selector(transport:didWriteDataOfLength:)]) {
+        [self.delegate transport:self didWriteDataOfLength:(NSUInteger)tag];
+    }
+}
+
 - (void)socket:(GCDAsyncSocket *)sock didReadData:(NSData *)data withTag:(long)tag {
-    NSLog(@"Incoming!");
+    if ([self.delegate respondsToSelector:@selector(transport:didReceiveData:)]) {
+        [self.delegate transport:self didReceiveData:data];
+    } else {
+        [self.delegate transport:self didReceiveMessage:[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding]];
+    }
+    
+    [self readNextChunk];
 }
 
 @end
@@ -0,0 +1,147 @@
+//
+//  OFFTStompLoopbackTransport.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompTransportAdapter.h"
+
+@class OFFTStompLoopbackBroker;
+
+/**
+ *  Handles a frame received by a loopback broker.
+ *
+ *  @param command The frame's command, e.g. @"SEND".
+ *  @param headers The frame's headers.
+ *  @param body    The frame's body, or nil.
+ *
+ *  @return YES if the frame has been handled, and the broker should not handle it itself.
+ */
+typedef BOOL(^OFFTStompLoopbackFrameHandler)(NSString *command, NSDictionary *headers, NSData *body);
+
+/**
+ *  A transport connected in memory to a loopback broker, with no sockets involved.
+ *
+ *  Useful for testing, and for measuring the cost of parsing
+ *  and dispatching frames separately from the network.
+ */
+@interface OFFTStompLoopbackTransport : NSObject <OFFTStompTransportAdapter>
+
++ (OFFTStompLoopbackTransport *)transportWithBroker:(OFFTStompLoopbackBroker *)broker;
+
+@property (nonatomic, strong, readonly) OFFTStompLoopbackBroker *broker;
+
+@end
+
+/**
+ *  A fake STOMP broker for loopback transports to connect to.
+ *
+ *  The broker answers CONNECT, SUBSCRIBE, UNSUBSCRIBE, SEND and receipt requests,
+ *  delivers sent messages to matching subscriptions, and can push streams of
+ *  messages at a given rate. Messages of subscriptions that are not acknowledged
+ *  automatically carry an ack header when 1.2 has been negotiated, ACK and NACK
+ *  frames are accepted but otherwise ignored. Messages sent in a transaction are
+ *  only delivered once it has been committed. Any number of transports may be
+ *  connected at once.
+ *
+ *  All work is done on the broker's own serial queue, and frames are sent to
+ *  clients as though they had been received from the network.
+ */
+@interface OFFTStompLoopbackBroker : NSObject
+
+/**
+ *  The queue the broker processes frames on.
+ */
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+
+/**
+ *  The protocol version the broker negotiates. Defaults to @"1.2".
+ */
+@property (nonatomic, copy) NSString *version;
+
+/**
+ *  The heart-beat header of CONNECTED frames, e.g. @"1000,0". Defaults to nil, for none.
+ *  The broker never sends heart-beats, so it appears silent to clients expecting them.
+ */
+@property (nonatomic, copy) NSString *heartbeat;
+
+/**
+ *  Whether CONNECT frames are answered with an ERROR frame. Defaults to NO.
+ */
+@property (nonatomic, assign) BOOL rejectsConnections;
+
+/**
+ *  Whether frames with a receipt header are answered with a RECEIPT frame. Defaults to YES.
+ */
+@property (nonatomic, assign) BOOL sendsReceipts;
+
+/**
+ *  Whether SEND frames are delivered to subscriptions to their destination. Defaults to YES.
+ */
+@property (nonatomic, assign) BOOL deliversSentMessages;
+
+/**
+ *  Pushed messages are delivered to clients in chunks of up to this many bytes,
+ *  as a network transport would read them. Defaults to 64KB.
+ */
+@property (nonatomic, assign) NSUInteger maximumChunkLength;
+
+/**
+ *  How long each write from a client takes to reach the broker, as though sent
+ *  over a slow network. Writes are reported to the client once the broker has
+ *  read them, so a delay lets data back up in the client. Defaults to 0.
+ */
+@property (nonatomic, assign) NSTimeInterval writeDelay;
+
+/**
+ *  When set, called on the broker's queue for every frame received.
+ */
+@property (nonatomic, copy) OFFTStompLoopbackFrameHandler frameHandler;
+
+/**
+ *  The number of frames received from clients.
+ */
+@property (nonatomic, assign, readonly) NSUInteger receivedFrameCount;
+
+/**
+ *  The number of writes received from clients, each of which may hold any number of frames.
+ */
+@property (nonatomic, assign, readonly) NSUInteger receivedWriteCount;
+
+/**
+ *  The number of MESSAGE frames sent to clients.
+ */
+@property (nonatomic, assign, readonly) NSUInteger sentMessageCount;
+
+/**
+ *  Sends a frame to every connected client.
+ *
+ *  @param command The frame's command, e.g. @"MESSAGE".
+ *  @param headers The frame's headers.
+ *  @param body    The frame's body, or nil.
+ */
+- (void)sendFrameWithCommand:(NSString *)command headers:(NSDictionary *)headers body:(NSData *)body;
+
+/**
+ *  Pushes MESSAGE frames to every subscription to a destination.
+ *
+ *  @param count             The number of messages to push.
+ *  @param destination       The destination subscribed to.
+ *  @param bodyLength        The length of each message's body.
+ *  @param messagesPerSecond The rate to push messages at, or 0 to push them as fast as possible.
+ *  @param completion        Called on the broker's queue once every message has been pushed. May be nil.
+ */
+- (void)pushMessages:(NSUInteger)count
+       toDestination:(NSString *)destination
+          bodyLength:(NSUInteger)bodyLength
+                rate:(double)messagesPerSecond
+          completion:(dispatch_block_t)completion;
+
+/**
+ *  Closes every connection, as though the broker had gone away.
+ */
+- (void)closeConnections;
+
+@end
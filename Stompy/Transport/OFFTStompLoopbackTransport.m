@@ -0,0 +1,611 @@
+//
+//  OFFTStompLoopbackTransport.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompLoopbackTransport.h"
+#import "OFFTStompFrame.h"
+#import "OFFTStompFrameDecoder.h"
+#import "OFFTStompFrameSerializer.h"
+#import "OFFTStompCodecTables.h"
+
+static const NSUInteger OFFTStompLoopbackDefaultChunkLength = 64 * 1024;
+
+// Messages pushed as fast as possible are pushed in bursts of this many, so other work can interleave
+static const NSUInteger OFFTStompLoopbackBurstLength = 1024;
+
+// Messages pushed at a given rate are pushed on this interval
+static const NSTimeInterval OFFTStompLoopbackPushInterval = 0.01;
+
+@interface OFFTStompLoopbackTransport ()
+@property (nonatomic, strong) OFFTStompLoopbackBroker *broker;
+@property (nonatomic, strong) dispatch_queue_t delegateQueue;
+
+/**
+ *  Writes pass through this queue on their way to the broker, keeping them in order while delayed.
+ */
+@property (nonatomic, strong) dispatch_queue_t writeQueue;
+
+- (void)brokerDidOpenConnection;
+- (void)brokerDidCloseConnection;
+- (void)brokerDidSendData:(NSData *)data;
+- (void)brokerDidReadDataOfLength:(NSUInteger)length;
+
+@end
+
+@interface OFFTStompLoopbackBroker ()
+
+- (void)openConnectionForTransport:(OFFTStompLoopbackTransport *)transport;
+- (void)closeConnectionForTransport:(OFFTStompLoopbackTransport *)transport;
+- (void)transport:(OFFTStompLoopbackTransport *)transport didSendData:(NSData *)data;
+
+@end
+
+#pragma mark - Transport
+
+@implementation OFFTStompLoopbackTransport
+@synthesize delegate;
+
++ (OFFTStompLoopbackTransport *)transportWithBroker:(OFFTStompLoopbackBroker *)broker {
+    OFFTStompLoopbackTransport *transport = [[self alloc] init];
+    transport.broker = broker;
+    transport.delegateQueue = dispatch_get_main_queue();
+    transport.writeQueue = dispatch_queue_create("OFFTStompLoopbackTransport", DISPATCH_QUEUE_SERIAL);
+    return transport;
+}
+
+- (NSString *)host {
+    return @"loopback";
+}
+
+- (void)open {
+    OFFTStompLoopbackBroker *broker = self.broker;
+    dispatch_async(broker.queue, ^{
+        [broker openConnectionForTransport:self];
+    });
+}
+
+- (void)close {
+    // Only once everything already sent has arrived
+    OFFTStompLoopbackBroker *broker = self.broker;
+    dispatch_async(self.writeQueue, ^{
+        dispatch_async(broker.queue, ^{
+            [broker closeConnectionForTransport:self];
+        });
+    });
+}
+
+- (void)sendData:(NSData *)data {
+    OFFTStompLoopbackBroker *broker = self.broker;
+    dispatch_async(self.writeQueue, ^{
+        const NSTimeInterval writeDelay = broker.writeDelay;
+        if (writeDelay > 0) {
+            [NSThread sleepForTimeInterval:writeDelay];
+        }
+        dispatch_async(broker.queue, ^{
+            [broker transport:self didSendData:data];
+        });
+    });
+}
+
+- (void)sendDataParts:(NSArray *)parts {
+    for (NSData *part in parts) {
+        [self sendData:part];
+    }
+}
+
+- (void)setDelegateQueue:(dispatch_queue_t)queue {
+    _delegateQueue = queue ?: dispatch_get_main_queue();
+}
+
+- (BOOL)reportsWrites {
+    return YES;
+}
+
+#pragma mark - Broker
+
+- (void)brokerDidOpenConnection {
+    dispatch_async(self.delegateQueue, ^{
+        [self.delegate transportDidOpen:self];
+    });
+}
+
+- (void)brokerDidCloseConnection {
+    dispatch_async(self.delegateQueue, ^{
+        [self.delegate transportDidClose:self];
+    });
+}
+
+- (void)brokerDidReadDataOfLength:(NSUInteger)length {
+    dispatch_async(self.delegateQueue, ^{
+        if ([self.delegate respondsToSelector:@selector(transport:didWriteDataOfLength:)]) {
+            [self.delegate transport:self didWriteDataOfLength:length];
+        }
+    });
+}
+
+- (void)brokerDidSendData:(NSData *)data {
+    dispatch_async(self.delegateQueue, ^{
+        if ([self.delegate respondsToSelector:@selector(transport:didReceiveData:)]) {
+            [self.delegate transport:self didReceiveData:data];
+        } else {
+            [self.delegate transport:self didReceiveMessage:[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding]];
+        }
+    });
+}
+
+@end
+
+#pragma mark - Connection
+
+/**
+ *  The broker's end of a connection from a loopback transport.
+ */
+@interface OFFTStompLoopbackConnection : NSObject
+
+@property (nonatomic, weak) OFFTStompLoopbackTransport *transport;
+
+@property (nonatomic, strong) OFFTStompFrameDecoder *frameDecoder;
+@property (nonatomic, strong) OFFTStompFrameSerializer *frameSerializer;
+
+/**
+ *  A dictionary of subscription IDs : destinations
+ */
+@property (nonatomic, strong) NSMutableDictionary *subscriptions;
+
+/**
+ *  A dictionary of subscription IDs : ack modes, for subscriptions not acknowledged automatically
+ */
+@property (nonatomic, strong) NSMutableDictionary *ackModes;
+
+/**
+ *  A dictionary of transaction IDs : the SEND frames sent in them, as arrays of destination and body
+ */
+@property (nonatomic, strong) NSMutableDictionary *transactions;
+
+/**
+ *  Serialized frames waiting to be sent to the client as one chunk.
+ */
+@property (nonatomic, strong) NSMutableData *pendingData;
+
+@end
+
+@implementation OFFTStompLoopbackConnection
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _frameDecoder = [[OFFTStompFrameDecoder alloc] init];
+        _frameSerializer = [[OFFTStompFrameSerializer alloc] init];
+        _subscriptions = [[NSMutableDictionary alloc] init];
+        _ackModes = [[NSMutableDictionary alloc] init];
+        _transactions = [[NSMutableDictionary alloc] init];
+        _pendingData = [[NSMutableData alloc] init];
+    }
+    return self;
+}
+
+- (void)sendFrame:(OFFTStompFrame *)frame {
+    [self.pendingData appendData:[self.frameSerializer serializeFrame:frame]];
+}
+
+/**
+ *  Sends the pending frames to the client.
+ *
+ *  @param maximumChunkLength The most bytes to send at once, or 0 to send everything as one chunk.
+ */
+- (void)flushWithMaximumChunkLength:(NSUInteger)maximumChunkLength {
+    NSData *pendingData = self.pendingData;
+    if (pendingData.length == 0) {
+        return;
+    }
+    self.pendingData = [[NSMutableData alloc] init];
+
+    if (maximumChunkLength == 0 || pendingData.length <= maximumChunkLength) {
+        [self.transport brokerDidSendData:pendingData];
+        return;
+    }
+
+    // Chunks reference the pending data, which is never modified again
+    for (NSUInteger offset = 0; offset < pendingData.length; offset += maximumChunkLength) {
+        NSRange range = NSMakeRange(offset, MIN(maximumChunkLength, pendingData.length - offset));
+        [self.transport brokerDidSendData:[pendingData subdataWithRange:range]];
+    }
+}
+
+@end
+
+#pragma mark - Broker
+
+@interface OFFTStompLoopbackBroker () <OFFTStompFrameDecoderDelegate>
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, assign) NSUInteger receivedFrameCount;
+@property (nonatomic, assign) NSUInteger receivedWriteCount;
+@property (nonatomic, assign) NSUInteger sentMessageCount;
+
+@property (nonatomic, strong) NSMutableArray *connections;
+
+/**
+ *  The frame outgoing frames are built in, reused for every frame.
+ */
+@property (nonatomic, strong) OFFTStompFrame *outgoingFrame;
+
+@end
+
+@implementation OFFTStompLoopbackBroker
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _queue = dispatch_queue_create("OFFTStompLoopbackBroker", DISPATCH_QUEUE_SERIAL);
+        _version = @"1.2";
+        _sendsReceipts = YES;
+        _deliversSentMessages = YES;
+        _maximumChunkLength = OFFTStompLoopbackDefaultChunkLength;
+        _connections = [[NSMutableArray alloc] init];
+        _outgoingFrame = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandUnknown];
+    }
+    return self;
+}
+
+#pragma mark - Public
+
+- (void)sendFrameWithCommand:(NSString *)command headers:(NSDictionary *)headers body:(NSData *)body {
+    NSData *commandBytes = [command dataUsingEncoding:NSUTF8StringEncoding];
+    OFFTStompFrameCommand frameCommand = OFFTStompCommandFromBytes(commandBytes.bytes, commandBytes.length);
+    if (frameCommand == OFFTStompFrameCommandUnknown) {
+        NSAssert(0, @"Unknown frame command: %@", command);
+        return;
+    }
+
+    headers = [headers copy];
+    body = [body copy];
+
+    dispatch_async(self.queue, ^{
+        for (OFFTStompLoopbackConnection *connection in self.connections) {
+            OFFTStompFrame *frame = self.outgoingFrame;
+            [frame resetWithCommand:frameCommand];
+            [headers enumerateKeysAndObjectsUsingBlock:^(NSString *header, NSString *value, BOOL *stop) {
+                [frame setHeader:header value:value];
+            }];
+            [frame setBody:body];
+
+            [connection sendFrame:frame];
+        }
+        [self flushConnections];
+    });
+}
+
+- (void)pushMessages:(NSUInteger)count
+       toDestination:(NSString *)destination
+          bodyLength:(NSUInteger)bodyLength
+                rate:(double)messagesPerSecond
+          completion:(dispatch_block_t)completion {
+
+    NSMutableData *body = [[NSMutableData alloc] initWithLength:bodyLength];
+    memset(body.mutableBytes, 'x', bodyLength);
+
+    NSData *messageBody = [body copy];
+    destination = [destination copy];
+    completion = [completion copy];
+
+    dispatch_async(self.queue, ^{
+        if (messagesPerSecond > 0) {
+            [self pushMessages:count toDestination:destination body:messageBody rate:messagesPerSecond completion:completion];
+        } else {
+            [self pushMessages:count toDestination:destination body:messageBody completion:completion];
+        }
+    });
+}
+
+- (void)closeConnections {
+    dispatch_async(self.queue, ^{
+        for (OFFTStompLoopbackConnection *connection in [self.connections copy]) {
+            [self closeConnectionForTransport:connection.transport];
+        }
+    });
+}
+
+#pragma mark - Transports
+
+- (void)openConnectionForTransport:(OFFTStompLoopbackTransport *)transport {
+    if ([self connectionForTransport:transport]) {
+        return;
+    }
+
+    OFFTStompLoopbackConnection *connection = [[OFFTStompLoopbackConnection alloc] init];
+    connection.transport = transport;
+    connection.frameDecoder.delegate = self;
+    [self.connections addObject:connection];
+
+    [transport brokerDidOpenConnection];
+}
+
+- (void)closeConnectionForTransport:(OFFTStompLoopbackTransport *)transport {
+    OFFTStompLoopbackConnection *connection = [self connectionForTransport:transport];
+    if (connection == nil) {
+        return;
+    }
+
+    [connection flushWithMaximumChunkLength:self.maximumChunkLength];
+    [self.connections removeObject:connection];
+
+    [transport brokerDidCloseConnection];
+}
+
+- (void)transport:(OFFTStompLoopbackTransport *)transport didSendData:(NSData *)data {
+    OFFTStompLoopbackConnection *connection = [self connectionForTransport:transport];
+    if (connection == nil) {
+        return;
+    }
+
+    ++self.receivedWriteCount;
+    [connection.frameDecoder appendData:data];
+    [transport brokerDidReadDataOfLength:data.length];
+
+    // Sent messages may have been delivered to any connection
+    [self flushConnections];
+}
+
+#pragma mark - Frame Decoder Delegate
+
+- (void)frameDecoder:(OFFTStompFrameDecoder *)decoder didDecodeFrame:(OFFTStompFrame *)frame {
+    OFFTStompLoopbackConnection *connection = nil;
+    for (OFFTStompLoopbackConnection *candidate in self.connections) {
+        if (candidate.frameDecoder == decoder) {
+            connection = candidate;
+            break;
+        }
+    }
+    if (connection == nil) {
+        return;
+    }
+
+    ++self.receivedFrameCount;
+
+    if (self.frameHandler) {
+        NSUInteger length = 0;
+        const char *name = OFFTStompCommandName(frame.command, &length);
+        NSString *command = name ? [[NSString alloc] initWithBytes:name length:length encoding:NSUTF8StringEncoding] : @"";
+
+        if (self.frameHandler(command, frame.allHeaders ?: @{}, frame.body)) {
+            return;
+        }
+    }
+
+    switch (frame.command) {
+        case OFFTStompFrameCommandConnect:
+            [self handleConnectFrame:frame forConnection:connection];
+            return;
+
+        case OFFTStompFrameCommandSubscribe: {
+            NSString *identifier = [frame valueForHeaderName:OFFTStompHeaderNameID];
+            NSString *destination = [frame valueForHeaderName:OFFTStompHeaderNameDestination];
+            if (identifier && destination) {
+                connection.subscriptions[identifier] = destination;
+
+                NSString *ackMode = [frame valueForHeaderName:OFFTStompHeaderNameAck];
+                if (ackMode && [ackMode isEqualToString:@"auto"] == NO) {
+                    connection.ackModes[identifier] = ackMode;
+                }
+            }
+            break;
+        }
+
+        case OFFTStompFrameCommandUnsubscribe: {
+            NSString *identifier = [frame valueForHeaderName:OFFTStompHeaderNameID];
+            if (identifier) {
+                [connection.subscriptions removeObjectForKey:identifier];
+                [connection.ackModes removeObjectForKey:identifier];
+            }
+            break;
+        }
+
+        case OFFTStompFrameCommandSend: {
+            NSString *destination = [frame valueForHeaderName:OFFTStompHeaderNameDestination];
+            NSString *transaction = [frame valueForHeaderName:OFFTStompHeaderNameTransaction];
+
+            // Delivered once the transaction is committed
+            NSMutableArray *sends = transaction ? connection.transactions[transaction] : nil;
+            if (sends) {
+                if (destination) {
+                    [sends addObject:@[ destination, [frame.body copy] ?: [NSData data] ]];
+                }
+            } else if (self.deliversSentMessages) {
+                [self deliverMessageToDestination:destination body:frame.body];
+            }
+            break;
+        }
+
+        case OFFTStompFrameCommandBegin: {
+            NSString *transaction = [frame valueForHeaderName:OFFTStompHeaderNameTransaction];
+            if (transaction) {
+                connection.transactions[transaction] = [[NSMutableArray alloc] init];
+            }
+            break;
+        }
+
+        case OFFTStompFrameCommandCommit: {
+            NSString *transaction = [frame valueForHeaderName:OFFTStompHeaderNameTransaction];
+            NSArray *sends = transaction ? connection.transactions[transaction] : nil;
+            if (transaction) {
+                [connection.transactions removeObjectForKey:transaction];
+            }
+            if (self.deliversSentMessages) {
+                for (NSArray *send in sends) {
+                    [self deliverMessageToDestination:send[0] body:send[1]];
+                }
+            }
+            break;
+        }
+
+        case OFFTStompFrameCommandAbort: {
+            NSString *transaction = [frame valueForHeaderName:OFFTStompHeaderNameTransaction];
+            if (transaction) {
+                [connection.transactions removeObjectForKey:transaction];
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    NSString *receipt = [frame valueForHeaderName:OFFTStompHeaderNameReceipt];
+    if (receipt && self.sendsReceipts) {
+        OFFTStompFrame *receiptFrame = self.outgoingFrame;
+        [receiptFrame resetWithCommand:OFFTStompFrameCommandReceipt];
+        [receiptFrame setHeader:OFFTStompHeaderReceiptID value:receipt];
+        [connection sendFrame:receiptFrame];
+    }
+}
+
+#pragma mark - Private
+
+- (OFFTStompLoopbackConnection *)connectionForTransport:(OFFTStompLoopbackTransport *)transport {
+    for (OFFTStompLoopbackConnection *connection in self.connections) {
+        if (connection.transport == transport) {
+            return connection;
+        }
+    }
+    return nil;
+}
+
+- (void)flushConnections {
+    for (OFFTStompLoopbackConnection *connection in self.connections) {
+        [connection flushWithMaximumChunkLength:self.maximumChunkLength];
+    }
+}
+
+- (void)handleConnectFrame:(OFFTStompFrame *)frame forConnection:(OFFTStompLoopbackConnection *)connection {
+    OFFTStompFrame *reply = self.outgoingFrame;
+
+    if (self.rejectsConnections) {
+        [reply resetWithCommand:OFFTStompFrameCommandError];
+        [reply setHeader:@"message" value:@"Connection rejected"];
+        [connection sendFrame:reply];
+        [self closeConnectionForTransport:connection.transport];
+        return;
+    }
+
+    [reply resetWithCommand:OFFTStompFrameCommandConnected];
+    [reply setHeader:OFFTStompHeaderVersion value:self.version];
+    if (self.heartbeat) {
+        [reply setHeader:OFFTStompHeaderHeartBeat value:self.heartbeat];
+    }
+    [connection sendFrame:reply];
+
+    OFFTStompVersion version = [self.version isEqualToString:@"1.1"] ? OFFTStompVersion1_1 : OFFTStompVersion1_2;
+    connection.frameSerializer.version = version;
+    connection.frameDecoder.version = version;
+}
+
+- (void)deliverMessageToDestination:(NSString *)destination body:(NSData *)body {
+    if (destination == nil) {
+        return;
+    }
+
+    for (OFFTStompLoopbackConnection *connection in self.connections) {
+        [connection.subscriptions enumerateKeysAndObjectsUsingBlock:^(NSString *identifier, NSString *subscribed, BOOL *stop) {
+            if ([subscribed isEqualToString:destination] == NO) {
+                return;
+            }
+
+            NSString *messageID = [NSString stringWithFormat:@"%lu", (unsigned long)++self.sentMessageCount];
+
+            OFFTStompFrame *frame = self.outgoingFrame;
+            [frame resetWithCommand:OFFTStompFrameCommandMessage];
+            [frame setHeader:OFFTStompHeaderDestination value:destination];
+            [frame setHeader:OFFTStompHeaderSubscription value:identifier];
+            [frame setHeader:OFFTStompHeaderMessageID value:messageID];
+
+            // 1.2 messages that must be acknowledged carry the ID to acknowledge them with
+            if (connection.ackModes[identifier] && connection.frameSerializer.version == OFFTStompVersion1_2) {
+                [frame setHeader:OFFTStompHeaderAck value:messageID];
+            }
+            [frame setBody:body];
+
+            [connection sendFrame:frame];
+        }];
+    }
+}
+
+/**
+ *  Pushes messages as fast as possible, a burst at a time.
+ */
+- (void)pushMessages:(NSUInteger)count
+       toDestination:(NSString *)destination
+                body:(NSData *)body
+          completion:(dispatch_block_t)completion {
+
+    const NSUInteger burst = MIN(count, OFFTStompLoopbackBurstLength);
+    for (NSUInteger i = 0; i < burst; ++i) {
+        [self deliverMessageToDestination:destination body:body];
+
+        // Hand over each chunk as soon as it is full, as a socket would
+        for (OFFTStompLoopbackConnection *connection in self.connections) {
+            if (connection.pendingData.length >= self.maximumChunkLength) {
+                [connection flushWithMaximumChunkLength:self.maximumChunkLength];
+            }
+        }
+    }
+    [self flushConnections];
+
+    if (burst == count) {
+        if (completion) {
+            completion();
+        }
+        return;
+    }
+
+    dispatch_async(self.queue, ^{
+        [self pushMessages:count - burst toDestination:destination body:body completion:completion];
+    });
+}
+
+/**
+ *  Pushes messages at the given rate, sending however many are due on a fixed interval.
+ */
+- (void)pushMessages:(NSUInteger)count
+       toDestination:(NSString *)destination
+                body:(NSData *)body
+                rate:(double)messagesPerSecond
+          completion:(dispatch_block_t)completion {
+
+    if (count == 0) {
+        if (completion) {
+            completion();
+        }
+        return;
+    }
+
+    const CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    __block NSUInteger pushed = 0;
+
+    // The handler keeps the timer alive until it is cancelled
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.queue);
+    dispatch_source_set_timer(timer,
+                              dispatch_time(DISPATCH_TIME_NOW, 0),
+                              (uint64_t)(OFFTStompLoopbackPushInterval * NSEC_PER_SEC),
+                              (uint64_t)(OFFTStompLoopbackPushInterval * NSEC_PER_SEC / 10));
+    dispatch_source_set_event_handler(timer, ^{
+        const NSUInteger due = MIN(count, (NSUInteger)((CFAbsoluteTimeGetCurrent() - start) * messagesPerSecond) + 1);
+        for (; pushed < due; ++pushed) {
+            [self deliverMessageToDestination:destination body:body];
+        }
+        [self flushConnections];
+
+        if (pushed == count) {
+            dispatch_source_cancel(timer);
+            if (completion) {
+                completion();
+            }
+        }
+    });
+    dispatch_resume(timer);
+}
+
+@end
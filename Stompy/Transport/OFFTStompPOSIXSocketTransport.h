@@ -0,0 +1,52 @@
+//
+//  OFFTStompPOSIXSocketTransport.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompTransportAdapter.h"
+
+/**
+ *  A raw TCP transport built directly on non-blocking BSD sockets.
+ *
+ *  Each transport runs its own event loop thread, driven by epoll on Linux
+ *  and kqueue elsewhere. Received bytes are read into a reusable buffer and
+ *  passed to the delegate without being copied, and frames are written with
+ *  a single gathered write wherever possible.
+ *
+ *  Properties affecting the socket are applied when it is opened.
+ */
+@interface OFFTStompPOSIXSocketTransport : NSObject <OFFTStompTransportAdapter>
+
++ (OFFTStompPOSIXSocketTransport *)transportWithHost:(NSString *)host
+                                                port:(uint16_t)port
+                                   connectionTimeout:(NSTimeInterval)connectionTimeout;
+
+/**
+ *  Whether TCP_NODELAY is set, disabling Nagle's algorithm. Defaults to YES.
+ */
+@property (nonatomic, assign) BOOL noDelay;
+
+/**
+ *  The SO_RCVBUF size in bytes, or 0 to use the system default.
+ */
+@property (nonatomic, assign) int receiveBufferSize;
+
+/**
+ *  The SO_SNDBUF size in bytes, or 0 to use the system default.
+ */
+@property (nonatomic, assign) int sendBufferSize;
+
+/**
+ *  The size of the buffer that received bytes are read into. Defaults to 256KB.
+ *
+ *  Up to four buffers are kept, and each is reused once nothing references
+ *  the bytes read into it. Further buffers are only allocated while message
+ *  bodies still reference every one of them, and are freed once the last
+ *  body referencing them has been released.
+ */
+@property (nonatomic, assign) NSUInteger readBufferSize;
+
+@end
@@ -0,0 +1,759 @@
+//
+//  OFFTStompPOSIXSocketTransport.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompPOSIXSocketTransport.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#else
+#include <sys/event.h>
+#endif
+
+// Platforms without MSG_NOSIGNAL use SO_NOSIGPIPE instead
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static const NSUInteger OFFTStompPOSIXDefaultReadBufferSize = 256 * 1024;
+
+// A new read buffer is started once less than this remains in the current one
+static const NSUInteger OFFTStompPOSIXMinimumReadSpace = 16 * 1024;
+
+// The number of read buffers kept for reuse
+static const NSUInteger OFFTStompPOSIXMaximumReadBuffers = 4;
+
+static const int OFFTStompPOSIXMaximumEvents = 8;
+static const int OFFTStompPOSIXMaximumIOVecs = 64;
+
+typedef NS_ENUM(NSUInteger, OFFTStompPOSIXState) {
+    OFFTStompPOSIXStateClosed,
+    OFFTStompPOSIXStateConnecting,
+    OFFTStompPOSIXStateOpen,
+    OFFTStompPOSIXStateClosing,
+};
+
+#pragma mark - Poller
+
+// A thin layer over epoll and kqueue, only as much as the event loop needs
+
+typedef struct {
+    int fd;
+    BOOL readable;
+    BOOL writable;
+} OFFTStompPollEvent;
+
+static int OFFTStompPollerCreate(void) {
+#if defined(__linux__)
+    return epoll_create1(EPOLL_CLOEXEC);
+#else
+    return kqueue();
+#endif
+}
+
+/**
+ *  Watches a descriptor for reading, and optionally writing.
+ *
+ *  @param add Whether the descriptor is being watched for the first time.
+ */
+static int OFFTStompPollerWatch(int poller, int fd, BOOL add, BOOL writable) {
+#if defined(__linux__)
+    struct epoll_event event = { .events = EPOLLIN | (writable ? EPOLLOUT : 0), .data.fd = fd };
+    return epoll_ctl(poller, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event);
+#else
+    (void)add;
+    struct kevent changes[2];
+    EV_SET(&changes[0], fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+    EV_SET(&changes[1], fd, EVFILT_WRITE, EV_ADD | (writable ? EV_ENABLE : EV_DISABLE), 0, 0, NULL);
+    return kevent(poller, changes, 2, NULL, 0, NULL);
+#endif
+}
+
+/**
+ *  Waits for events.
+ *
+ *  @param timeout The maximum time to wait in milliseconds, or -1 to wait indefinitely.
+ *
+ *  @return The number of events, or -1 on error.
+ */
+static int OFFTStompPollerWait(int poller, OFFTStompPollEvent *events, int timeout) {
+#if defined(__linux__)
+    struct epoll_event raw[OFFTStompPOSIXMaximumEvents];
+    int count = epoll_wait(poller, raw, OFFTStompPOSIXMaximumEvents, timeout);
+    for (int i = 0; i < count; ++i) {
+        events[i].fd = raw[i].data.fd;
+        // Errors and hang-ups are discovered by the following read
+        events[i].readable = (raw[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0;
+        events[i].writable = (raw[i].events & EPOLLOUT) != 0;
+    }
+    return count;
+#else
+    struct kevent raw[OFFTStompPOSIXMaximumEvents];
+    struct timespec interval = { .tv_sec = timeout / 1000, .tv_nsec = (timeout % 1000) * 1000000 };
+    int count = kevent(poller, NULL, 0, raw, OFFTStompPOSIXMaximumEvents, (timeout < 0) ? NULL : &interval);
+    for (int i = 0; i < count; ++i) {
+        events[i].fd = (int)raw[i].ident;
+        events[i].readable = raw[i].filter == EVFILT_READ;
+        events[i].writable = raw[i].filter == EVFILT_WRITE;
+    }
+    return count;
+#endif
+}
+
+#pragma mark - Read Buffer
+
+/**
+ *  A buffer that received bytes are read into, handed to the delegate as
+ *  slices that reference it directly. It can only be rewound and reused
+ *  once every slice of it has been released.
+ */
+@interface OFFTStompPOSIXReadBuffer : NSObject {
+@public
+    uint8_t *_bytes;
+    NSUInteger _capacity;
+    NSUInteger _length;
+    atomic_uint_fast32_t _liveSlices;
+}
+@end
+
+@implementation OFFTStompPOSIXReadBuffer
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    self = [super init];
+    if (self) {
+        _bytes = malloc(capacity);
+        _capacity = capacity;
+        atomic_init(&_liveSlices, 0);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_bytes);
+}
+
+- (NSData *)sliceWithRange:(NSRange)range {
+    atomic_fetch_add(&_liveSlices, 1);
+
+    OFFTStompPOSIXReadBuffer *buffer = self;
+    return [[NSData alloc] initWithBytesNoCopy:_bytes + range.location
+                                        length:range.length
+                                   deallocator:^(void *bytes, NSUInteger length) {
+                                       // Also keeps the buffer alive for the lifetime of the slice
+                                       atomic_fetch_sub(&buffer->_liveSlices, 1);
+                                   }];
+}
+
+@end
+
+#pragma mark - Transport
+
+@interface OFFTStompPOSIXSocketTransport () {
+    // Guards the state, the descriptors and the pending writes,
+    // which are shared between the event loop and senders
+    pthread_mutex_t _lock;
+
+    OFFTStompPOSIXState _state;
+    int _fd;
+    int _poller;
+    int _wakeRead;
+    int _wakeWrite;
+
+    NSMutableArray *_pendingWrites;
+    NSUInteger _pendingOffset;
+    BOOL _watchingWritable;
+
+    // Only used by the event loop thread
+    struct addrinfo *_addresses;
+    struct addrinfo *_nextAddress;
+    NSMutableArray *_readBuffers;
+    NSUInteger _readBufferIndex;
+}
+
+@property (nonatomic, copy) NSString *host;
+@property (nonatomic, assign) uint16_t port;
+@property (nonatomic, assign) NSTimeInterval connectionTimeout;
+
+@property (nonatomic, strong) dispatch_queue_t delegateQueue;
+
+@end
+
+@implementation OFFTStompPOSIXSocketTransport
+@synthesize delegate;
+
++ (OFFTStompPOSIXSocketTransport *)transportWithHost:(NSString *)host
+                                                port:(uint16_t)port
+                                   connectionTimeout:(NSTimeInterval)connectionTimeout {
+
+    return [[self alloc] initWithHost:host port:port connectionTimeout:connectionTimeout];
+}
+
+- (instancetype)initWithHost:(NSString *)host
+                        port:(uint16_t)port
+           connectionTimeout:(NSTimeInterval)connectionTimeout {
+    self = [super init];
+    if (self) {
+        _host = [host copy];
+        _port = port;
+        _connectionTimeout = connectionTimeout;
+        _noDelay = YES;
+        _readBufferSize = OFFTStompPOSIXDefaultReadBufferSize;
+        _delegateQueue = dispatch_get_main_queue();
+
+        pthread_mutex_init(&_lock, NULL);
+        _state = OFFTStompPOSIXStateClosed;
+        _fd = -1;
+        _poller = -1;
+        _wakeRead = -1;
+        _wakeWrite = -1;
+        _pendingWrites = [[NSMutableArray alloc] init];
+        _readBuffers = [[NSMutableArray alloc] initWithCapacity:OFFTStompPOSIXMaximumReadBuffers];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark - Transport Methods
+
+- (void)open {
+    pthread_mutex_lock(&_lock);
+    if (_state != OFFTStompPOSIXStateClosed) {
+        pthread_mutex_unlock(&_lock);
+        return;
+    }
+    _state = OFFTStompPOSIXStateConnecting;
+    pthread_mutex_unlock(&_lock);
+
+    // The thread keeps the transport alive until the connection has closed
+    NSThread *thread = [[NSThread alloc] initWithTarget:self selector:@selector(runEventLoop) object:nil];
+    thread.name = @"OFFTStompPOSIXSocketTransport";
+    [thread start];
+}
+
+- (void)close {
+    pthread_mutex_lock(&_lock);
+    if (_state == OFFTStompPOSIXStateClosed || _state == OFFTStompPOSIXStateClosing) {
+        pthread_mutex_unlock(&_lock);
+        return;
+    }
+    _state = OFFTStompPOSIXStateClosing;
+
+    // Wake the event loop so it notices
+    if (_wakeWrite >= 0) {
+        uint8_t byte = 0;
+        (void)write(_wakeWrite, &byte, 1);
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)sendData:(NSData *)data {
+    [self sendDataParts:@[data]];
+}
+
+- (void)sendDataParts:(NSArray *)parts {
+    NSUInteger total = 0;
+    for (NSData *part in parts) {
+        total += part.length;
+    }
+
+    ssize_t written = 0;
+
+    pthread_mutex_lock(&_lock);
+    if (_state != OFFTStompPOSIXStateOpen) {
+        pthread_mutex_unlock(&_lock);
+        return;
+    }
+
+    // Write straight from the caller's buffers unless earlier data is still waiting
+    if (_pendingWrites.count == 0) {
+        written = [self writeParts:parts offset:0];
+        if (written < 0) {
+            // The event loop discovers the error when it next reads
+            written = 0;
+        }
+    }
+
+    if ((NSUInteger)written < total) {
+        [self queueParts:parts skippingLength:(NSUInteger)written];
+    }
+    pthread_mutex_unlock(&_lock);
+
+    if (written > 0) {
+        [self reportWrittenLength:(NSUInteger)written];
+    }
+}
+
+- (BOOL)reportsWrites {
+    return YES;
+}
+
+- (void)setDelegateQueue:(dispatch_queue_t)queue {
+    _delegateQueue = queue ?: dispatch_get_main_queue();
+}
+
+#pragma mark - Event Loop
+
+- (void)runEventLoop {
+    @autoreleasepool {
+        if ([self connectSocket]) {
+            [self processEvents];
+        }
+        [self closeSocket];
+    }
+}
+
+- (BOOL)connectSocket {
+    int wake[2];
+    int poller = OFFTStompPollerCreate();
+    if (poller < 0 || pipe(wake) != 0) {
+        if (poller >= 0) {
+            close(poller);
+        }
+        return NO;
+    }
+    fcntl(wake[0], F_SETFL, fcntl(wake[0], F_GETFL, 0) | O_NONBLOCK);
+    fcntl(wake[1], F_SETFL, fcntl(wake[1], F_GETFL, 0) | O_NONBLOCK);
+    OFFTStompPollerWatch(poller, wake[0], YES, NO);
+
+    pthread_mutex_lock(&_lock);
+    _poller = poller;
+    _wakeRead = wake[0];
+    _wakeWrite = wake[1];
+    pthread_mutex_unlock(&_lock);
+
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_protocol = IPPROTO_TCP };
+    char port[8];
+    snprintf(port, sizeof(port), "%u", self.port);
+
+    if (getaddrinfo(self.host.UTF8String, port, &hints, &_addresses) != 0 || _addresses == NULL) {
+        _addresses = NULL;
+        return NO;
+    }
+    _nextAddress = _addresses;
+
+    return [self connectToNextAddress];
+}
+
+/**
+ *  Starts connecting to each remaining address in turn,
+ *  until one has not failed immediately.
+ *
+ *  @return NO if every address has failed, or the transport is closing.
+ */
+- (BOOL)connectToNextAddress {
+    while (_nextAddress) {
+        struct addrinfo *address = _nextAddress;
+        _nextAddress = address->ai_next;
+
+        int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        [self configureSocket:fd];
+
+        int result = connect(fd, address->ai_addr, address->ai_addrlen);
+        if (result != 0 && errno != EINPROGRESS) {
+            close(fd);
+            continue;
+        }
+
+        pthread_mutex_lock(&_lock);
+        _fd = fd;
+        BOOL closing = (_state == OFFTStompPOSIXStateClosing);
+        pthread_mutex_unlock(&_lock);
+
+        if (closing) {
+            return NO;
+        }
+
+        // The connection has completed once the socket becomes writable
+        return OFFTStompPollerWatch(_poller, fd, YES, YES) == 0;
+    }
+    return NO;
+}
+
+- (void)configureSocket:(int)fd {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    int on = 1;
+    if (self.noDelay) {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+#ifdef SO_NOSIGPIPE
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    int receiveBufferSize = self.receiveBufferSize;
+    if (receiveBufferSize > 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize));
+    }
+    int sendBufferSize = self.sendBufferSize;
+    if (sendBufferSize > 0) {
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBufferSize, sizeof(sendBufferSize));
+    }
+}
+
+- (void)processEvents {
+    OFFTStompPollEvent events[OFFTStompPOSIXMaximumEvents];
+    const CFAbsoluteTime deadline = CFAbsoluteTimeGetCurrent() + self.connectionTimeout;
+
+    while (YES) {
+        const OFFTStompPOSIXState state = [self currentState];
+        if (state == OFFTStompPOSIXStateClosing) {
+            return;
+        }
+
+        int timeout = -1;
+        if (state == OFFTStompPOSIXStateConnecting && self.connectionTimeout > 0) {
+            CFAbsoluteTime remaining = deadline - CFAbsoluteTimeGetCurrent();
+            if (remaining <= 0) {
+                return;
+            }
+            timeout = (int)ceil(remaining * 1000);
+        }
+
+        int count = OFFTStompPollerWait(_poller, events, timeout);
+        if (count < 0 && errno != EINTR) {
+            return;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            @autoreleasepool {
+                if (events[i].fd == _wakeRead) {
+                    uint8_t drain[16];
+                    while (read(_wakeRead, drain, sizeof(drain)) > 0);
+                    continue;
+                }
+
+                if ([self currentState] == OFFTStompPOSIXStateConnecting) {
+                    if ([self finishConnecting] == NO) {
+                        return;
+                    }
+                    continue;
+                }
+
+                if (events[i].readable && [self readAvailableData] == NO) {
+                    return;
+                }
+                if (events[i].writable && [self writePendingData] == NO) {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+- (BOOL)finishConnecting {
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+        // Closing the socket also stops the poller watching it
+        pthread_mutex_lock(&_lock);
+        close(_fd);
+        _fd = -1;
+        pthread_mutex_unlock(&_lock);
+
+        return [self connectToNextAddress];
+    }
+
+    freeaddrinfo(_addresses);
+    _addresses = _nextAddress = NULL;
+
+    pthread_mutex_lock(&_lock);
+    if (_state == OFFTStompPOSIXStateClosing) {
+        pthread_mutex_unlock(&_lock);
+        return NO;
+    }
+    _state = OFFTStompPOSIXStateOpen;
+    _watchingWritable = NO;
+    OFFTStompPollerWatch(_poller, _fd, NO, NO);
+    pthread_mutex_unlock(&_lock);
+
+    dispatch_async(self.delegateQueue, ^{
+        [self.delegate transportDidOpen:self];
+    });
+    return YES;
+}
+
+/**
+ *  Reads everything available into the read buffer,
+ *  then delivers it to the delegate as a single slice.
+ *
+ *  @return NO if the connection has closed.
+ */
+- (BOOL)readAvailableData {
+    OFFTStompPOSIXReadBuffer *buffer = [self readBufferWithSpace];
+    const NSUInteger start = buffer->_length;
+    BOOL open = YES;
+
+    while (buffer->_length < buffer->_capacity) {
+        ssize_t count = read(_fd, buffer->_bytes + buffer->_length, buffer->_capacity - buffer->_length);
+        if (count > 0) {
+            buffer->_length += count;
+        } else if (count < 0 && errno == EINTR) {
+            continue;
+        } else {
+            // Nothing more to read, otherwise the peer closed the connection or an error occurred
+            open = (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+            break;
+        }
+    }
+
+    if (buffer->_length > start) {
+        NSData *data = [buffer sliceWithRange:NSMakeRange(start, buffer->_length - start)];
+
+        dispatch_async(self.delegateQueue, ^{
+            if ([self.delegate respondsToSelector:@selector(transport:didReceiveData:)]) {
+                [self.delegate transport:self didReceiveData:data];
+            } else {
+                [self.delegate transport:self didReceiveMessage:[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding]];
+            }
+        });
+    }
+    return open;
+}
+
+/**
+ *  Returns a buffer with room to read into.
+ *
+ *  Slices handed to the delegate must be contiguous, so rather than wrapping
+ *  around a single block of bytes, the buffers themselves form a ring. Once the
+ *  current buffer is full the next one that nothing references is rewound and
+ *  reused. A new buffer is only allocated while every buffer in the ring is still
+ *  referenced, taking the place of the full one, which is then freed along with
+ *  its last slice.
+ */
+- (OFFTStompPOSIXReadBuffer *)readBufferWithSpace {
+    const NSUInteger count = _readBuffers.count;
+
+    if (count > 0) {
+        OFFTStompPOSIXReadBuffer *buffer = _readBuffers[_readBufferIndex];
+        if (atomic_load(&buffer->_liveSlices) == 0) {
+            // Nothing references the buffer, so it can be reused from the start
+            buffer->_length = 0;
+            return buffer;
+        }
+        if (buffer->_capacity - buffer->_length >= OFFTStompPOSIXMinimumReadSpace) {
+            return buffer;
+        }
+
+        for (NSUInteger i = 1; i < count; ++i) {
+            NSUInteger index = (_readBufferIndex + i) % count;
+            OFFTStompPOSIXReadBuffer *next = _readBuffers[index];
+            if (atomic_load(&next->_liveSlices) == 0) {
+                next->_length = 0;
+                _readBufferIndex = index;
+                return next;
+            }
+        }
+    }
+
+    OFFTStompPOSIXReadBuffer *buffer = [[OFFTStompPOSIXReadBuffer alloc] initWithCapacity:MAX(self.readBufferSize, OFFTStompPOSIXMinimumReadSpace)];
+    if (count < OFFTStompPOSIXMaximumReadBuffers) {
+        _readBufferIndex = count;
+        [_readBuffers addObject:buffer];
+    } else {
+        _readBuffers[_readBufferIndex] = buffer;
+    }
+    return buffer;
+}
+
+/**
+ *  Writes as much of the pending data as the socket will accept.
+ *
+ *  @return NO if the connection has failed.
+ */
+- (BOOL)writePendingData {
+    ssize_t totalWritten = 0;
+    BOOL open = YES;
+
+    pthread_mutex_lock(&_lock);
+    while (_pendingWrites.count > 0) {
+        ssize_t count = [self writeParts:_pendingWrites offset:_pendingOffset];
+        if (count < 0) {
+            open = NO;
+            break;
+        }
+        if (count == 0) {
+            break;
+        }
+        totalWritten += count;
+        [self consumePendingLength:(NSUInteger)count];
+    }
+
+    if (_pendingWrites.count == 0 && _watchingWritable && _fd >= 0) {
+        _watchingWritable = NO;
+        OFFTStompPollerWatch(_poller, _fd, NO, NO);
+    }
+    pthread_mutex_unlock(&_lock);
+
+    if (totalWritten > 0) {
+        [self reportWrittenLength:(NSUInteger)totalWritten];
+    }
+    return open;
+}
+
+- (void)closeSocket {
+    // Give anything still waiting a final chance to be sent
+    if ([self currentState] == OFFTStompPOSIXStateClosing && _fd >= 0) {
+        [self writePendingData];
+    }
+
+    pthread_mutex_lock(&_lock);
+    if (_fd >= 0) {
+        close(_fd);
+    }
+    if (_poller >= 0) {
+        close(_poller);
+    }
+    if (_wakeRead >= 0) {
+        close(_wakeRead);
+    }
+    if (_wakeWrite >= 0) {
+        close(_wakeWrite);
+    }
+    _fd = _poller = _wakeRead = _wakeWrite = -1;
+    _state = OFFTStompPOSIXStateClosed;
+    [_pendingWrites removeAllObjects];
+    _pendingOffset = 0;
+    _watchingWritable = NO;
+    pthread_mutex_unlock(&_lock);
+
+    if (_addresses) {
+        freeaddrinfo(_addresses);
+        _addresses = _nextAddress = NULL;
+    }
+
+    // Delivered slices keep their bytes alive
+    [_readBuffers removeAllObjects];
+    _readBufferIndex = 0;
+
+    dispatch_async(self.delegateQueue, ^{
+        [self.delegate transportDidClose:self];
+    });
+}
+
+#pragma mark - Helpers
+
+- (OFFTStompPOSIXState)currentState {
+    pthread_mutex_lock(&_lock);
+    OFFTStompPOSIXState state = _state;
+    pthread_mutex_unlock(&_lock);
+    return state;
+}
+
+/**
+ *  Writes the parts with a single gathered write. Must be called with the lock held.
+ *
+ *  @param offset The number of bytes of the first part already written.
+ *
+ *  @return The number of bytes written, 0 if the socket is full or -1 on error.
+ */
+- (ssize_t)writeParts:(NSArray *)parts offset:(NSUInteger)offset {
+    struct iovec vectors[OFFTStompPOSIXMaximumIOVecs];
+    int count = 0;
+
+    for (NSData *part in parts) {
+        if (count == OFFTStompPOSIXMaximumIOVecs) {
+            break;
+        }
+        NSUInteger skip = (count == 0) ? offset : 0;
+        if (part.length > skip) {
+            vectors[count].iov_base = (void *)((const uint8_t *)part.bytes + skip);
+            vectors[count].iov_len = part.length - skip;
+            ++count;
+        }
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    struct msghdr message = { .msg_iov = vectors, .msg_iovlen = count };
+
+    while (YES) {
+        ssize_t written = sendmsg(_fd, &message, MSG_NOSIGNAL);
+        if (written >= 0) {
+            return written;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+}
+
+/**
+ *  Queues whatever could not be written immediately. Must be called with the lock held.
+ */
+- (void)queueParts:(NSArray *)parts skippingLength:(NSUInteger)skip {
+    for (NSUInteger i = 0; i < parts.count; ++i) {
+        NSData *part = parts[i];
+        if (skip >= part.length) {
+            skip -= part.length;
+            continue;
+        }
+
+        // Parts are never modified once sent, so are retained rather than copied
+        [_pendingWrites addObject:part];
+
+        // Something was written, so the queue was empty
+        if (skip > 0) {
+            _pendingOffset = skip;
+            skip = 0;
+        }
+    }
+
+    if (_watchingWritable == NO) {
+        _watchingWritable = YES;
+        OFFTStompPollerWatch(_poller, _fd, NO, YES);
+    }
+}
+
+/**
+ *  Removes written bytes from the front of the pending writes. Must be called with the lock held.
+ */
+- (void)consumePendingLength:(NSUInteger)length {
+    while (length > 0 && _pendingWrites.count > 0) {
+        NSData *first = _pendingWrites[0];
+        NSUInteger remaining = first.length - _pendingOffset;
+
+        if (length >= remaining) {
+            length -= remaining;
+            _pendingOffset = 0;
+            [_pendingWrites removeObjectAtIndex:0];
+        } else {
+            _pendingOffset += length;
+            length = 0;
+        }
+    }
+}
+
+- (void)reportWrittenLength:(NSUInteger)length {
+    dispatch_async(self.delegateQueue, ^{
+        if ([self.delegate respondsToSelector:@selector(transport:didWriteDataOfLength:)]) {
+            [self.delegate transport:self didWriteDataOfLength:length];
+        }
+    });
+}
+
+@end
@@ -0,0 +1,41 @@
+//
+//  OFFTStompSockJSFraming.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  Decodes the JSON array of strings carried by a SockJS "a" frame,
+ *  appending the UTF-8 bytes of every string to the output one after another.
+ *
+ *  Strings are unescaped straight into the output, so a batch of STOMP frames
+ *  can be handed to the frame decoder without creating a string for each.
+ *
+ *  @param bytes  The UTF-8 encoded array, excluding the leading "a".
+ *  @param length The length of the array in bytes.
+ *  @param output The data to append the decoded strings to.
+ *  @param count  On return, the number of strings decoded. May be NULL.
+ *
+ *  @return NO if the array is malformed, in which case the output may contain part of it.
+ */
+extern BOOL OFFTStompSockJSAppendDecodedArray(const uint8_t *bytes, NSUInteger length, NSMutableData *output, NSUInteger *count);
+
+/**
+ *  Appends UTF-8 bytes to the output as a quoted JSON string,
+ *  as sent in the array of messages of a SockJS send.
+ *
+ *  @param bytes  The UTF-8 bytes to encode.
+ *  @param length The number of bytes.
+ *  @param output The data to append the string to.
+ */
+extern void OFFTStompSockJSAppendEncodedString(const uint8_t *bytes, NSUInteger length, NSMutableData *output);
+
+/**
+ *  Whether the bytes are well-formed UTF-8, and so can be carried in a SockJS message.
+ *  Overlong encodings, surrogates and code points beyond U+10FFFF are rejected.
+ */
+extern BOOL OFFTStompSockJSIsValidUTF8(const uint8_t *bytes, NSUInteger length);
@@ -0,0 +1,288 @@
+//
+//  OFFTStompSockJSFraming.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompSockJSFraming.h"
+
+/**
+ *  The character following the backslash for each byte with a short JSON escape, or 0.
+ *  Other control characters are escaped as \u00XX.
+ */
+static const uint8_t OFFTStompJSONEscapeTable[256] = {
+    ['"']  = '"',
+    ['\\'] = '\\',
+    ['\b'] = 'b',
+    ['\f'] = 'f',
+    ['\n'] = 'n',
+    ['\r'] = 'r',
+    ['\t'] = 't',
+};
+
+static inline const uint8_t *OFFTStompSkipWhitespace(const uint8_t *p, const uint8_t *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        ++p;
+    }
+    return p;
+}
+
+static inline BOOL OFFTStompReadHex4(const uint8_t **p, const uint8_t *end, uint32_t *value) {
+    if (end - *p < 4) {
+        return NO;
+    }
+
+    uint32_t result = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint8_t c = (*p)[i];
+        result <<= 4;
+        if (c >= '0' && c <= '9') {
+            result |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            result |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            result |= c - 'A' + 10;
+        } else {
+            return NO;
+        }
+    }
+    *p += 4;
+    *value = result;
+    return YES;
+}
+
+static inline void OFFTStompAppendUTF8(uint32_t codePoint, NSMutableData *output) {
+    uint8_t bytes[4];
+    NSUInteger length;
+
+    if (codePoint < 0x80) {
+        bytes[0] = (uint8_t)codePoint;
+        length = 1;
+    } else if (codePoint < 0x800) {
+        bytes[0] = 0xC0 | (codePoint >> 6);
+        bytes[1] = 0x80 | (codePoint & 0x3F);
+        length = 2;
+    } else if (codePoint < 0x10000) {
+        bytes[0] = 0xE0 | (codePoint >> 12);
+        bytes[1] = 0x80 | ((codePoint >> 6) & 0x3F);
+        bytes[2] = 0x80 | (codePoint & 0x3F);
+        length = 3;
+    } else {
+        bytes[0] = 0xF0 | (codePoint >> 18);
+        bytes[1] = 0x80 | ((codePoint >> 12) & 0x3F);
+        bytes[2] = 0x80 | ((codePoint >> 6) & 0x3F);
+        bytes[3] = 0x80 | (codePoint & 0x3F);
+        length = 4;
+    }
+    [output appendBytes:bytes length:length];
+}
+
+/**
+ *  Decodes a \uXXXX escape, and the low surrogate following it where needed.
+ *  p points just past the "u".
+ */
+static BOOL OFFTStompAppendUnicodeEscape(const uint8_t **p, const uint8_t *end, NSMutableData *output) {
+    uint32_t codePoint;
+    if (OFFTStompReadHex4(p, end, &codePoint) == NO) {
+        return NO;
+    }
+
+    if (codePoint >= 0xD800 && codePoint < 0xDC00) {
+        uint32_t low;
+        if (end - *p < 2 || (*p)[0] != '\\' || (*p)[1] != 'u') {
+            return NO;
+        }
+        *p += 2;
+        if (OFFTStompReadHex4(p, end, &low) == NO || low < 0xDC00 || low >= 0xE000) {
+            return NO;
+        }
+        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+    } else if (codePoint >= 0xDC00 && codePoint < 0xE000) {
+        return NO;
+    }
+
+    OFFTStompAppendUTF8(codePoint, output);
+    return YES;
+}
+
+BOOL OFFTStompSockJSAppendDecodedArray(const uint8_t *bytes, NSUInteger length, NSMutableData *output, NSUInteger *count) {
+    const uint8_t *p = bytes;
+    const uint8_t *end = bytes + length;
+    NSUInteger strings = 0;
+
+    p = OFFTStompSkipWhitespace(p, end);
+    if (p == end || *p++ != '[') {
+        return NO;
+    }
+
+    p = OFFTStompSkipWhitespace(p, end);
+    if (p < end && *p == ']') {
+        ++p;
+    } else {
+        while (YES) {
+            p = OFFTStompSkipWhitespace(p, end);
+            if (p == end || *p++ != '"') {
+                return NO;
+            }
+
+            while (YES) {
+                // Copy runs of unescaped bytes in one go
+                const uint8_t *run = p;
+                while (p < end && *p != '"' && *p != '\\') {
+                    ++p;
+                }
+                if (p > run) {
+                    [output appendBytes:run length:p - run];
+                }
+
+                if (p == end) {
+                    return NO;
+                }
+                if (*p++ == '"') {
+                    break;
+                }
+
+                if (p == end) {
+                    return NO;
+                }
+
+                uint8_t escape = *p++;
+                uint8_t byte;
+                switch (escape) {
+                    case '"':  byte = '"';  break;
+                    case '\\': byte = '\\'; break;
+                    case '/':  byte = '/';  break;
+                    case 'b':  byte = '\b'; break;
+                    case 'f':  byte = '\f'; break;
+                    case 'n':  byte = '\n'; break;
+                    case 'r':  byte = '\r'; break;
+                    case 't':  byte = '\t'; break;
+                    case 'u':
+                        if (OFFTStompAppendUnicodeEscape(&p, end, output) == NO) {
+                            return NO;
+                        }
+                        continue;
+                    default:
+                        return NO;
+                }
+                [output appendBytes:&byte length:1];
+            }
+            ++strings;
+
+            p = OFFTStompSkipWhitespace(p, end);
+            if (p == end) {
+                return NO;
+            }
+            if (*p == ',') {
+                ++p;
+                continue;
+            }
+            if (*p++ == ']') {
+                break;
+            }
+            return NO;
+        }
+    }
+
+    // Nothing but whitespace may follow the array
+    if (OFFTStompSkipWhitespace(p, end) != end) {
+        return NO;
+    }
+
+    if (count) {
+        *count = strings;
+    }
+    return YES;
+}
+
+void OFFTStompSockJSAppendEncodedString(const uint8_t *bytes, NSUInteger length, NSMutableData *output) {
+    static const char hex[] = "0123456789abcdef";
+
+    const uint8_t *p = bytes;
+    const uint8_t *end = bytes + length;
+
+    [output appendBytes:"\"" length:1];
+
+    while (p < end) {
+        // Copy runs of bytes that need no escaping in one go
+        const uint8_t *run = p;
+        while (p < end && *p >= 0x20 && *p != '"' && *p != '\\') {
+            ++p;
+        }
+        if (p > run) {
+            [output appendBytes:run length:p - run];
+        }
+
+        if (p == end) {
+            break;
+        }
+
+        const uint8_t byte = *p++;
+        const uint8_t escape = OFFTStompJSONEscapeTable[byte];
+        if (escape) {
+            const uint8_t escaped[2] = { '\\', escape };
+            [output appendBytes:escaped length:sizeof(escaped)];
+        } else {
+            const uint8_t escaped[6] = { '\\', 'u', '0', '0', hex[byte >> 4], hex[byte & 0xF] };
+            [output appendBytes:escaped length:sizeof(escaped)];
+        }
+    }
+
+    [output appendBytes:"\"" length:1];
+}
+
+BOOL OFFTStompSockJSIsValidUTF8(const uint8_t *bytes, NSUInteger length) {
+    const uint8_t *p = bytes;
+    const uint8_t *end = bytes + length;
+
+    while (p < end) {
+        // ASCII needs no further checks
+        if (*p < 0x80) {
+            ++p;
+            continue;
+        }
+
+        NSUInteger count;
+        uint8_t lower = 0x80;
+        uint8_t upper = 0xBF;
+        if (*p >= 0xC2 && *p <= 0xDF) {
+            count = 1;
+        } else if (*p >= 0xE0 && *p <= 0xEF) {
+            count = 2;
+            if (*p == 0xE0) {
+                lower = 0xA0;
+            } else if (*p == 0xED) {
+                upper = 0x9F;
+            }
+        } else if (*p >= 0xF0 && *p <= 0xF4) {
+            count = 3;
+            if (*p == 0xF0) {
+                lower = 0x90;
+            } else if (*p == 0xF4) {
+                upper = 0x8F;
+            }
+        } else {
+            return NO;
+        }
+
+        if ((NSUInteger)(end - p) <= count) {
+            return NO;
+        }
+        ++p;
+
+        // Only the first continuation byte has a narrower range
+        if (*p < lower || *p > upper) {
+            return NO;
+        }
+        for (NSUInteger i = 1; i < count; ++i) {
+            if ((p[i] & 0xC0) != 0x80) {
+                return NO;
+            }
+        }
+        p += count;
+    }
+
+    return YES;
+}
@@ -0,0 +1,41 @@
+//
+//  OFFTStompSockJSTransport.h
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompTransportAdapter.h"
+
+extern NSString * const OFFTStompSockJSErrorDomain;
+
+typedef NS_ENUM(NSInteger, OFFTStompSockJSError) {
+    OFFTStompSockJSMalformedFrameError = 1,
+    OFFTStompSockJSInvalidUTF8Error = 2,
+};
+
+/**
+ *  A transport speaking SockJS framing over a WebSocket, as used by Spring's /ws endpoints.
+ *
+ *  Every STOMP frame in a SockJS message array is handed to the client in a single
+ *  chunk, and frames sent in the same queue turn are batched into a single SockJS send.
+ *
+ *  SockJS carries text, so message bodies must be valid UTF-8. Sending a frame
+ *  that is not fails the transport with OFFTStompSockJSInvalidUTF8Error.
+ */
+@interface OFFTStompSockJSTransport : NSObject <OFFTStompTransportAdapter>
+
+/**
+ *  @param URL The SockJS endpoint, e.g. http://localhost:8080/ws.
+ *             A new server and session ID are appended each time the transport is opened.
+ */
++ (OFFTStompSockJSTransport *)transportWithURL:(NSURL *)URL;
+
+/**
+ *  The class of WebSocket created each time the transport is opened.
+ *  Defaults to SRWebSocket, and may be set to a subclass, e.g. to fake a server in tests.
+ */
+@property (nonatomic, strong) Class socketClass;
+
+@end
@@ -0,0 +1,286 @@
+//
+//  OFFTStompSockJSTransport.m
+//  Stompy
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import "OFFTStompSockJSTransport.h"
+#import "OFFTStompSockJSFraming.h"
+#import "SRWebSocket.h"
+
+NSString * const OFFTStompSockJSErrorDomain = @"OFFTStompSockJSErrorDomain";
+
+// https://sockjs.github.io/sockjs-protocol/sockjs-protocol-0.3.3.html
+typedef NS_ENUM(uint8_t, OFFTSockJSFrameType) {
+    OFFTSockJSFrameTypeOpen = 'o',
+    OFFTSockJSFrameTypeHeartbeat = 'h',
+    OFFTSockJSFrameTypeArray = 'a',
+    OFFTSockJSFrameTypeClose = 'c',
+};
+
+@interface OFFTStompSockJSTransport () <SRWebSocketDelegate>
+
+- (instancetype)initWithURL:(NSURL *)URL NS_DESIGNATED_INITIALIZER;
+
+@property (nonatomic, strong) SRWebSocket *socket;
+
+@property (nonatomic, copy) NSURL *URL;
+
+/**
+ *  Applied to each socket as it is created, nil for the main run loop.
+ */
+@property (nonatomic, strong) dispatch_queue_t delegateQueue;
+
+/**
+ *  Whether the server has sent the SockJS open frame.
+ */
+@property (nonatomic, assign) BOOL sessionOpen;
+
+/**
+ *  The JSON array of frames waiting to be sent as one SockJS message.
+ */
+@property (nonatomic, strong) NSMutableData *pendingMessages;
+@property (nonatomic, assign) BOOL flushScheduled;
+
+@end
+
+@implementation OFFTStompSockJSTransport
+@synthesize delegate;
+
++ (OFFTStompSockJSTransport *)transportWithURL:(NSURL *)URL {
+    return [[self alloc] initWithURL:URL];
+}
+
+- (instancetype)initWithURL:(NSURL *)URL {
+    self = [super init];
+    if (self) {
+        _URL = [URL copy];
+        _socketClass = [SRWebSocket class];
+    }
+    return self;
+}
+
+#pragma mark - Lazy Instantiation
+
+- (SRWebSocket *)socket {
+    if (_socket == nil) {
+        _socket = [[self.socketClass alloc] initWithURL:[self webSocketURL]];
+        _socket.delegate = self;
+        if (self.delegateQueue) {
+            [_socket setDelegateDispatchQueue:self.delegateQueue];
+        }
+    }
+    return _socket;
+}
+
+- (NSMutableData *)pendingMessages {
+    if (_pendingMessages == nil) {
+        _pendingMessages = [[NSMutableData alloc] init];
+    }
+    return _pendingMessages;
+}
+
+#pragma mark - Transport Methods
+
+- (NSString *)host {
+    return self.URL.host;
+}
+
+- (void)open {
+    [self.socket open];
+}
+
+- (void)close {
+    [self flushPendingMessages];
+    [_socket close];
+}
+
+- (void)sendData:(NSData *)data {
+    // Rejected before it can spoil the rest of the batch
+    if (OFFTStompSockJSIsValidUTF8(data.bytes, data.length) == NO) {
+        NSError *error = [NSError errorWithDomain:OFFTStompSockJSErrorDomain
+                                             code:OFFTStompSockJSInvalidUTF8Error
+                                         userInfo:@{ NSLocalizedDescriptionKey : @"SockJS frames must be valid UTF-8" }];
+        [self failWithError:error];
+        [self close];
+        return;
+    }
+
+    // Frames sent in the same queue turn become elements of the same array
+    [self.pendingMessages appendBytes:(self.pendingMessages.length ? "," : "[") length:1];
+    OFFTStompSockJSAppendEncodedString(data.bytes, data.length, self.pendingMessages);
+
+    [self scheduleFlush];
+}
+
+- (void)setDelegateQueue:(dispatch_queue_t)queue {
+    _delegateQueue = queue;
+    [_socket setDelegateDispatchQueue:queue ?: dispatch_get_main_queue()];
+}
+
+#pragma mark - Helpers
+
+/**
+ *  The WebSocket URL for a new session, <endpoint>/<server>/<session>/websocket.
+ */
+- (NSURL *)webSocketURL {
+    NSURLComponents *components = [NSURLComponents componentsWithURL:self.URL resolvingAgainstBaseURL:NO];
+
+    BOOL secure = [components.scheme isEqualToString:@"https"] || [components.scheme isEqualToString:@"wss"];
+    components.scheme = secure ? @"wss" : @"ws";
+
+    NSString *path = components.path;
+    while ([path hasSuffix:@"/"]) {
+        path = [path substringToIndex:path.length - 1];
+    }
+
+    NSString *server = [NSString stringWithFormat:@"%03u", arc4random_uniform(1000)];
+    NSString *session = [[[NSUUID UUID] UUIDString] stringByReplacingOccurrencesOfString:@"-" withString:@""];
+    components.path = [NSString stringWithFormat:@"%@/%@/%@/websocket", path, server, session];
+
+    return components.URL;
+}
+
+- (void)scheduleFlush {
+    if (self.flushScheduled) {
+        return;
+    }
+    self.flushScheduled = YES;
+
+    __weak typeof(self) weakSelf = self;
+    dispatch_async(self.delegateQueue ?: dispatch_get_main_queue(), ^{
+        [weakSelf flushPendingMessages];
+    });
+}
+
+- (void)flushPendingMessages {
+    self.flushScheduled = NO;
+
+    if (_pendingMessages.length == 0) {
+        return;
+    }
+
+    // Every frame was validated as it was added
+    [_pendingMessages appendBytes:"]" length:1];
+    NSString *message = [[NSString alloc] initWithData:_pendingMessages encoding:NSUTF8StringEncoding];
+    _pendingMessages.length = 0;
+
+    if (self.sessionOpen) {
+        [self.socket send:message];
+    }
+}
+
+/**
+ *  Decodes the frames of an "a" message straight from its UTF-8 bytes.
+ */
+- (void)handleMessageArray:(NSData *)message {
+    const uint8_t *bytes = message.bytes;
+    const NSUInteger length = message.length;
+
+    // The frames' bytes are never larger than their escaped form
+    NSMutableData *data = [[NSMutableData alloc] initWithCapacity:length];
+    if (OFFTStompSockJSAppendDecodedArray(bytes + 1, length - 1, data, NULL) == NO) {
+        [self failWithReason:@"Malformed SockJS message array"];
+        return;
+    }
+
+    if (data.length == 0) {
+        return;
+    }
+
+    // The whole batch is decoded in one go
+    if ([self.delegate respondsToSelector:@selector(transport:didReceiveData:)]) {
+        [self.delegate transport:self didReceiveData:data];
+    } else {
+        [self.delegate transport:self didReceiveMessage:[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding]];
+    }
+}
+
+/**
+ *  Closes the socket, telling the delegate why once the server has sent something unexpected.
+ */
+- (void)failWithReason:(NSString *)reason {
+    NSError *error = [NSError errorWithDomain:OFFTStompSockJSErrorDomain
+                                         code:OFFTStompSockJSMalformedFrameError
+                                     userInfo:@{ NSLocalizedDescriptionKey : reason }];
+    [self failWithError:error];
+
+    [_socket closeWithCode:SRStatusCodeProtocolError reason:reason];
+}
+
+- (void)failWithError:(NSError *)error {
+    if ([self.delegate respondsToSelector:@selector(transport:didFailWithError:)]) {
+        [self.delegate transport:self didFailWithError:error];
+    }
+}
+
+- (void)handleSocketClosed:(SRWebSocket *)webSocket {
+    // Failures may be reported after the socket has closed
+    if (webSocket != _socket) {
+        return;
+    }
+
+    _socket = nil;
+    _pendingMessages.length = 0;
+    self.sessionOpen = NO;
+    [self.delegate transportDidClose:self];
+}
+
+#pragma mark - Socket Rocket Delegate
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket {
+    // The transport is open once the SockJS open frame arrives
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket
+ didCloseWithCode:(NSInteger)code
+           reason:(NSString *)reason
+         wasClean:(BOOL)wasClean {
+    [self handleSocketClosed:webSocket];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didFailWithError:(NSError *)error {
+    if (webSocket == _socket) {
+        [self failWithError:error];
+    }
+    [self handleSocketClosed:webSocket];
+}
+
+- (BOOL)webSocketShouldConvertTextFrameToString:(SRWebSocket *)webSocket {
+    // Frames are decoded from the received bytes
+    return NO;
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessage:(id)message {
+    NSData *data = [message isKindOfClass:[NSString class]] ? [message dataUsingEncoding:NSUTF8StringEncoding] : message;
+    if (data.length == 0) {
+        return;
+    }
+
+    switch (((const uint8_t *)data.bytes)[0]) {
+        case OFFTSockJSFrameTypeOpen:
+            self.sessionOpen = YES;
+            [self.delegate transportDidOpen:self];
+            break;
+
+        case OFFTSockJSFrameTypeHeartbeat:
+            break;
+
+        case OFFTSockJSFrameTypeArray:
+            [self handleMessageArray:data];
+            break;
+
+        case OFFTSockJSFrameTypeClose:
+            // The server is ending the session
+            [_socket close];
+            break;
+
+        default:
+            [self failWithReason:@"Unknown SockJS frame type"];
+            break;
+    }
+}
+
+@end
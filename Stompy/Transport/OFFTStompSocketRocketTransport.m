@@ -8,6 +8,7 @@
 
 #import "OFFTStompSocketRocketTransport.h"
 #import "SRWebSocket.h"
+#import "OFFTStompTimingWheel.h"
 
 typedef NS_ENUM(NSUInteger, OFFTSocketRocketErrorCode) {
     OFFTSocketRocketErrorCodeUpdgradeFailed = 2133,
@@ -21,6 +22,22 @@ typedef NS_ENUM(NSUInteger, OFFTSocketRocketErrorCode) {
 @property (nonatomic, strong) SRWebSocket *socket;
 
 @property (nonatomic, copy) NSURLRequest *urlRequest;
+
+/**
+ *  Applied to each socket as it is created, nil for the main run loop.
+ */
+@property (nonatomic, strong) dispatch_queue_t delegateQueue;
+
+/**
+ *  Bytes handed to the socket that have not yet been reported as written.
+ */
+@property (nonatomic, assign) NSUInteger unreportedLength;
+
+/**
+ *  Polls the socket's output buffer, only while there are unreported bytes.
+ *  SocketRocket has no write completion to report writes from.
+ */
+@property (nonatomic, strong) OFFTStompWheelTimer *writePollTimer;
 @end
 
 @implementation OFFTStompSocketRocketTransport
@@ -55,6 +72,9 @@ typedef NS_ENUM(NSUInteger, OFFTSocketRocketErrorCode) {
     if (_socket == nil) {
         _socket = [[SRWebSocket alloc] initWithURLRequest:self.urlRequest];
         _socket.delegate = self;
+        if (self.delegateQueue) {
+            [_socket setDelegateDispatchQueue:self.delegateQueue];
+        }
     }
     return _socket;
 }
@@ -75,12 +95,73 @@ typedef NS_ENUM(NSUInteger, OFFTSocketRocketErrorCode) {
 
 - (void)sendData:(NSData *)data {
     [self.socket send:data];
+    
+    self.unreportedLength += data.length;
+    [self startPollingWrites];
+}
+
+- (BOOL)reportsWrites {
+    return YES;
+}
+
+- (void)setDelegateQueue:(dispatch_queue_t)queue {
+    _delegateQueue = queue;
+    [_socket setDelegateDispatchQueue:queue ?: dispatch_get_main_queue()];
 }
 
 #pragma mark - Helpers
 
+- (void)startPollingWrites {
+    if (self.writePollTimer) {
+        return;
+    }
+    
+    // Every tick of the shared wheel, writes are reported at most 100ms late
+    __weak typeof(self) weakSelf = self;
+    self.writePollTimer = [[OFFTStompTimingWheel sharedWheel] scheduleTimerWithInterval:0 queue:self.delegateQueue handler:^{
+        [weakSelf pollWrites];
+    }];
+}
+
+- (void)stopPollingWrites {
+    [self.writePollTimer cancel];
+    self.writePollTimer = nil;
+}
+
+/**
+ *  Reports whatever has left the socket's output buffer since the last poll.
+ *  The buffer also holds WebSocket framing, so writes are reported slightly
+ *  late until it empties, never early.
+ */
+- (void)pollWrites {
+    if (_socket == nil || self.unreportedLength == 0) {
+        [self stopPollingWrites];
+        return;
+    }
+    
+    const NSUInteger buffered = _socket.bufferedAmount;
+    if (buffered >= self.unreportedLength) {
+        return;
+    }
+    
+    const NSUInteger written = self.unreportedLength - buffered;
+    self.unreportedLength = buffered;
+    if (self.unreportedLength == 0) {
+        [self stopPollingWrites];
+    }
+    
+    if ([self.delegate respondsToSelector:@selector(transport:didWriteDataOfLength:)]) {
+        [self.delegate transport:self didWriteDataOfLength:written];
+    }
+}
+
 - (void)handleSocketClosed {
     _socket = nil;
+    
+    // The client forgets unwritten data along with the connection
+    [self stopPollingWrites];
+    self.unreportedLength = 0;
+    
     [self.delegate transportDidClose:self];
 }
 
@@ -111,7 +192,15 @@ typedef NS_ENUM(NSUInteger, OFFTSocketRocketErrorCode) {
 }
 
 - (void)webSocket:(SRWebSocket *)webSocket didReceiveMessage:(id)message {
-    [self.delegate transport:self didReceiveMessage:message];
+    
+    // Binary messages are passed on untouched, text messages must be encoded
+    if ([self.delegate respondsToSelector:@selector(transport:didReceiveData:)]) {
+        NSData *data = [message isKindOfClass:[NSData class]] ? message : [message dataUsingEncoding:NSUTF8StringEncoding];
+        [self.delegate transport:self didReceiveData:data];
+    } else {
+        NSString *string = [message isKindOfClass:[NSString class]] ? message : [[NSString alloc] initWithData:message encoding:NSUTF8StringEncoding];
+        [self.delegate transport:self didReceiveMessage:string];
+    }
 }
 
 - (void)webSocket:(SRWebSocket *)webSocket didReceivePong:(NSData *)pongPayload {
@@ -17,6 +17,40 @@
 
 - (void)transport:(id<OFFTStompTransportAdapter>)transport didReceiveMessage:(NSString *)message;
 
+@optional
+
+/**
+ *  Bytes have been received by the transport.
+ *
+ *  Transports should prefer this method when the delegate implements it,
+ *  as the bytes are decoded without first being converted to a string
+ *  and may carry binary bodies containing NULL bytes.
+ *
+ *  The received bytes may be referenced by the delegate for as long as
+ *  it needs them, so they must not be modified afterwards.
+ *
+ *  @param transport The transport.
+ *  @param data      The received bytes, which may contain part of a frame or several frames.
+ */
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didReceiveData:(NSData *)data;
+
+/**
+ *  Data previously sent over the transport has been written.
+ *  Only called by transports that report their writes.
+ *
+ *  @param transport The transport.
+ *  @param length    The number of bytes written.
+ */
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didWriteDataOfLength:(NSUInteger)length;
+
+/**
+ *  The transport is closing because of an error. Followed by transportDidClose:.
+ *
+ *  @param transport The transport.
+ *  @param error     What went wrong, e.g. the connection failed or the server's framing was malformed.
+ */
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didFailWithError:(NSError *)error;
+
 @end
 
 @protocol OFFTStompTransportAdapter <NSObject>
@@ -28,6 +62,43 @@
 - (void)open;
 - (void)close;
 
+/**
+ *  Sends data over the transport.
+ *
+ *  The data is handed over to the transport, and is never modified by the
+ *  caller afterwards, so transports that send asynchronously may retain it
+ *  rather than copying it.
+ *
+ *  @param data The data to send.
+ */
 - (void)sendData:(NSData *)data;
 
+@optional
+
+/**
+ *  Sends several pieces of data over the transport as though they were contiguous.
+ *
+ *  Used for frames with large bodies, so the body can be sent without first being
+ *  copied alongside the headers. Transports able to gather the parts into a single
+ *  write should do so.
+ *
+ *  As with sendData:, the parts are never modified afterwards and may be retained.
+ *
+ *  @param parts An array of NSData objects to be sent in order.
+ */
+- (void)sendDataParts:(NSArray *)parts;
+
+/**
+ *  Sets the queue on which the delegate is called. Defaults to the main queue.
+ *
+ *  @param queue A serial queue.
+ */
+- (void)setDelegateQueue:(dispatch_queue_t)queue;
+
+/**
+ *  Whether the transport calls transport:didWriteDataOfLength: as data is written,
+ *  allowing the client to track how much data is waiting to be sent.
+ */
+- (BOOL)reportsWrites;
+
 @end
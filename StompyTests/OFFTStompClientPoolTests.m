@@ -0,0 +1,160 @@
+//
+//  OFFTStompClientPoolTests.m
+//  StompyTests
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "OFFTStompClientPool.h"
+#import "OFFTStompLoopbackTransport.h"
+
+static const NSUInteger OFFTStompTestConnectionCount = 4;
+
+@interface OFFTStompClientPoolTests : XCTestCase <OFFTStompClientDelegate>
+
+@property (nonatomic, strong) OFFTStompLoopbackBroker *broker;
+@property (nonatomic, strong) OFFTStompClientPool *pool;
+
+@property (nonatomic, strong) XCTestExpectation *connectionExpectation;
+@property (nonatomic, assign) NSUInteger connectedCount;
+
+@property (nonatomic, strong) XCTestExpectation *messagesExpectation;
+@property (nonatomic, assign) NSUInteger expectedMessageCount;
+@property (nonatomic, strong) NSMutableSet *receivingClients;
+@property (nonatomic, strong) NSMutableArray *destinations;
+@property (nonatomic, strong) NSMutableDictionary *bodiesByDestination;
+
+@end
+
+@implementation OFFTStompClientPoolTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.receivingClients = [NSMutableSet set];
+    self.destinations = [NSMutableArray array];
+    self.bodiesByDestination = [NSMutableDictionary dictionary];
+    self.broker = [[OFFTStompLoopbackBroker alloc] init];
+
+    OFFTStompLoopbackBroker *broker = self.broker;
+    self.pool = [OFFTStompClientPool poolWithConnectionCount:OFFTStompTestConnectionCount
+                                            transportFactory:^id<OFFTStompTransportAdapter>(NSUInteger index) {
+                                                return [OFFTStompLoopbackTransport transportWithBroker:broker];
+                                            }];
+    self.pool.delegate = self;
+    self.pool.delegateQueue = dispatch_get_main_queue();
+}
+
+- (void)testMessagesAreSpreadAcrossConnections {
+    [self connect];
+
+    NSUInteger count = 32;
+    for (NSUInteger i = 0; i < count; ++i) {
+        [self.pool subscribe:[NSString stringWithFormat:@"/topic/%lu", (unsigned long)i]];
+    }
+
+    self.expectedMessageCount = count;
+    self.messagesExpectation = [self expectationWithDescription:@"Messages"];
+    for (NSUInteger i = 0; i < count; ++i) {
+        [self.pool sendMessage:@"hello" toDestination:[NSString stringWithFormat:@"/topic/%lu", (unsigned long)i]];
+    }
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertGreaterThan(self.receivingClients.count, 1);
+}
+
+- (void)testRoundRobinRoutingKeepsDestinationsOnOneConnection {
+    self.pool.publishRouting = OFFTStompClientPoolRoutingRoundRobin;
+
+    NSMutableSet *clients = [NSMutableSet set];
+    for (NSUInteger i = 0; i < OFFTStompTestConnectionCount; ++i) {
+        [clients addObject:[self.pool clientForDestination:[NSString stringWithFormat:@"/queue/%lu", (unsigned long)i]]];
+    }
+
+    XCTAssertEqual(clients.count, OFFTStompTestConnectionCount);
+    XCTAssertEqual([self.pool clientForDestination:@"/queue/1"], [self.pool clientForDestination:@"/queue/1"]);
+}
+
+- (void)testRoundRobinRoutingKeepsMessagesInOrder {
+    self.pool.publishRouting = OFFTStompClientPoolRoutingRoundRobin;
+    self.pool.roundRobinDestinationLimit = 8;
+
+    // Past the limit destinations are hashed, and still always use the same connection
+    NSUInteger destinationCount = 32;
+    XCTestExpectation *subscriptionsExpectation = [self expectationWithDescription:@"Subscriptions"];
+    __block NSUInteger subscriptions = 0;
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if ([command isEqualToString:@"SUBSCRIBE"] && ++subscriptions == destinationCount) {
+            [subscriptionsExpectation fulfill];
+        }
+        return NO;
+    };
+
+    [self connect];
+    for (NSUInteger i = 0; i < destinationCount; ++i) {
+        [self.pool subscribe:[NSString stringWithFormat:@"/queue/%lu", (unsigned long)i]];
+    }
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    // Sends to every destination are interleaved
+    NSUInteger messageCount = 50;
+    self.expectedMessageCount = destinationCount * messageCount;
+    self.messagesExpectation = [self expectationWithDescription:@"Messages"];
+    for (NSUInteger i = 0; i < messageCount; ++i) {
+        for (NSUInteger j = 0; j < destinationCount; ++j) {
+            NSString *destination = [NSString stringWithFormat:@"/queue/%lu", (unsigned long)j];
+            [self.pool sendMessage:[NSString stringWithFormat:@"%lu", (unsigned long)i] toDestination:destination];
+        }
+    }
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    XCTAssertEqual(self.bodiesByDestination.count, destinationCount);
+    for (NSArray *bodies in self.bodiesByDestination.allValues) {
+        XCTAssertEqual(bodies.count, messageCount);
+        for (NSUInteger i = 0; i < bodies.count; ++i) {
+            XCTAssertEqualObjects(bodies[i], ([NSString stringWithFormat:@"%lu", (unsigned long)i]));
+        }
+    }
+}
+
+#pragma mark - Helpers
+
+- (void)connect {
+    self.connectionExpectation = [self expectationWithDescription:@"Connection"];
+    [self.pool connect];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+#pragma mark - Stomp Client Delegate
+
+- (void)stompClientDidConnect:(OFFTStompClient *)stompClient {
+    if (++self.connectedCount == OFFTStompTestConnectionCount) {
+        [self.connectionExpectation fulfill];
+    }
+}
+
+- (void)stompClient:(OFFTStompClient *)stompClient didDisconnectWithError:(NSError *)error {
+}
+
+- (void)stompClient:(OFFTStompClient *)stompClient
+receivedMessageData:(NSData *)messageData
+     withHeaderView:(OFFTStompHeaderView *)headerView {
+
+    [self.receivingClients addObject:stompClient];
+    [self.destinations addObject:headerView[@"destination"]];
+
+    NSMutableArray *bodies = self.bodiesByDestination[headerView[@"destination"]];
+    if (bodies == nil) {
+        bodies = [NSMutableArray array];
+        self.bodiesByDestination[headerView[@"destination"]] = bodies;
+    }
+    [bodies addObject:[[NSString alloc] initWithData:messageData encoding:NSUTF8StringEncoding]];
+    if (self.destinations.count == self.expectedMessageCount) {
+        [self.messagesExpectation fulfill];
+    }
+}
+
+@end
@@ -0,0 +1,282 @@
+//
+//  OFFTStompFrameDecoderTests.m
+//  StompyTests
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "OFFTStompFrame.h"
+#import "OFFTStompFrameDecoder.h"
+#import "OFFTStompFrameSerializer.h"
+#import "OFFTStompHeaderView.h"
+
+@interface OFFTStompFrameDecoderTests : XCTestCase <OFFTStompFrameDecoderDelegate>
+
+@property (nonatomic, strong) OFFTStompFrameDecoder *decoder;
+
+@property (nonatomic, strong) NSMutableArray *frames;
+
+@end
+
+@implementation OFFTStompFrameDecoderTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.frames = [NSMutableArray array];
+    self.decoder = [[OFFTStompFrameDecoder alloc] init];
+    self.decoder.delegate = self;
+}
+
+- (void)testSingleFrame {
+    [self.decoder appendData:[self dataWithString:@"MESSAGE\ndestination:/topic/a\n\nhello\0"]];
+
+    XCTAssertEqual(self.frames.count, 1);
+
+    OFFTStompFrame *frame = self.frames.firstObject;
+    XCTAssertEqual(frame.command, OFFTStompFrameCommandMessage);
+    XCTAssertEqualObjects([frame valueForHeader:@"destination"], @"/topic/a");
+    XCTAssertEqualObjects(frame.body, [self dataWithString:@"hello"]);
+}
+
+- (void)testMultipleFramesInOneChunk {
+    [self.decoder appendData:[self dataWithString:@"MESSAGE\ndestination:/a\n\none\0\n"
+                                                  @"MESSAGE\r\ndestination:/b\r\n\r\ntwo\0"
+                                                  @"RECEIPT\nreceipt-id:1\n\n\0"]];
+
+    XCTAssertEqual(self.frames.count, 3);
+    XCTAssertEqualObjects([self.frames[0] body], [self dataWithString:@"one"]);
+    XCTAssertEqualObjects([self.frames[1] valueForHeader:@"destination"], @"/b");
+    XCTAssertEqualObjects([self.frames[1] body], [self dataWithString:@"two"]);
+    XCTAssertEqual([self.frames[2] command], OFFTStompFrameCommandReceipt);
+}
+
+- (void)testFrameSplitAcrossChunks {
+    NSData *data = [self dataWithString:@"MESSAGE\ndestination:/a\ncontent-length:5\n\nhello\0MESSAGE\n\nx\0"];
+
+    // Feed a byte at a time
+    for (NSUInteger i = 0; i < data.length; ++i) {
+        [self.decoder appendData:[data subdataWithRange:NSMakeRange(i, 1)]];
+    }
+
+    XCTAssertEqual(self.frames.count, 2);
+    XCTAssertEqualObjects([self.frames[0] body], [self dataWithString:@"hello"]);
+    XCTAssertEqualObjects([self.frames[1] body], [self dataWithString:@"x"]);
+}
+
+- (void)testContentLengthAllowsNullBytesInBody {
+    const char frame[] = "MESSAGE\ncontent-length:3\n\na\0b\0";
+    [self.decoder appendData:[NSData dataWithBytes:frame length:sizeof(frame) - 1]];
+
+    XCTAssertEqual(self.frames.count, 1);
+
+    const char body[] = { 'a', '\0', 'b' };
+    XCTAssertEqualObjects([self.frames[0] body], [NSData dataWithBytes:body length:sizeof(body)]);
+}
+
+- (void)testWrongContentLengthFallsBackToNullByte {
+    [self.decoder appendData:[self dataWithString:@"MESSAGE\ncontent-length:3\n\nhello\0"
+                                                  @"MESSAGE\ncontent-length:1\n\n\0"
+                                                  @"MESSAGE\n\nnext\0"]];
+
+    XCTAssertEqual(self.frames.count, 3);
+    XCTAssertEqualObjects([self.frames[0] body], [self dataWithString:@"hello"]);
+    XCTAssertEqual([self.frames[1] body].length, 0);
+    XCTAssertEqualObjects([self.frames[2] body], [self dataWithString:@"next"]);
+}
+
+- (void)testBodyReferencesReceivedBytes {
+    NSData *chunk = [self dataWithString:@"MESSAGE\n\nhello\0"];
+    [self.decoder appendData:chunk];
+
+    NSData *body = [self.frames[0] body];
+    XCTAssertEqual((const uint8_t *)body.bytes, (const uint8_t *)chunk.bytes + 9);
+}
+
+- (void)testHeaderViewReferencesOnlyHeaderBlockOfPendingBytes {
+    NSString *headers = @"MESSAGE\ndestination:/a\ncontent-length:1024\n\n";
+    NSMutableData *data = [[self dataWithString:headers] mutableCopy];
+    [data increaseLengthBy:1024];
+    [data appendBytes:"\0" length:1];
+
+    // Split the frame so it is decoded from the decoder's pending buffer
+    [self.decoder appendData:[data subdataWithRange:NSMakeRange(0, 20)]];
+    [self.decoder appendData:[data subdataWithRange:NSMakeRange(20, data.length - 20)]];
+    XCTAssertEqual(self.frames.count, 1);
+
+    OFFTStompFrame *frame = self.frames[0];
+    NSData *headerData = frame.rawHeaderData;
+    XCTAssertEqual(headerData.length, headers.length);
+    XCTAssertFalse([headerData isKindOfClass:[NSMutableData class]]);
+
+    // Headers and body are slices of the same received bytes
+    XCTAssertEqual((const uint8_t *)frame.body.bytes, (const uint8_t *)headerData.bytes + headers.length);
+
+    OFFTStompHeaderView *view = [[OFFTStompHeaderView alloc] initWithFrame:frame];
+    [self.decoder appendData:[self dataWithString:@"MESSAGE\ndestination:/b\n\n\0"]];
+    XCTAssertEqualObjects([view valueForHeader:@"destination"], @"/a");
+    XCTAssertEqualObjects([view valueForHeader:@"content-length"], @"1024");
+}
+
+- (void)testRepeatedHeadersKeepFirstValue {
+    [self.decoder appendData:[self dataWithString:@"MESSAGE\nfoo:1\nfoo:2\n\n\0"]];
+
+    XCTAssertEqualObjects([self.frames[0] valueForHeader:@"foo"], @"1");
+}
+
+- (void)testEscapedHeadersAreDecoded {
+    self.decoder.version = OFFTStompVersion1_2;
+    [self.decoder appendData:[self dataWithString:@"MESSAGE\nfoo:a\\cb\\nc\\\\d\\re\n\n\0"]];
+
+    XCTAssertEqualObjects([self.frames[0] valueForHeader:@"foo"], @"a:b\nc\\d\re");
+}
+
+- (void)testConnectedHeadersAreNotDecoded {
+    self.decoder.version = OFFTStompVersion1_2;
+    [self.decoder appendData:[self dataWithString:@"CONNECTED\nfoo:a\\cb\n\n\0"]];
+
+    XCTAssertEqualObjects([self.frames[0] valueForHeader:@"foo"], @"a\\cb");
+}
+
+- (void)testReceivedHeadersCanBeModified {
+    self.decoder.version = OFFTStompVersion1_2;
+    [self.decoder appendData:[self dataWithString:@"MESSAGE\nfoo:a\\cb\ndestination:/a\nfoo:c\n\n\0"]];
+
+    OFFTStompFrame *frame = self.frames[0];
+    [frame setHeader:@"destination" value:@"/b"];
+
+    XCTAssertEqual(frame.headerCount, 3);
+    XCTAssertEqualObjects([frame valueForHeader:@"foo"], @"a:b");
+    XCTAssertEqualObjects([frame valueForHeaderName:OFFTStompHeaderNameDestination], @"/b");
+    XCTAssertEqualObjects(frame.allHeaders, (@{ @"foo" : @"a:b", @"destination" : @"/b" }));
+}
+
+- (void)testSerializerEscapesHeadersForVersion1_2 {
+    OFFTStompFrameSerializer *serializer = [[OFFTStompFrameSerializer alloc] init];
+    serializer.version = OFFTStompVersion1_2;
+
+    OFFTStompFrame *frame = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandSend];
+    [frame setHeader:@"a:b" value:@"c:d\ne\\f\rg"];
+    NSData *data = [serializer serializeFrame:frame];
+
+    XCTAssertEqualObjects(data, [self dataWithString:@"SEND\r\na\\cb:c\\cd\\ne\\\\f\\rg\r\n\r\n\0"]);
+
+    self.decoder.version = OFFTStompVersion1_2;
+    [self.decoder appendData:data];
+    XCTAssertEqualObjects([self.frames[0] valueForHeader:@"a:b"], @"c:d\ne\\f\rg");
+}
+
+- (void)testSerializerLeavesCarriageReturnsForVersion1_1 {
+    OFFTStompFrameSerializer *serializer = [[OFFTStompFrameSerializer alloc] init];
+    serializer.version = OFFTStompVersion1_1;
+
+    OFFTStompFrame *frame = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandSend];
+    [frame setHeader:@"a:b" value:@"c:d\ne\\f\rg"];
+    NSData *data = [serializer serializeFrame:frame];
+
+    XCTAssertEqualObjects(data, [self dataWithString:@"SEND\na\\cb:c\\cd\\ne\\\\f\rg\n\n\0"]);
+
+    self.decoder.version = OFFTStompVersion1_1;
+    [self.decoder appendData:data];
+    XCTAssertEqualObjects([self.frames[0] valueForHeader:@"a:b"], @"c:d\ne\\f\rg");
+}
+
+- (void)testSerializerLeavesConnectionFramesUnescaped {
+    OFFTStompFrameSerializer *serializer = [[OFFTStompFrameSerializer alloc] init];
+    serializer.version = OFFTStompVersion1_2;
+
+    OFFTStompFrame *connect = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandConnect];
+    [connect setHeader:@"login" value:@"a:b\\c"];
+    XCTAssertEqualObjects([serializer serializeFrame:connect], [self dataWithString:@"CONNECT\r\nlogin:a:b\\c\r\n\r\n\0"]);
+
+    OFFTStompFrame *connected = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandConnected];
+    [connected setHeader:@"server" value:@"broker/1.0:\\x"];
+    NSData *data = [serializer serializeFrame:connected];
+    XCTAssertEqualObjects(data, [self dataWithString:@"CONNECTED\r\nserver:broker/1.0:\\x\r\n\r\n\0"]);
+
+    self.decoder.version = OFFTStompVersion1_2;
+    [self.decoder appendData:data];
+    XCTAssertEqualObjects([self.frames[0] valueForHeader:@"server"], @"broker/1.0:\\x");
+}
+
+- (void)testSerializedFramesStayValidOnceHandedOver {
+    OFFTStompFrameSerializer *serializer = [[OFFTStompFrameSerializer alloc] init];
+    serializer.version = OFFTStompVersion1_1;
+
+    OFFTStompFrame *frame = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandSend];
+    [frame setHeader:@"destination" value:@"/a"];
+    NSData *first = [serializer serializeFrame:frame];
+
+    // Serializing more frames than there are reusable buffers never overwrites one still referenced
+    for (NSUInteger i = 0; i < 10; ++i) {
+        [frame setHeader:@"destination" value:@"/longer/destination"];
+        [serializer serializeFrame:frame];
+    }
+
+    XCTAssertEqualObjects(first, [self dataWithString:@"SEND\ndestination:/a\n\n\0"]);
+}
+
+- (void)testSerializedPartsMatchContiguousFrame {
+    OFFTStompFrameSerializer *serializer = [[OFFTStompFrameSerializer alloc] init];
+    serializer.version = OFFTStompVersion1_2;
+
+    NSMutableData *body = [NSMutableData dataWithLength:100 * 1024];
+    uint8_t *bytes = body.mutableBytes;
+    for (NSUInteger i = 0; i < body.length; ++i) {
+        bytes[i] = (uint8_t)(i * 31);
+    }
+
+    OFFTStompFrame *frame = [[OFFTStompFrame alloc] initWithCommand:OFFTStompFrameCommandSend];
+    [frame setHeader:@"destination" value:@"/a:b"];
+    [frame setBody:body];
+
+    NSArray *parts = [serializer serializeFrameParts:frame];
+    NSMutableData *joined = [NSMutableData data];
+    for (NSData *part in parts) {
+        [joined appendData:part];
+    }
+
+    XCTAssertEqual(parts.count, 3);
+    XCTAssertEqualObjects(joined, [serializer serializeFrame:frame]);
+
+    // The body is sent as it is, never copied
+    XCTAssertEqual([parts[1] bytes], frame.body.bytes);
+
+    self.decoder.version = OFFTStompVersion1_2;
+    [self.decoder appendData:joined];
+    XCTAssertEqual(self.frames.count, 1);
+    XCTAssertEqualObjects([self.frames[0] valueForHeader:@"destination"], @"/a:b");
+    XCTAssertEqualObjects([self.frames[0] body], body);
+}
+
+- (void)testHeaderView {
+    self.decoder.version = OFFTStompVersion1_2;
+    [self.decoder appendData:[self dataWithString:@"MESSAGE\ndestination:/a\nfoo:x\\cy\nfoo:z\n\n\0"]];
+
+    OFFTStompHeaderView *view = [[OFFTStompHeaderView alloc] initWithFrame:self.frames[0]];
+
+    XCTAssertEqual(view.count, 3);
+    XCTAssertTrue([view hasHeader:@"destination" equalToBytes:"/a" length:2]);
+    XCTAssertFalse([view hasHeader:@"destination" equalToBytes:"/b" length:2]);
+    XCTAssertTrue([view hasHeader:@"foo" equalToString:@"x:y"]);
+    XCTAssertFalse([view hasHeader:@"bar"]);
+    XCTAssertEqualObjects(view[@"foo"], @"x:y");
+    XCTAssertEqualObjects(view.dictionary, (@{ @"destination" : @"/a", @"foo" : @"x:y" }));
+}
+
+#pragma mark - Helpers
+
+- (NSData *)dataWithString:(NSString *)string {
+    return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+#pragma mark - Frame Decoder Delegate
+
+- (void)frameDecoder:(OFFTStompFrameDecoder *)decoder didDecodeFrame:(OFFTStompFrame *)frame {
+    [self.frames addObject:frame];
+}
+
+@end
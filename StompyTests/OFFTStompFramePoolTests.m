@@ -0,0 +1,93 @@
+//
+//  OFFTStompFramePoolTests.m
+//  StompyTests
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "OFFTStompFramePool.h"
+#import "OFFTStompFrameDecoder.h"
+
+@interface OFFTStompFramePoolTests : XCTestCase <OFFTStompFrameDecoderDelegate>
+
+@property (nonatomic, strong) OFFTStompFramePool *pool;
+
+@property (nonatomic, strong) NSMutableArray *frames;
+
+@end
+
+@implementation OFFTStompFramePoolTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.pool = [[OFFTStompFramePool alloc] init];
+    self.frames = [NSMutableArray array];
+}
+
+- (void)testRecycledFrameComesBackEmpty {
+    OFFTStompFrame *frame = [self.pool frameWithCommand:OFFTStompFrameCommandSend];
+    [frame setHeader:@"destination" value:@"/topic/a"];
+    [frame setBody:[@"hello" dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.pool recycleFrame:frame];
+
+    OFFTStompFrame *reused = [self.pool frameWithCommand:OFFTStompFrameCommandSubscribe];
+    XCTAssertEqual(reused, frame);
+    XCTAssertEqual(reused.command, OFFTStompFrameCommandSubscribe);
+    XCTAssertEqual(reused.headerCount, 0);
+    XCTAssertNil([reused valueForHeader:@"destination"]);
+    XCTAssertEqual(reused.allHeaders.count, 0);
+    XCTAssertNil(reused.body);
+    XCTAssertFalse(reused.mayHaveBody);
+
+    XCTAssertEqual(self.pool.misses, 1);
+    XCTAssertEqual(self.pool.hits, 1);
+}
+
+- (void)testRecycledReceivedFrameComesBackEmpty {
+    OFFTStompFrameDecoder *decoder = [[OFFTStompFrameDecoder alloc] init];
+    decoder.delegate = self;
+    decoder.framePool = self.pool;
+    [decoder appendData:[@"MESSAGE\ndestination:/topic/a\nmessage-id:1\n\nhello\0" dataUsingEncoding:NSUTF8StringEncoding]];
+
+    OFFTStompFrame *frame = self.frames.firstObject;
+    XCTAssertEqual(frame.headerCount, 2);
+    [self.frames removeAllObjects];
+    [self.pool recycleFrame:frame];
+
+    // No longer refers to the received bytes, and headers set afterwards are its only ones
+    OFFTStompFrame *reused = [self.pool frameWithCommand:OFFTStompFrameCommandSend];
+    XCTAssertEqual(reused, frame);
+    XCTAssertEqual(reused.headerCount, 0);
+    XCTAssertNil(reused.body);
+    XCTAssertEqual(reused.rawHeaderData.length, 0);
+
+    [reused setHeader:@"destination" value:@"/topic/b"];
+    XCTAssertEqualObjects(reused.allHeaders, @{ @"destination" : @"/topic/b" });
+}
+
+- (void)testCapacityLimitsPooledFrames {
+    self.pool.capacity = 1;
+
+    OFFTStompFrame *first = [self.pool frameWithCommand:OFFTStompFrameCommandSend];
+    OFFTStompFrame *second = [self.pool frameWithCommand:OFFTStompFrameCommandSend];
+    [self.pool recycleFrame:first];
+    [self.pool recycleFrame:second];
+
+    XCTAssertEqual([self.pool frameWithCommand:OFFTStompFrameCommandSend], first);
+    XCTAssertNotEqual([self.pool frameWithCommand:OFFTStompFrameCommandSend], second);
+
+    XCTAssertEqual(self.pool.hits, 1);
+    XCTAssertEqual(self.pool.misses, 3);
+}
+
+#pragma mark - Frame Decoder Delegate
+
+- (void)frameDecoder:(OFFTStompFrameDecoder *)decoder didDecodeFrame:(OFFTStompFrame *)frame {
+    [self.frames addObject:frame];
+}
+
+@end
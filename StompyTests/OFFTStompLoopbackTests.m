@@ -0,0 +1,839 @@
+//
+//  OFFTStompLoopbackTests.m
+//  StompyTests
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "OFFTStompClient.h"
+#import "OFFTStompLoopbackTransport.h"
+#import "OFFTStompSubscriptionOptions.h"
+
+@interface OFFTStompLoopbackTests : XCTestCase <OFFTStompClientDelegate>
+
+@property (nonatomic, strong) OFFTStompLoopbackBroker *broker;
+@property (nonatomic, strong) OFFTStompClient *stomp;
+
+@property (nonatomic, strong) XCTestExpectation *connectionExpectation;
+@property (nonatomic, strong) XCTestExpectation *disconnectionExpectation;
+@property (nonatomic, strong) XCTestExpectation *messagesExpectation;
+@property (nonatomic, strong) XCTestExpectation *outboundDrainedExpectation;
+
+@property (nonatomic, assign) NSUInteger expectedMessageCount;
+@property (nonatomic, strong) NSMutableArray *messages;
+@property (nonatomic, strong) NSError *disconnectionError;
+@property (nonatomic, assign) NSUInteger disconnectionCount;
+@property (nonatomic, assign) BOOL acknowledgesMessages;
+@property (atomic, assign) NSUInteger outboundFullCount;
+
+@end
+
+@implementation OFFTStompLoopbackTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.messages = [NSMutableArray array];
+    self.broker = [[OFFTStompLoopbackBroker alloc] init];
+    self.stomp = [OFFTStompClient stompWithTransport:[OFFTStompLoopbackTransport transportWithBroker:self.broker]];
+    self.stomp.delegate = self;
+}
+
+- (void)testConnection {
+    [self connect];
+    XCTAssertEqual(self.broker.receivedFrameCount, 1);
+}
+
+- (void)testRejectedConnection {
+    self.broker.rejectsConnections = YES;
+
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    [self.stomp connect];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(self.disconnectionError.code, OFFTStompConnectionError);
+}
+
+- (void)testRejectedReconnectionIsReportedOnce {
+    self.stomp.automaticallyReconnects = YES;
+    self.stomp.reconnectInitialDelay = 0.01;
+
+    [self connect];
+    [self.stomp subscribe:@"/topic/a"];
+
+    self.broker.rejectsConnections = YES;
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    [self.broker closeConnections];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(self.disconnectionError.code, OFFTStompConnectionError);
+
+    // Nothing more is reported, nor is another connection attempted
+    XCTestExpectation *settledExpectation = [self expectationWithDescription:@"Settled"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.2 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [settledExpectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(self.disconnectionCount, 1);
+
+    // The session ended, so connecting again subscribes to nothing
+    __block NSUInteger subscribeCount = 0;
+    __block XCTestExpectation *probeExpectation = nil;
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if ([command isEqualToString:@"SUBSCRIBE"]) {
+            ++subscribeCount;
+        } else if ([command isEqualToString:@"SEND"]) {
+            [probeExpectation fulfill];
+        }
+        return NO;
+    };
+    self.broker.rejectsConnections = NO;
+    [self connect];
+
+    probeExpectation = [self expectationWithDescription:@"Probe"];
+    [self.stomp sendMessage:@"probe" toDestination:@"/queue/probe"];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    XCTAssertEqual(subscribeCount, 0);
+}
+
+- (void)testSentMessageIsDeliveredToSubscriber {
+    [self connect];
+    [self.stomp subscribe:@"/topic/a"];
+
+    [self expectMessages:1];
+    [self.stomp sendMessage:@"hello" toDestination:@"/topic/a" withCustomHeaders:@{ @"foo" : @"a:b" }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqualObjects(self.messages[0], [@"hello" dataUsingEncoding:NSUTF8StringEncoding]);
+}
+
+- (void)testSentAndReceivedFramesAreReusedFromThePool {
+    [self connect];
+    [self.stomp subscribe:@"/topic/a"];
+
+    // Each frame is recycled once it has been sent or handled, so only the first few are allocated
+    NSUInteger hits = self.stomp.framePoolHits;
+    NSUInteger misses = self.stomp.framePoolMisses;
+    [self expectMessages:50];
+    for (NSUInteger i = 0; i < 50; ++i) {
+        [self.stomp sendMessage:@"hello" toDestination:@"/topic/a"];
+    }
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertGreaterThanOrEqual(self.stomp.framePoolHits - hits, 98);
+    XCTAssertLessThanOrEqual(self.stomp.framePoolMisses - misses, 2);
+
+    // Without a pool every SEND and MESSAGE frame is allocated
+    self.stomp.framePoolCapacity = 0;
+    XCTAssertEqual(self.stomp.framePoolCapacity, 0);
+
+    hits = self.stomp.framePoolHits;
+    misses = self.stomp.framePoolMisses;
+    [self expectMessages:10];
+    for (NSUInteger i = 0; i < 10; ++i) {
+        [self.stomp sendMessage:@"hello" toDestination:@"/topic/a"];
+    }
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(self.stomp.framePoolHits, hits);
+    XCTAssertEqual(self.stomp.framePoolMisses - misses, 20);
+}
+
+- (void)testPushedMessagesAreReceivedInChunks {
+    self.broker.maximumChunkLength = 100;
+
+    [self connect];
+    [self.stomp subscribe:@"/topic/a"];
+
+    [self expectMessages:500];
+    [self.broker pushMessages:500 toDestination:@"/topic/a" bodyLength:64 rate:0 completion:nil];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual([self.messages.lastObject length], 64);
+}
+
+- (void)testCoalescedWritesKeepFrameBoundaries {
+    self.stomp.coalescesWrites = YES;
+    [self connect];
+    XCTAssertEqual(self.broker.receivedWriteCount, 1);
+
+    // Subscribing and sending in the same turn, everything goes in one write
+    [self.stomp subscribe:@"/topic/a"];
+    [self expectMessages:50];
+    for (NSUInteger i = 0; i < 50; ++i) {
+        NSMutableString *message = [NSMutableString stringWithFormat:@"message %lu ", (unsigned long)i];
+        for (NSUInteger j = 0; j < i; ++j) {
+            [message appendString:@"."];
+        }
+        [self.stomp sendMessage:message toDestination:@"/topic/a"];
+    }
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(self.broker.receivedWriteCount, 2);
+    XCTAssertEqual(self.broker.receivedFrameCount, 52);
+    for (NSUInteger i = 0; i < 50; ++i) {
+        NSString *message = [[NSString alloc] initWithData:self.messages[i] encoding:NSUTF8StringEncoding];
+        XCTAssertTrue([message hasPrefix:[NSString stringWithFormat:@"message %lu ", (unsigned long)i]]);
+        XCTAssertEqual(message.length, [NSString stringWithFormat:@"message %lu ", (unsigned long)i].length + i);
+    }
+}
+
+- (void)testLargeBodySentInPartsArrivesIntact {
+    [self connect];
+    const NSUInteger writes = self.broker.receivedWriteCount;
+    [self.stomp subscribe:@"/topic/a"];
+
+    NSMutableData *body = [NSMutableData dataWithLength:256 * 1024];
+    uint8_t *bytes = body.mutableBytes;
+    for (NSUInteger i = 0; i < body.length; ++i) {
+        bytes[i] = (uint8_t)(i * 31);
+    }
+
+    [self expectMessages:2];
+    [self.stomp sendMessageData:body toDestination:@"/topic/a"];
+    [self.stomp sendMessage:@"after" toDestination:@"/topic/a"];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    // The SUBSCRIBE, then the headers, body and terminator written separately, then the next frame
+    XCTAssertEqual(self.broker.receivedWriteCount - writes, 5);
+    XCTAssertEqualObjects(self.messages[0], body);
+    XCTAssertEqualObjects(self.messages[1], [@"after" dataUsingEncoding:NSUTF8StringEncoding]);
+}
+
+- (void)testPushedMessagesAtRate {
+    [self connect];
+    [self.stomp subscribe:@"/topic/a"];
+
+    [self expectMessages:50];
+    [self.broker pushMessages:50 toDestination:@"/topic/a" bodyLength:16 rate:500 completion:nil];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)testDisconnectWaitsForReceipt {
+    [self connect];
+
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    [self.stomp disconnect];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertNil(self.disconnectionError);
+}
+
+- (void)testFrameHandlerScriptsBroker {
+    __block NSString *destination = nil;
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if ([command isEqualToString:@"SEND"]) {
+            destination = headers[@"destination"];
+            return YES;
+        }
+        return NO;
+    };
+
+    [self connect];
+    [self.stomp subscribe:@"/topic/a"];
+    [self.stomp sendMessage:@"hello" toDestination:@"/topic/a"];
+    [self.stomp disconnect];
+
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqualObjects(destination, @"/topic/a");
+    XCTAssertEqual(self.messages.count, 0);
+}
+
+- (void)testReconnectionRestoresSubscriptions {
+    self.stomp.automaticallyReconnects = YES;
+    self.stomp.reconnectInitialDelay = 0.01;
+
+    [self connect];
+    [self.stomp subscribe:@"/topic/a"];
+
+    // The broker forgets the subscription along with the connection
+    self.connectionExpectation = [self expectationWithDescription:@"Reconnection"];
+    [self.broker closeConnections];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    [self expectMessages:1];
+    [self.broker pushMessages:1 toDestination:@"/topic/a" bodyLength:8 rate:0 completion:nil];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)testSubscriptionBeforeConnectionIsSentOnceConnected {
+    [self.stomp subscribe:@"/topic/a"];
+    [self connect];
+
+    [self expectMessages:1];
+    [self.broker pushMessages:1 toDestination:@"/topic/a" bodyLength:8 rate:0 completion:nil];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)testSilentServerIsDetected {
+    self.broker.heartbeat = @"100,0";
+    self.stomp.heartbeatReceiveInterval = 0.1;
+
+    [self connect];
+
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(self.disconnectionError.code, OFFTStompHeartbeatTimeoutError);
+}
+
+- (void)testSilentServerIsDetectedSoonAfterTheTimeout {
+    self.broker.heartbeat = @"400,0";
+    self.stomp.heartbeatReceiveInterval = 0.4;
+
+    [self connect];
+    const CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    // Within half an interval and a tick of the timing wheel of one and a half intervals
+    const CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    XCTAssertEqual(self.disconnectionError.code, OFFTStompHeartbeatTimeoutError);
+    XCTAssertGreaterThanOrEqual(elapsed, 0.55);
+    XCTAssertLessThan(elapsed, 1.0);
+}
+
+- (void)testClientAcknowledgementsAreBatched {
+    __block NSUInteger ackCount = 0;
+    __block NSString *lastAckID = nil;
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if ([command isEqualToString:@"ACK"]) {
+            ++ackCount;
+            lastAckID = headers[@"id"];
+        }
+        return NO;
+    };
+
+    self.stomp.ackBatchSize = 10;
+    self.acknowledgesMessages = YES;
+
+    [self connect];
+    [self.stomp subscribe:@"/topic/a" ackMode:OFFTStompAckModeClient];
+
+    [self expectMessages:95];
+    [self.broker pushMessages:95 toDestination:@"/topic/a" bodyLength:8 rate:0 completion:nil];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    // The last 5 acknowledgements are sent before disconnecting
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    [self.stomp disconnect];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(ackCount, 10);
+    XCTAssertEqualObjects(lastAckID, @"95");
+}
+
+- (void)testBatchIntervalRestartsOnceABatchIsSent {
+    __block NSUInteger ackCount = 0;
+    __block CFAbsoluteTime lastAckTime = 0;
+    __block XCTestExpectation *ackExpectation = nil;
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if ([command isEqualToString:@"ACK"]) {
+            ++ackCount;
+            lastAckTime = CFAbsoluteTimeGetCurrent();
+            [ackExpectation fulfill];
+        }
+        return NO;
+    };
+
+    self.stomp.ackBatchSize = 3;
+    self.stomp.ackBatchInterval = 0.5;
+    self.acknowledgesMessages = YES;
+
+    [self connect];
+    [self.stomp subscribe:@"/topic/a" ackMode:OFFTStompAckModeClient];
+
+    // A full batch is sent straight away, before the interval its first acknowledgement started
+    ackExpectation = [self expectationWithDescription:@"Full batch"];
+    [self expectMessages:3];
+    [self.broker pushMessages:3 toDestination:@"/topic/a" bodyLength:8 rate:0 completion:nil];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    // Part way through that interval, the next batch starts an interval of its own
+    XCTestExpectation *pauseExpectation = [self expectationWithDescription:@"Pause"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.25 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [pauseExpectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    const CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    ackExpectation = [self expectationWithDescription:@"Interval"];
+    [self expectMessages:1];
+    [self.broker pushMessages:1 toDestination:@"/topic/a" bodyLength:8 rate:0 completion:nil];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(ackCount, 2);
+    XCTAssertGreaterThanOrEqual(lastAckTime - start, 0.45);
+}
+
+- (void)testAcknowledgementBatchesAreCappedByThePrefetchWindow {
+    // The broker sends each window of messages only once the previous one has been acknowledged
+    __weak OFFTStompLoopbackBroker *broker = self.broker;
+    __block NSUInteger ackCount = 0;
+    __block NSString *lastAckID = nil;
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if ([command isEqualToString:@"ACK"]) {
+            lastAckID = headers[@"id"];
+            if (++ackCount < 3) {
+                [broker pushMessages:10 toDestination:@"/topic/a" bodyLength:8 rate:0 completion:nil];
+            }
+        }
+        return NO;
+    };
+
+    // A batch larger than the window would never fill, and no interval would flush it
+    self.stomp.ackBatchSize = 16;
+    self.stomp.ackBatchInterval = 0;
+    self.acknowledgesMessages = YES;
+
+    [self connect];
+    OFFTStompSubscriptionOptions *options = [OFFTStompSubscriptionOptions optionsWithAckMode:OFFTStompAckModeClient prefetchCount:10];
+    [self.stomp subscribe:@"/topic/a" options:options];
+
+    [self expectMessages:30];
+    [self.broker pushMessages:10 toDestination:@"/topic/a" bodyLength:8 rate:0 completion:nil];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    [self.stomp disconnect];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(ackCount, 3);
+    XCTAssertEqualObjects(lastAckID, @"30");
+}
+
+- (void)testPrefetchWindowIsSentAndAcknowledgementsFlow {
+    // Acknowledgements are only held back when sent from outside the client's queue
+    dispatch_queue_t queue = dispatch_queue_create("OFFTStompLoopbackTests", DISPATCH_QUEUE_SERIAL);
+    self.stomp = [OFFTStompClient stompWithTransport:[OFFTStompLoopbackTransport transportWithBroker:self.broker] queue:queue];
+    self.stomp.delegate = self;
+
+    __block XCTestExpectation *probeExpectation = nil;
+    __block NSDictionary *subscribeHeaders = nil;
+    __block NSUInteger ackCount = 0;
+    __block NSUInteger acksBeforeProbe = NSNotFound;
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if ([command isEqualToString:@"SUBSCRIBE"]) {
+            subscribeHeaders = headers;
+        } else if ([command isEqualToString:@"ACK"]) {
+            ++ackCount;
+        } else if ([command isEqualToString:@"SEND"]) {
+            acksBeforeProbe = ackCount;
+            [probeExpectation fulfill];
+        }
+        return NO;
+    };
+
+    [self connect];
+
+    // Messages queue up behind the handler while it is held
+    dispatch_queue_t handlerQueue = dispatch_queue_create("OFFTStompLoopbackTests.handler", DISPATCH_QUEUE_SERIAL);
+    dispatch_semaphore_t arrived = dispatch_semaphore_create(0);
+    dispatch_semaphore_t halfway = dispatch_semaphore_create(0);
+    dispatch_semaphore_t resume = dispatch_semaphore_create(0);
+    dispatch_async(handlerQueue, ^{
+        dispatch_semaphore_wait(arrived, DISPATCH_TIME_FOREVER);
+    });
+
+    __block XCTestExpectation *handledExpectation = nil;
+    __block NSUInteger handled = 0;
+    __weak OFFTStompClient *stomp = self.stomp;
+    OFFTStompMessageHandler handler = ^(NSData *messageData, OFFTStompHeaderView *headerView) {
+        [stomp ackMessageWithHeaders:headerView];
+        if (++handled == 10) {
+            dispatch_semaphore_signal(halfway);
+            dispatch_semaphore_wait(resume, DISPATCH_TIME_FOREVER);
+        } else if (handled == 20) {
+            [handledExpectation fulfill];
+        }
+    };
+
+    OFFTStompSubscriptionOptions *options = [OFFTStompSubscriptionOptions optionsWithAckMode:OFFTStompAckModeClientIndividual prefetchCount:2];
+    options.headers = @{ @"selector" : @"priority > 1", @"id" : @"ignored" };
+    [self.stomp subscribe:@"/topic/a" options:options handler:handler queue:handlerQueue];
+
+    // Once the client has queued all of them for the handler
+    XCTestExpectation *pushedExpectation = [self expectationWithDescription:@"Pushed"];
+    [self.broker pushMessages:20 toDestination:@"/topic/a" bodyLength:8 rate:0 completion:^{
+        dispatch_async(queue, ^{
+            [pushedExpectation fulfill];
+        });
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    // Half handled, 10 remain queued, more than the prefetch window
+    dispatch_semaphore_signal(arrived);
+    dispatch_semaphore_wait(halfway, DISPATCH_TIME_FOREVER);
+    dispatch_sync(queue, ^{});
+
+    // Anything acknowledged would reach the broker before the probe
+    probeExpectation = [self expectationWithDescription:@"Probe"];
+    [self.stomp sendMessage:@"probe" toDestination:@"/queue/probe"];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    XCTAssertEqual(acksBeforeProbe, 0);
+
+    // Released once the backlog drains to within the window
+    handledExpectation = [self expectationWithDescription:@"Handled"];
+    dispatch_semaphore_signal(resume);
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    // After the acknowledgements already on their way to the client's queue
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    dispatch_async(queue, ^{
+        [self.stomp disconnect];
+    });
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqualObjects(subscribeHeaders[@"ack"], @"client-individual");
+    XCTAssertEqualObjects(subscribeHeaders[@"prefetch-count"], @"2");
+    XCTAssertEqualObjects(subscribeHeaders[@"activemq.prefetchSize"], @"2");
+    XCTAssertEqualObjects(subscribeHeaders[@"selector"], @"priority > 1");
+    XCTAssertNotEqualObjects(subscribeHeaders[@"id"], @"ignored");
+    XCTAssertEqual(ackCount, 20);
+}
+
+- (void)testTransactionIsConfirmedByOneReceipt {
+    __block NSUInteger receiptRequests = 0;
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if (headers[@"receipt"]) {
+            ++receiptRequests;
+        }
+        return NO;
+    };
+
+    [self connect];
+    [self.stomp subscribe:@"/topic/a"];
+
+    id transaction = [self.stomp beginTransaction];
+    NSData *message = [@"hello" dataUsingEncoding:NSUTF8StringEncoding];
+    for (NSUInteger i = 0; i < 100; ++i) {
+        [self.stomp sendMessageData:message toDestination:@"/topic/a" withCustomHeaders:nil transaction:transaction];
+    }
+
+    [self expectMessages:100];
+    XCTestExpectation *commitExpectation = [self expectationWithDescription:@"Commit"];
+    [self.stomp commitTransaction:transaction completion:^(BOOL committed) {
+        XCTAssertTrue(committed);
+        [commitExpectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(receiptRequests, 1);
+}
+
+- (void)testTransactionCannotBeginWhileDisconnected {
+    XCTAssertNil([self.stomp beginTransaction]);
+
+    [self connect];
+    XCTAssertNotNil([self.stomp beginTransaction]);
+}
+
+- (void)testAbortedTransactionIsNotDelivered {
+    [self connect];
+    [self.stomp subscribe:@"/topic/a"];
+
+    id transaction = [self.stomp beginTransaction];
+    [self.stomp sendMessageData:[@"hello" dataUsingEncoding:NSUTF8StringEncoding] toDestination:@"/topic/a" withCustomHeaders:nil transaction:transaction];
+    [self.stomp abortTransaction:transaction];
+
+    XCTestExpectation *commitExpectation = [self expectationWithDescription:@"Commit"];
+    [self.stomp commitTransaction:transaction completion:^(BOOL committed) {
+        XCTAssertFalse(committed);
+        [commitExpectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    // Anything delivered would arrive before the receipt for the disconnection
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    [self.stomp disconnect];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(self.messages.count, 0);
+}
+
+- (void)testConfirmedSendsStayWithinWindow {
+    self.stomp.confirmedSendWindow = 8;
+
+    __block NSUInteger sends = 0;
+    __block NSUInteger confirmations = 0;
+    __block NSUInteger maximumUnconfirmed = 0;
+    NSObject *lock = [[NSObject alloc] init];
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if ([command isEqualToString:@"SEND"]) {
+            @synchronized(lock) {
+                ++sends;
+                maximumUnconfirmed = MAX(maximumUnconfirmed, sends - confirmations);
+            }
+        }
+        return NO;
+    };
+
+    [self connect];
+
+    XCTestExpectation *confirmationExpectation = [self expectationWithDescription:@"Confirmations"];
+    NSData *message = [@"hello" dataUsingEncoding:NSUTF8StringEncoding];
+    for (NSUInteger i = 0; i < 100; ++i) {
+        [self.stomp sendMessageData:message toDestination:@"/queue/a" withCustomHeaders:nil completion:^(BOOL confirmed) {
+            XCTAssertTrue(confirmed);
+            @synchronized(lock) {
+                if (++confirmations == 100) {
+                    [confirmationExpectation fulfill];
+                }
+            }
+        }];
+    }
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(sends, 100);
+    XCTAssertLessThanOrEqual(maximumUnconfirmed, 8);
+}
+
+- (void)testDisconnectDoesNotWaitForeverForReceipt {
+    self.stomp.receiptTimeout = 0.2;
+    self.broker.sendsReceipts = NO;
+    [self connect];
+
+    XCTestExpectation *confirmationExpectation = [self expectationWithDescription:@"Confirmation"];
+    [self.stomp sendMessageData:[@"hello" dataUsingEncoding:NSUTF8StringEncoding] toDestination:@"/queue/a" withCustomHeaders:nil completion:^(BOOL confirmed) {
+        XCTAssertFalse(confirmed);
+        [confirmationExpectation fulfill];
+    }];
+
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    [self.stomp disconnect];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)testSubscriptionHandlersReceiveOnlyTheirMessages {
+    [self connect];
+
+    // Two subscriptions to the same destination can only be told apart by their subscription header
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Handlers"];
+    dispatch_queue_t queue = dispatch_queue_create("OFFTStompLoopbackTests", DISPATCH_QUEUE_SERIAL);
+    NSArray *destinations = @[ @"/topic/a", @"/topic/a", @"/topic/b" ];
+    NSMutableArray *received = [NSMutableArray array];
+    __block NSUInteger total = 0;
+
+    for (NSUInteger i = 0; i < destinations.count; ++i) {
+        NSMutableArray *headerViews = [NSMutableArray array];
+        [received addObject:headerViews];
+
+        [self.stomp subscribe:destinations[i] handler:^(NSData *messageData, OFFTStompHeaderView *headerView) {
+            [headerViews addObject:headerView];
+            if (++total == 40) {
+                [expectation fulfill];
+            }
+        } queue:queue];
+    }
+
+    [self.broker pushMessages:10 toDestination:@"/topic/a" bodyLength:16 rate:0 completion:nil];
+    [self.broker pushMessages:20 toDestination:@"/topic/b" bodyLength:16 rate:0 completion:nil];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    NSArray *expectedCounts = @[ @10, @10, @20 ];
+    NSMutableSet *subscriptions = [NSMutableSet set];
+    for (NSUInteger i = 0; i < destinations.count; ++i) {
+        NSArray *headerViews = received[i];
+        XCTAssertEqual(headerViews.count, [expectedCounts[i] unsignedIntegerValue]);
+
+        NSString *subscription = [headerViews.firstObject valueForHeader:@"subscription"];
+        XCTAssertNotNil(subscription);
+        [subscriptions addObject:subscription];
+
+        for (OFFTStompHeaderView *headerView in headerViews) {
+            XCTAssertTrue([headerView hasHeader:@"destination" equalToString:destinations[i]]);
+            XCTAssertTrue([headerView hasHeader:@"subscription" equalToString:subscription]);
+        }
+    }
+
+    XCTAssertEqual(subscriptions.count, 3);
+    XCTAssertEqual(self.messages.count, 0);
+}
+
+- (void)testOutboundPolicyDropsMessagesWhileFull {
+    __block NSUInteger sends = 0;
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if ([command isEqualToString:@"SEND"]) {
+            ++sends;
+        }
+        return NO;
+    };
+    self.broker.writeDelay = 0.01;
+    [self connect];
+
+    self.stomp.outboundHighWatermark = 2048;
+    self.stomp.outboundLowWatermark = 512;
+    self.stomp.outboundPolicy = OFFTStompOutboundPolicyDrop;
+
+    // The client runs on this queue, so nothing is reported written until the loop has finished
+    self.outboundDrainedExpectation = [self expectationWithDescription:@"Drained"];
+    NSData *message = [[NSMutableData alloc] initWithLength:200];
+    for (NSUInteger i = 0; i < 100; ++i) {
+        XCTAssertTrue([self.stomp sendMessageData:message toDestination:@"/queue/a"]);
+    }
+    XCTAssertGreaterThanOrEqual(self.stomp.outboundBytes, 2048);
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual(self.outboundFullCount, 1);
+    XCTAssertLessThanOrEqual(self.stomp.outboundBytes, 512);
+
+    const NSUInteger dropped = self.stomp.droppedMessageCount;
+    XCTAssertGreaterThan(dropped, 0);
+
+    // Everything sent arrives before the DISCONNECT
+    [self disconnect];
+    XCTAssertEqual(sends, 100 - dropped);
+}
+
+- (void)testOutboundPolicyRejectsMessagesWhileFull {
+    __block NSUInteger sends = 0;
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if ([command isEqualToString:@"SEND"]) {
+            ++sends;
+        }
+        return NO;
+    };
+    self.broker.writeDelay = 0.01;
+    [self connect];
+
+    self.stomp.outboundHighWatermark = 2048;
+    self.stomp.outboundLowWatermark = 512;
+    self.stomp.outboundPolicy = OFFTStompOutboundPolicyFail;
+
+    self.outboundDrainedExpectation = [self expectationWithDescription:@"Drained"];
+    NSData *message = [[NSMutableData alloc] initWithLength:200];
+    NSUInteger rejected = 0;
+    for (NSUInteger i = 0; i < 100; ++i) {
+        if ([self.stomp sendMessageData:message toDestination:@"/queue/a"] == NO) {
+            ++rejected;
+        }
+    }
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    // Once drained, messages are accepted again
+    XCTAssertGreaterThan(rejected, 0);
+    XCTAssertEqual(self.stomp.droppedMessageCount, 0);
+    XCTAssertTrue([self.stomp sendMessageData:message toDestination:@"/queue/a"]);
+
+    [self disconnect];
+    XCTAssertEqual(sends, 101 - rejected);
+}
+
+- (void)testOutboundPolicyBlocksSenderUntilDrained {
+    // Senders only wait when they are not on the client's queue
+    dispatch_queue_t queue = dispatch_queue_create("OFFTStompLoopbackTests", DISPATCH_QUEUE_SERIAL);
+    self.stomp = [OFFTStompClient stompWithTransport:[OFFTStompLoopbackTransport transportWithBroker:self.broker] queue:queue];
+    self.stomp.delegate = self;
+
+    __block NSUInteger sends = 0;
+    self.broker.frameHandler = ^BOOL(NSString *command, NSDictionary *headers, NSData *body) {
+        if ([command isEqualToString:@"SEND"]) {
+            ++sends;
+        }
+        return NO;
+    };
+    self.broker.writeDelay = 0.01;
+    [self connect];
+
+    self.stomp.outboundHighWatermark = 2048;
+    self.stomp.outboundLowWatermark = 512;
+    self.stomp.outboundPolicy = OFFTStompOutboundPolicyBlock;
+
+    self.outboundDrainedExpectation = [self expectationWithDescription:@"Drained"];
+    NSData *message = [[NSMutableData alloc] initWithLength:200];
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < 100; ++i) {
+        XCTAssertTrue([self.stomp sendMessageData:message toDestination:@"/queue/a"]);
+
+        // Lets the client account for each message before the next is sent
+        dispatch_sync(self.stomp.queue, ^{});
+        XCTAssertLessThanOrEqual(self.stomp.outboundBytes, 2048 + 512);
+    }
+
+    // Unblocked, the loop would finish long before the first few writes had been read
+    XCTAssertGreaterThanOrEqual(CFAbsoluteTimeGetCurrent() - start, 0.05);
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertGreaterThanOrEqual(self.outboundFullCount, 1);
+    XCTAssertEqual(self.stomp.droppedMessageCount, 0);
+
+    [self disconnect];
+    XCTAssertEqual(sends, 100);
+}
+
+- (void)testMessageDispatchPerformance {
+    [self connect];
+    [self.stomp subscribe:@"/topic/a"];
+
+    [self measureBlock:^{
+        [self.messages removeAllObjects];
+        [self expectMessages:10000];
+        [self.broker pushMessages:10000 toDestination:@"/topic/a" bodyLength:128 rate:0 completion:nil];
+        [self waitForExpectationsWithTimeout:30.0 handler:nil];
+    }];
+}
+
+#pragma mark - Helpers
+
+- (void)connect {
+    self.connectionExpectation = [self expectationWithDescription:@"Connection"];
+    [self.stomp connect];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)disconnect {
+    self.disconnectionExpectation = [self expectationWithDescription:@"Disconnection"];
+    [self.stomp disconnect];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)expectMessages:(NSUInteger)count {
+    self.expectedMessageCount = self.messages.count + count;
+    self.messagesExpectation = [self expectationWithDescription:@"Messages"];
+}
+
+#pragma mark - Stomp Client Delegate
+
+- (void)stompClientDidConnect:(OFFTStompClient *)stompClient {
+    [self.connectionExpectation fulfill];
+}
+
+- (void)stompClient:(OFFTStompClient *)stompClient didDisconnectWithError:(NSError *)error {
+    ++self.disconnectionCount;
+    if (self.disconnectionExpectation) {
+        self.disconnectionError = error;
+        [self.disconnectionExpectation fulfill];
+        self.disconnectionExpectation = nil;
+    }
+}
+
+- (void)stompClientOutboundBufferFull:(OFFTStompClient *)stompClient {
+    ++self.outboundFullCount;
+}
+
+- (void)stompClientOutboundBufferDrained:(OFFTStompClient *)stompClient {
+    [self.outboundDrainedExpectation fulfill];
+    self.outboundDrainedExpectation = nil;
+}
+
+- (void)stompClient:(OFFTStompClient *)stompClient
+receivedMessageData:(NSData *)messageData
+     withHeaderView:(OFFTStompHeaderView *)headerView {
+
+    [self.messages addObject:messageData];
+    if (self.acknowledgesMessages) {
+        [stompClient ackMessageWithHeaders:headerView];
+    }
+    if (self.messages.count == self.expectedMessageCount) {
+        [self.messagesExpectation fulfill];
+    }
+}
+
+@end
@@ -0,0 +1,77 @@
+//
+//  OFFTStompReceiptTableTests.m
+//  StompyTests
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "OFFTStompReceiptTable.h"
+
+@interface OFFTStompReceiptTableTests : XCTestCase
+
+@property (nonatomic, strong) OFFTStompReceiptTable *table;
+
+@end
+
+@implementation OFFTStompReceiptTableTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.table = [[OFFTStompReceiptTable alloc] initWithQueue:dispatch_get_main_queue()];
+}
+
+- (void)testReceiptsCompleteInAnyOrder {
+    NSMutableArray *completed = [NSMutableArray array];
+    uint64_t receipts[5];
+    for (NSUInteger i = 0; i < 5; ++i) {
+        receipts[i] = [self.table addReceiptWithTimeout:0 handler:^(BOOL received) {
+            XCTAssertTrue(received);
+            [completed addObject:@(i)];
+        }];
+    }
+
+    XCTAssertTrue([self.table completeReceipt:receipts[0]]);
+    XCTAssertTrue([self.table completeReceipt:receipts[3]]);
+    XCTAssertTrue([self.table completeReceipt:receipts[1]]);
+    XCTAssertFalse([self.table completeReceipt:receipts[3]]);
+    XCTAssertFalse([self.table completeReceipt:receipts[4] + 1]);
+
+    XCTAssertEqualObjects(completed, (@[@0, @3, @1]));
+    XCTAssertEqual(self.table.count, 2);
+}
+
+- (void)testOnlyUnconfirmableReceiptsFail {
+    __block BOOL failed = NO;
+    [self.table addReceiptWithTimeout:0 handler:^(BOOL received) {
+        failed = !received;
+    }];
+    uint64_t kept = [self.table addReceiptWithTimeout:0 handler:nil];
+    NSData *frameData = [@"SEND\n\n\0" dataUsingEncoding:NSUTF8StringEncoding];
+    [self.table setFrameParts:@[frameData] forReceipt:kept];
+
+    [self.table failUnconfirmableReceipts];
+
+    XCTAssertTrue(failed);
+    XCTAssertEqual(self.table.count, 1);
+    XCTAssertEqualObjects([self.table unconfirmedFrameParts], @[frameData]);
+}
+
+- (void)testReceiptFailsOnceItsDeadlinePasses {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Deadline"];
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    [self.table addReceiptWithTimeout:0.2 handler:^(BOOL received) {
+        XCTAssertFalse(received);
+        XCTAssertGreaterThanOrEqual(CFAbsoluteTimeGetCurrent() - start, 0.2);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    XCTAssertEqual(self.table.count, 0);
+}
+
+@end
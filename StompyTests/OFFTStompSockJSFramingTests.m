@@ -0,0 +1,90 @@
+//
+//  OFFTStompSockJSFramingTests.m
+//  StompyTests
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "OFFTStompSockJSFraming.h"
+
+@interface OFFTStompSockJSFramingTests : XCTestCase
+
+@end
+
+@implementation OFFTStompSockJSFramingTests
+
+- (void)testDecodesBatchedFrames {
+    NSData *array = [self dataWithString:@"[\"MESSAGE\\ndestination:/a\\n\\none\\u0000\",\"MESSAGE\\n\\ntwo\\u0000\"]"];
+    NSMutableData *output = [NSMutableData data];
+    NSUInteger count = 0;
+
+    XCTAssertTrue(OFFTStompSockJSAppendDecodedArray(array.bytes, array.length, output, &count));
+    XCTAssertEqual(count, 2);
+
+    const char expected[] = "MESSAGE\ndestination:/a\n\none\0MESSAGE\n\ntwo\0";
+    XCTAssertEqualObjects(output, [NSData dataWithBytes:expected length:sizeof(expected) - 1]);
+}
+
+- (void)testDecodesEscapes {
+    NSData *array = [self dataWithString:@"[\"\\\"\\\\\\/\\t\\u00e9\\ud83d\\ude00\"]"];
+    NSMutableData *output = [NSMutableData data];
+
+    XCTAssertTrue(OFFTStompSockJSAppendDecodedArray(array.bytes, array.length, output, NULL));
+    XCTAssertEqualObjects(output, [self dataWithString:@"\"\\/\t\u00e9\U0001F600"]);
+}
+
+- (void)testDecodesEmptyArray {
+    NSData *array = [self dataWithString:@" [ ] "];
+    NSMutableData *output = [NSMutableData data];
+    NSUInteger count = 1;
+
+    XCTAssertTrue(OFFTStompSockJSAppendDecodedArray(array.bytes, array.length, output, &count));
+    XCTAssertEqual(count, 0);
+    XCTAssertEqual(output.length, 0);
+}
+
+- (void)testRejectsMalformedArrays {
+    for (NSString *string in @[ @"", @"[", @"[\"a\"", @"[\"a\",]", @"[\"\\x\"]", @"[\"\\ud83d\"]", @"[\"a\"] x" ]) {
+        NSData *array = [self dataWithString:string];
+        XCTAssertFalse(OFFTStompSockJSAppendDecodedArray(array.bytes, array.length, [NSMutableData data], NULL), @"%@", string);
+    }
+}
+
+- (void)testEncodedStringRoundTrips {
+    const char frame[] = "SEND\ndestination:/a\n\n\"quoted\" \\ \t\u00e9\0";
+    NSMutableData *array = [NSMutableData dataWithBytes:"[" length:1];
+    OFFTStompSockJSAppendEncodedString((const uint8_t *)frame, sizeof(frame) - 1, array);
+    [array appendBytes:"]" length:1];
+
+    NSMutableData *output = [NSMutableData data];
+    XCTAssertTrue(OFFTStompSockJSAppendDecodedArray(array.bytes, array.length, output, NULL));
+    XCTAssertEqualObjects(output, [NSData dataWithBytes:frame length:sizeof(frame) - 1]);
+
+    // Produces JSON any parser accepts
+    NSArray *parsed = [NSJSONSerialization JSONObjectWithData:array options:0 error:nil];
+    XCTAssertEqual(parsed.count, 1);
+}
+
+- (void)testValidatesUTF8 {
+    const char *valid[] = { "", "ascii", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xef\xbf\xbf", "\xf4\x8f\xbf\xbf" };
+    for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); ++i) {
+        XCTAssertTrue(OFFTStompSockJSIsValidUTF8((const uint8_t *)valid[i], strlen(valid[i])), @"%zu", i);
+    }
+
+    // Stray continuation, truncated, overlong, surrogate, beyond U+10FFFF, invalid lead byte
+    const char *invalid[] = { "\x80", "a\xc3", "\xe2\x82", "\xc0\xaf", "\xe0\x80\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xff", "\xc3\x28" };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+        XCTAssertFalse(OFFTStompSockJSIsValidUTF8((const uint8_t *)invalid[i], strlen(invalid[i])), @"%zu", i);
+    }
+}
+
+#pragma mark - Helpers
+
+- (NSData *)dataWithString:(NSString *)string {
+    return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+@end
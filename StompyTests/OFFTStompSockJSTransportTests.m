@@ -0,0 +1,234 @@
+//
+//  OFFTStompSockJSTransportTests.m
+//  StompyTests
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "OFFTStompSockJSTransport.h"
+#import "OFFTStompSockJSFraming.h"
+#import "SRWebSocket.h"
+
+/**
+ *  A WebSocket that never touches the network, standing in for a SockJS server.
+ */
+@interface OFFTStompFakeWebSocket : SRWebSocket
+
+@property (nonatomic, assign) BOOL opened;
+@property (nonatomic, assign) NSInteger closeCode;
+@property (nonatomic, strong) NSMutableArray *sentMessages;
+
+- (void)receiveMessage:(NSString *)message;
+
+@end
+
+static OFFTStompFakeWebSocket *OFFTStompLastFakeWebSocket;
+
+@implementation OFFTStompFakeWebSocket
+
+- (id)initWithURL:(NSURL *)url {
+    self = [super initWithURL:url];
+    if (self) {
+        _sentMessages = [NSMutableArray array];
+        OFFTStompLastFakeWebSocket = self;
+    }
+    return self;
+}
+
+- (void)open {
+    self.opened = YES;
+}
+
+- (void)send:(id)data {
+    [self.sentMessages addObject:data];
+}
+
+- (void)close {
+    [self closeWithCode:1000 reason:nil];
+}
+
+- (void)closeWithCode:(NSInteger)code reason:(NSString *)reason {
+    self.closeCode = code;
+    [self.delegate webSocket:self didCloseWithCode:code reason:reason wasClean:YES];
+}
+
+- (void)receiveMessage:(NSString *)message {
+    [self.delegate webSocket:self didReceiveMessage:[message dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+@end
+
+@interface OFFTStompSockJSTransportTests : XCTestCase <OFFTStompTransportDelegate>
+
+@property (nonatomic, strong) OFFTStompSockJSTransport *transport;
+
+@property (nonatomic, assign) NSUInteger openCount;
+@property (nonatomic, assign) NSUInteger closeCount;
+@property (nonatomic, strong) NSMutableArray *received;
+@property (nonatomic, strong) NSError *error;
+
+@end
+
+@implementation OFFTStompSockJSTransportTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.received = [NSMutableArray array];
+    self.transport = [OFFTStompSockJSTransport transportWithURL:[NSURL URLWithString:@"http://localhost:8080/ws"]];
+    self.transport.socketClass = [OFFTStompFakeWebSocket class];
+    self.transport.delegate = self;
+}
+
+- (void)tearDown {
+    OFFTStompLastFakeWebSocket = nil;
+    [super tearDown];
+}
+
+- (void)testSessionFraming {
+    [self.transport open];
+    OFFTStompFakeWebSocket *socket = OFFTStompLastFakeWebSocket;
+    XCTAssertTrue(socket.opened);
+    XCTAssertTrue([socket.url.path hasPrefix:@"/ws/"]);
+    XCTAssertTrue([socket.url.path hasSuffix:@"/websocket"]);
+
+    // Only the SockJS open frame opens the transport
+    XCTAssertEqual(self.openCount, 0);
+    [socket receiveMessage:@"o"];
+    XCTAssertEqual(self.openCount, 1);
+
+    [socket receiveMessage:@"h"];
+    XCTAssertEqual(self.received.count, 0);
+
+    // Every frame in an array arrives in one chunk
+    [socket receiveMessage:@"a[\"MESSAGE\\ndestination:/a\\n\\none\\u0000\",\"MESSAGE\\n\\ntwo\\u0000\"]"];
+    XCTAssertEqual(self.received.count, 1);
+    const char expected[] = "MESSAGE\ndestination:/a\n\none\0MESSAGE\n\ntwo\0";
+    XCTAssertEqualObjects(self.received[0], [NSData dataWithBytes:expected length:sizeof(expected) - 1]);
+
+    [socket receiveMessage:@"c[3000,\"Go away!\"]"];
+    XCTAssertEqual(self.closeCount, 1);
+    XCTAssertNil(self.error);
+}
+
+- (void)testMalformedArrayFailsTransport {
+    [self.transport open];
+    OFFTStompFakeWebSocket *socket = OFFTStompLastFakeWebSocket;
+    [socket receiveMessage:@"o"];
+
+    [socket receiveMessage:@"a[\"MESSAGE\\n\\nunterminated"];
+
+    XCTAssertEqual(self.received.count, 0);
+    XCTAssertEqualObjects(self.error.domain, OFFTStompSockJSErrorDomain);
+    XCTAssertEqual(self.error.code, OFFTStompSockJSMalformedFrameError);
+    XCTAssertEqual(socket.closeCode, SRStatusCodeProtocolError);
+    XCTAssertEqual(self.closeCount, 1);
+}
+
+- (void)testUnknownFrameFailsTransport {
+    [self.transport open];
+    OFFTStompFakeWebSocket *socket = OFFTStompLastFakeWebSocket;
+    [socket receiveMessage:@"o"];
+
+    [socket receiveMessage:@"x"];
+
+    XCTAssertEqual(self.error.code, OFFTStompSockJSMalformedFrameError);
+    XCTAssertEqual(self.closeCount, 1);
+}
+
+- (void)testFramesSentInOneTurnAreBatched {
+    [self.transport open];
+    OFFTStompFakeWebSocket *socket = OFFTStompLastFakeWebSocket;
+    [socket receiveMessage:@"o"];
+
+    // Bodies needing escaping, and one that is not ASCII
+    const char plain[] = "SEND\ndestination:/a\n\none\0";
+    const char escaped[] = "SEND\ndestination:/a\n\n\"t\\w\to\"\0";
+    const char accented[] = "SEND\ndestination:/a\n\n\xc3\xa9\0";
+    NSArray *frames = @[[NSData dataWithBytes:plain length:sizeof(plain) - 1],
+                        [NSData dataWithBytes:escaped length:sizeof(escaped) - 1],
+                        [NSData dataWithBytes:accented length:sizeof(accented) - 1]];
+    NSMutableData *expected = [NSMutableData data];
+    for (NSData *frame in frames) {
+        [self.transport sendData:frame];
+        [expected appendData:frame];
+    }
+    XCTAssertEqual(socket.sentMessages.count, 0);
+
+    [self finishQueueTurn];
+    XCTAssertEqual(socket.sentMessages.count, 1);
+
+    NSData *message = [socket.sentMessages[0] dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *decoded = [NSMutableData data];
+    NSUInteger count = 0;
+    XCTAssertTrue(OFFTStompSockJSAppendDecodedArray(message.bytes, message.length, decoded, &count));
+    XCTAssertEqual(count, 3);
+    XCTAssertEqualObjects(decoded, expected);
+
+    // The next turn starts a new batch
+    [self.transport sendData:frames[0]];
+    [self finishQueueTurn];
+    XCTAssertEqual(socket.sentMessages.count, 2);
+}
+
+- (void)testInvalidUTF8FailsTransport {
+    [self.transport open];
+    OFFTStompFakeWebSocket *socket = OFFTStompLastFakeWebSocket;
+    [socket receiveMessage:@"o"];
+
+    const char plain[] = "SEND\ndestination:/a\n\none\0";
+    const char invalid[] = "SEND\ndestination:/a\n\n\xff\0";
+    [self.transport sendData:[NSData dataWithBytes:plain length:sizeof(plain) - 1]];
+    [self.transport sendData:[NSData dataWithBytes:invalid length:sizeof(invalid) - 1]];
+
+    XCTAssertEqualObjects(self.error.domain, OFFTStompSockJSErrorDomain);
+    XCTAssertEqual(self.error.code, OFFTStompSockJSInvalidUTF8Error);
+    XCTAssertEqual(self.closeCount, 1);
+
+    // Frames sent before it are not lost with it
+    XCTAssertEqual(socket.sentMessages.count, 1);
+    NSData *message = [socket.sentMessages[0] dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *decoded = [NSMutableData data];
+    XCTAssertTrue(OFFTStompSockJSAppendDecodedArray(message.bytes, message.length, decoded, NULL));
+    XCTAssertEqualObjects(decoded, [NSData dataWithBytes:plain length:sizeof(plain) - 1]);
+}
+
+#pragma mark - Helpers
+
+/**
+ *  Waits for everything already dispatched to the main queue, where the transport batches sends.
+ */
+- (void)finishQueueTurn {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Turn"];
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+#pragma mark - Transport Delegate
+
+- (void)transportDidOpen:(id<OFFTStompTransportAdapter>)transport {
+    ++self.openCount;
+}
+
+- (void)transportDidClose:(id<OFFTStompTransportAdapter>)transport {
+    ++self.closeCount;
+}
+
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didReceiveMessage:(NSString *)message {
+    XCTFail(@"Frames should be received as data");
+}
+
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didReceiveData:(NSData *)data {
+    [self.received addObject:data];
+}
+
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didFailWithError:(NSError *)error {
+    self.error = error;
+}
+
+@end
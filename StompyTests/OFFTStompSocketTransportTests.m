@@ -0,0 +1,286 @@
+//
+//  OFFTStompSocketTransportTests.m
+//  StompyTests
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "OFFTStompGCDAsyncSocketTransport.h"
+#import "OFFTStompPOSIXSocketTransport.h"
+#import "OFFTStompFrameDecoder.h"
+#import "OFFTStompFrame.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+/**
+ *  Tests transports against a listening socket on localhost,
+ *  which the tests accept a connection on and drive by hand.
+ */
+@interface OFFTStompSocketTransportTests : XCTestCase <OFFTStompTransportDelegate, OFFTStompFrameDecoderDelegate>
+
+@property (nonatomic, assign) int listener;
+@property (nonatomic, assign) uint16_t port;
+@property (nonatomic, assign) int connection;
+
+@property (nonatomic, strong) OFFTStompFrameDecoder *decoder;
+@property (nonatomic, strong) NSMutableArray *frames;
+@property (nonatomic, assign) NSUInteger expectedFrameCount;
+@property (nonatomic, assign) NSUInteger largestReceivedLength;
+
+@property (nonatomic, assign) NSUInteger expectedWrittenLength;
+@property (nonatomic, assign) NSUInteger writtenLength;
+@property (nonatomic, assign) NSUInteger writeReportCount;
+
+@property (nonatomic, strong) XCTestExpectation *openExpectation;
+@property (nonatomic, strong) XCTestExpectation *framesExpectation;
+@property (nonatomic, strong) XCTestExpectation *writtenExpectation;
+
+@end
+
+@implementation OFFTStompSocketTransportTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.frames = [NSMutableArray array];
+    self.decoder = [[OFFTStompFrameDecoder alloc] init];
+    self.decoder.delegate = self;
+    self.connection = -1;
+
+    self.listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_port = 0 };
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    XCTAssertEqual(bind(self.listener, (struct sockaddr *)&address, sizeof(address)), 0);
+    XCTAssertEqual(listen(self.listener, 1), 0);
+
+    socklen_t length = sizeof(address);
+    getsockname(self.listener, (struct sockaddr *)&address, &length);
+    self.port = ntohs(address.sin_port);
+}
+
+- (void)tearDown {
+    if (self.connection >= 0) {
+        close(self.connection);
+    }
+    close(self.listener);
+
+    [super tearDown];
+}
+
+- (void)testGCDAsyncSocketReadPumpDecodesFramesAcrossChunks {
+    OFFTStompGCDAsyncSocketTransport *transport = [OFFTStompGCDAsyncSocketTransport transportWithHost:@"127.0.0.1" port:self.port connectionTimeout:5.0];
+    transport.readChunkSize = 7;
+    transport.delegate = self;
+
+    [self openTransport:transport];
+
+    // Bodies hold NULL bytes, so frames can only be split correctly by their content-length
+    NSMutableData *stream = [NSMutableData data];
+    for (NSUInteger i = 0; i < 100; ++i) {
+        NSString *headers = [NSString stringWithFormat:@"MESSAGE\ndestination:/a\nmessage-id:%lu\ncontent-length:%lu\n\n", (unsigned long)i, (unsigned long)(i + 1)];
+        [stream appendData:[headers dataUsingEncoding:NSUTF8StringEncoding]];
+        [stream increaseLengthBy:i + 1];
+        [stream appendBytes:"\0" length:1];
+    }
+
+    [self expectFrames:100];
+    [self writeData:stream];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertLessThanOrEqual(self.largestReceivedLength, 7);
+    for (NSUInteger i = 0; i < 100; ++i) {
+        OFFTStompFrame *frame = self.frames[i];
+        XCTAssertEqualObjects([frame valueForHeader:@"message-id"], ([NSString stringWithFormat:@"%lu", (unsigned long)i]));
+        XCTAssertEqual(frame.body.length, i + 1);
+    }
+
+    [transport close];
+}
+
+- (void)testPOSIXTransportRoundTrip {
+    // localhost may resolve to ::1 first, which nothing is listening on
+    OFFTStompPOSIXSocketTransport *transport = [OFFTStompPOSIXSocketTransport transportWithHost:@"localhost" port:self.port connectionTimeout:5.0];
+    transport.delegate = self;
+
+    [self openTransport:transport];
+
+    NSData *sent = [@"SEND\ndestination:/a\n\nhello\0" dataUsingEncoding:NSUTF8StringEncoding];
+    [self expectWrittenLength:sent.length];
+    [transport sendData:sent];
+    XCTAssertEqualObjects([self readDataOfLength:sent.length pause:0], sent);
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    [self expectFrames:2];
+    [self writeData:[@"MESSAGE\ndestination:/a\nmessage-id:1\n\nhello\0MESSAGE\ndestination:/a\nmessage-id:2\n\nworld\0" dataUsingEncoding:NSUTF8StringEncoding]];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqualObjects([self.frames[0] body], [@"hello" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqualObjects([self.frames[1] body], [@"world" dataUsingEncoding:NSUTF8StringEncoding]);
+
+    [transport close];
+}
+
+- (void)testPOSIXTransportQueuesWritesUntilTheSocketDrains {
+    // Small socket buffers at both ends, so the socket fills long before the payload has been written
+    int receiveBufferSize = 4096;
+    setsockopt(self.listener, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize));
+
+    OFFTStompPOSIXSocketTransport *transport = [OFFTStompPOSIXSocketTransport transportWithHost:@"127.0.0.1" port:self.port connectionTimeout:5.0];
+    transport.sendBufferSize = 4096;
+    transport.delegate = self;
+
+    [self openTransport:transport];
+
+    NSMutableData *body = [NSMutableData dataWithLength:4 * 1024 * 1024];
+    uint8_t *bytes = body.mutableBytes;
+    for (NSUInteger i = 0; i < body.length; ++i) {
+        bytes[i] = (uint8_t)(i * 31);
+    }
+    NSArray *parts = @[[@"SEND\ndestination:/a\n\n" dataUsingEncoding:NSUTF8StringEncoding], body, [NSData dataWithBytes:"\0" length:1]];
+
+    NSMutableData *expected = [NSMutableData data];
+    for (NSData *part in parts) {
+        [expected appendData:part];
+    }
+
+    [self expectWrittenLength:expected.length];
+    [transport sendDataParts:parts];
+
+    // Read slowly, leaving the rest queued in the transport in the meantime
+    XCTestExpectation *readExpectation = [self expectationWithDescription:@"Read"];
+    __block NSData *received = nil;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        received = [self readDataOfLength:expected.length pause:1000];
+        [readExpectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:30.0 handler:nil];
+
+    XCTAssertEqualObjects(received, expected);
+    XCTAssertEqual(self.writtenLength, expected.length);
+    XCTAssertGreaterThan(self.writeReportCount, 1);
+
+    [transport close];
+}
+
+#pragma mark - Helpers
+
+/**
+ *  Opens the transport, and accepts its connection.
+ */
+- (void)openTransport:(id<OFFTStompTransportAdapter>)transport {
+    self.openExpectation = [self expectationWithDescription:@"Open"];
+
+    __block int connection = -1;
+    dispatch_semaphore_t accepted = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        connection = accept(self.listener, NULL, NULL);
+        dispatch_semaphore_signal(accepted);
+    });
+
+    [transport open];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    dispatch_semaphore_wait(accepted, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC));
+    XCTAssertGreaterThanOrEqual(connection, 0);
+    self.connection = connection;
+
+    // Reads give up rather than hang a failing test
+    struct timeval timeout = { .tv_sec = 5 };
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+/**
+ *  Reads from the accepted connection until the given number of bytes have arrived.
+ *
+ *  @param pause How long to wait between reads of up to 16KB, in microseconds.
+ *
+ *  @return The bytes read, which are fewer than requested if the connection failed.
+ */
+- (NSData *)readDataOfLength:(NSUInteger)length pause:(useconds_t)pause {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    NSUInteger offset = 0;
+
+    while (offset < length) {
+        ssize_t count = read(self.connection, (uint8_t *)data.mutableBytes + offset, MIN(length - offset, 16 * 1024));
+        if (count <= 0) {
+            break;
+        }
+        offset += count;
+        if (pause > 0) {
+            usleep(pause);
+        }
+    }
+
+    data.length = offset;
+    return data;
+}
+
+/**
+ *  Writes to the accepted connection from a background queue.
+ */
+- (void)writeData:(NSData *)data {
+    int connection = self.connection;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        NSUInteger offset = 0;
+        while (offset < data.length) {
+            ssize_t count = write(connection, (const uint8_t *)data.bytes + offset, data.length - offset);
+            if (count <= 0) {
+                return;
+            }
+            offset += count;
+        }
+    });
+}
+
+- (void)expectFrames:(NSUInteger)count {
+    self.expectedFrameCount = self.frames.count + count;
+    self.framesExpectation = [self expectationWithDescription:@"Frames"];
+}
+
+- (void)expectWrittenLength:(NSUInteger)length {
+    self.expectedWrittenLength = self.writtenLength + length;
+    self.writtenExpectation = [self expectationWithDescription:@"Written"];
+}
+
+#pragma mark - Transport Delegate
+
+- (void)transportDidOpen:(id<OFFTStompTransportAdapter>)transport {
+    [self.openExpectation fulfill];
+}
+
+- (void)transportDidClose:(id<OFFTStompTransportAdapter>)transport {
+}
+
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didReceiveMessage:(NSString *)message {
+    XCTFail(@"Bytes should be received as data");
+}
+
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didReceiveData:(NSData *)data {
+    self.largestReceivedLength = MAX(self.largestReceivedLength, data.length);
+    [self.decoder appendData:data];
+}
+
+- (void)transport:(id<OFFTStompTransportAdapter>)transport didWriteDataOfLength:(NSUInteger)length {
+    self.writtenLength += length;
+    ++self.writeReportCount;
+    if (self.writtenLength == self.expectedWrittenLength) {
+        [self.writtenExpectation fulfill];
+    }
+}
+
+#pragma mark - Frame Decoder Delegate
+
+- (void)frameDecoder:(OFFTStompFrameDecoder *)decoder didDecodeFrame:(OFFTStompFrame *)frame {
+    [self.frames addObject:frame];
+    if (self.frames.count == self.expectedFrameCount) {
+        [self.framesExpectation fulfill];
+    }
+}
+
+@end
@@ -0,0 +1,68 @@
+//
+//  OFFTStompTimingWheelTests.m
+//  StompyTests
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2026 agent. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "OFFTStompTimingWheel.h"
+
+@interface OFFTStompTimingWheelTests : XCTestCase
+
+@property (nonatomic, strong) OFFTStompTimingWheel *wheel;
+
+@end
+
+@implementation OFFTStompTimingWheelTests
+
+- (void)setUp {
+    [super setUp];
+
+    // A small wheel, so timers wait for more than one turn
+    self.wheel = [[OFFTStompTimingWheel alloc] initWithTickInterval:0.01 slotCount:4];
+}
+
+- (void)testTimerRepeats {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Timer"];
+
+    __block NSUInteger fired = 0;
+    __block OFFTStompWheelTimer *timer = [self.wheel scheduleTimerWithInterval:0.05 queue:dispatch_get_main_queue() handler:^{
+        if (++fired == 3) {
+            [timer cancel];
+            [expectation fulfill];
+        }
+    }];
+
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)testTimerFiresNoEarlierThanItsInterval {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Timer"];
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    __block CFAbsoluteTime firedAt = 0;
+    __block OFFTStompWheelTimer *timer = [self.wheel scheduleTimerWithInterval:0.1 queue:dispatch_get_main_queue() handler:^{
+        [timer cancel];
+        firedAt = CFAbsoluteTimeGetCurrent();
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    XCTAssertGreaterThanOrEqual(firedAt - start, 0.09);
+}
+
+- (void)testCancelledTimerDoesNotFire {
+    __block BOOL fired = NO;
+    OFFTStompWheelTimer *timer = [self.wheel scheduleTimerWithInterval:0.02 queue:dispatch_get_main_queue() handler:^{
+        fired = YES;
+    }];
+    [timer cancel];
+
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    XCTAssertFalse(fired);
+}
+
+@end